@@ -0,0 +1,413 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "IoUring.hpp"
+#include <Pothos/Exception.hpp>
+#include <algorithm> //max
+#include <chrono>
+#include <cerrno>
+#include <cstring> //memset/strerror
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#endif
+
+/***********************************************************************
+ * The read/write opcodes and fast poll appeared in the Linux 5.7 headers,
+ * older headers (and other platforms) build the stubs below instead.
+ **********************************************************************/
+#ifdef IORING_FEAT_FAST_POLL
+#define HAS_IO_URING
+#endif
+
+#ifdef HAS_IO_URING
+#include <sys/syscall.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <poll.h>
+#include <ctime>
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#ifndef __NR_io_uring_register
+#define __NR_io_uring_register 427
+#endif
+
+#define IO_URING_CANCEL_DATA ~uint64_t(0) //user data of cancellations, never reported
+
+static int ioUringSetup(const unsigned entries, struct io_uring_params *p)
+{
+    return int(::syscall(__NR_io_uring_setup, entries, p));
+}
+
+static int ioUringEnter(const int fd, const unsigned toSubmit, const unsigned minComplete, const unsigned flags)
+{
+    return int(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+static int ioUringRegister(const int fd, const unsigned opcode, const void *arg, const unsigned numArgs)
+{
+    return int(::syscall(__NR_io_uring_register, fd, opcode, arg, numArgs));
+}
+
+static void *ringPtr(void *base, const unsigned offset)
+{
+    return reinterpret_cast<char *>(base) + offset;
+}
+
+/***********************************************************************
+ * Probe for the ring and the opcodes used by the blocks
+ **********************************************************************/
+bool IoUring::available(void)
+{
+    struct io_uring_params p;
+    std::memset(&p, 0, sizeof(p));
+    const int fd = ioUringSetup(4, &p);
+    if (fd < 0) return false; //ENOSYS, or EPERM when disabled by kernel.io_uring_disabled
+    bool ok = (p.features & IORING_FEAT_FAST_POLL) != 0;
+
+    const unsigned numOps = 256;
+    std::vector<char> probeMem(sizeof(struct io_uring_probe) + numOps*sizeof(struct io_uring_probe_op), 0);
+    auto probe = reinterpret_cast<struct io_uring_probe *>(probeMem.data());
+    if (ok and ioUringRegister(fd, IORING_REGISTER_PROBE, probe, numOps) == 0)
+    {
+        for (const int op : {IORING_OP_READ, IORING_OP_WRITE, IORING_OP_READ_FIXED, IORING_OP_WRITE_FIXED, IORING_OP_RECVMSG, IORING_OP_ASYNC_CANCEL})
+        {
+            if (op > probe->last_op or (probe->ops[op].flags & IO_URING_OP_SUPPORTED) == 0) ok = false;
+        }
+    }
+    else ok = false;
+
+    ::close(fd);
+    return ok;
+}
+
+/***********************************************************************
+ * Ring setup and teardown
+ **********************************************************************/
+IoUring::IoUring(const unsigned entries):
+    _fd(-1),
+    _entries(0),
+    _sqRing(MAP_FAILED),
+    _cqRing(MAP_FAILED),
+    _sqes(MAP_FAILED),
+    _sqRingBytes(0),
+    _cqRingBytes(0),
+    _sqesBytes(0),
+    _sqLocalTail(0),
+    _sqSubmitted(0),
+    _inFlight(0),
+    _fixedAddr(nullptr),
+    _fixedSlotSize(0),
+    _fixedNumSlots(0)
+{
+    struct io_uring_params p;
+    std::memset(&p, 0, sizeof(p));
+    _fd = ioUringSetup(entries, &p);
+    if (_fd < 0) throw Pothos::IOException("IoUring()", "io_uring_setup() failed: " + std::string(strerror(errno)));
+    _entries = p.sq_entries;
+
+    //map the submission and completion rings (one mapping on Linux 5.4 and later)
+    _sqRingBytes = p.sq_off.array + p.sq_entries*sizeof(unsigned);
+    _cqRingBytes = p.cq_off.cqes + p.cq_entries*sizeof(struct io_uring_cqe);
+    const bool singleMap = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap) _sqRingBytes = _cqRingBytes = std::max(_sqRingBytes, _cqRingBytes);
+    _sqRing = ::mmap(nullptr, _sqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQ_RING);
+    _cqRing = (singleMap or _sqRing == MAP_FAILED)?_sqRing:
+        ::mmap(nullptr, _cqRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+    _sqesBytes = p.sq_entries*sizeof(struct io_uring_sqe);
+    _sqes = ::mmap(nullptr, _sqesBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+    if (_sqRing == MAP_FAILED or _cqRing == MAP_FAILED or _sqes == MAP_FAILED)
+    {
+        const std::string error(strerror(errno));
+        this->teardown();
+        throw Pothos::IOException("IoUring()", "mmap() failed: " + error);
+    }
+
+    _sqHead = reinterpret_cast<unsigned *>(ringPtr(_sqRing, p.sq_off.head));
+    _sqTail = reinterpret_cast<unsigned *>(ringPtr(_sqRing, p.sq_off.tail));
+    _sqMask = reinterpret_cast<unsigned *>(ringPtr(_sqRing, p.sq_off.ring_mask));
+    _sqArray = reinterpret_cast<unsigned *>(ringPtr(_sqRing, p.sq_off.array));
+    _cqHead = reinterpret_cast<unsigned *>(ringPtr(_cqRing, p.cq_off.head));
+    _cqTail = reinterpret_cast<unsigned *>(ringPtr(_cqRing, p.cq_off.tail));
+    _cqMask = reinterpret_cast<unsigned *>(ringPtr(_cqRing, p.cq_off.ring_mask));
+    _cqes = ringPtr(_cqRing, p.cq_off.cqes);
+    _sqLocalTail = _sqSubmitted = *_sqTail;
+}
+
+IoUring::~IoUring(void)
+{
+    this->teardown();
+}
+
+void IoUring::teardown(void)
+{
+    if (_sqes != MAP_FAILED) ::munmap(_sqes, _sqesBytes);
+    if (_cqRing != MAP_FAILED and _cqRing != _sqRing) ::munmap(_cqRing, _cqRingBytes);
+    if (_sqRing != MAP_FAILED) ::munmap(_sqRing, _sqRingBytes);
+    if (_fd >= 0) ::close(_fd); //cancels the operations that remain in flight
+    _sqes = _cqRing = _sqRing = MAP_FAILED;
+    _fd = -1;
+}
+
+bool IoUring::registerBuffers(void *addr, const size_t slotSize, const size_t numSlots)
+{
+    std::vector<struct iovec> iovs(numSlots);
+    for (size_t i = 0; i < numSlots; i++)
+    {
+        iovs[i].iov_base = reinterpret_cast<char *>(addr) + i*slotSize;
+        iovs[i].iov_len = slotSize;
+    }
+    if (ioUringRegister(_fd, IORING_REGISTER_BUFFERS, iovs.data(), unsigned(numSlots)) != 0) return false;
+    _fixedAddr = reinterpret_cast<char *>(addr);
+    _fixedSlotSize = slotSize;
+    _fixedNumSlots = numSlots;
+    return true;
+}
+
+/***********************************************************************
+ * Submission queue
+ **********************************************************************/
+void *IoUring::nextSqe(void)
+{
+    const unsigned head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+    if (_sqLocalTail - head >= _entries) return nullptr;
+    const unsigned index = _sqLocalTail & *_sqMask;
+    auto sqe = reinterpret_cast<struct io_uring_sqe *>(_sqes) + index;
+    std::memset(sqe, 0, sizeof(*sqe));
+    _sqArray[index] = index;
+    _sqLocalTail++;
+    return sqe;
+}
+
+bool IoUring::isFixed(const void *buff, const size_t length) const
+{
+    const char *p = reinterpret_cast<const char *>(buff);
+    if (_fixedAddr == nullptr or p < _fixedAddr or p >= _fixedAddr + _fixedSlotSize*_fixedNumSlots) return false;
+    return size_t(p - _fixedAddr)%_fixedSlotSize + length <= _fixedSlotSize;
+}
+
+bool IoUring::prepRead(const int fd, void *buff, const size_t length, const long long offset, const uint64_t userData)
+{
+    auto sqe = reinterpret_cast<struct io_uring_sqe *>(this->nextSqe());
+    if (sqe == nullptr) return false;
+    const bool fixed = this->isFixed(buff, length);
+    sqe->opcode = fixed?IORING_OP_READ_FIXED:IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->off = uint64_t(offset);
+    sqe->addr = uint64_t(reinterpret_cast<uintptr_t>(buff));
+    sqe->len = unsigned(length);
+    if (fixed) sqe->buf_index = uint16_t((reinterpret_cast<const char *>(buff) - _fixedAddr)/_fixedSlotSize);
+    sqe->user_data = userData;
+    _inFlight++;
+    return true;
+}
+
+bool IoUring::prepWrite(const int fd, const void *buff, const size_t length, const long long offset, const uint64_t userData)
+{
+    auto sqe = reinterpret_cast<struct io_uring_sqe *>(this->nextSqe());
+    if (sqe == nullptr) return false;
+    const bool fixed = this->isFixed(buff, length);
+    sqe->opcode = fixed?IORING_OP_WRITE_FIXED:IORING_OP_WRITE;
+    sqe->fd = fd;
+    sqe->off = uint64_t(offset);
+    sqe->addr = uint64_t(reinterpret_cast<uintptr_t>(buff));
+    sqe->len = unsigned(length);
+    if (fixed) sqe->buf_index = uint16_t((reinterpret_cast<const char *>(buff) - _fixedAddr)/_fixedSlotSize);
+    sqe->user_data = userData;
+    _inFlight++;
+    return true;
+}
+
+bool IoUring::prepRecvMsg(const int fd, struct msghdr *msg, const uint64_t userData)
+{
+    auto sqe = reinterpret_cast<struct io_uring_sqe *>(this->nextSqe());
+    if (sqe == nullptr) return false;
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = fd;
+    sqe->addr = uint64_t(reinterpret_cast<uintptr_t>(msg));
+    sqe->len = 1;
+    sqe->user_data = userData;
+    _inFlight++;
+    return true;
+}
+
+bool IoUring::prepCancel(const uint64_t userData)
+{
+    auto sqe = reinterpret_cast<struct io_uring_sqe *>(this->nextSqe());
+    if (sqe == nullptr) return false;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = userData;
+    sqe->user_data = IO_URING_CANCEL_DATA;
+    return true;
+}
+
+size_t IoUring::submit(void)
+{
+    const unsigned toSubmit = _sqLocalTail - _sqSubmitted;
+    if (toSubmit == 0) return 0;
+    __atomic_store_n(_sqTail, _sqLocalTail, __ATOMIC_RELEASE);
+    const int ret = ioUringEnter(_fd, toSubmit, 0, 0);
+    if (ret < 0)
+    {
+        if (errno == EAGAIN or errno == EBUSY or errno == EINTR) return 0; //retried on the next submit
+        throw Pothos::IOException("IoUring::submit()", "io_uring_enter() failed: " + std::string(strerror(errno)));
+    }
+    _sqSubmitted += unsigned(ret);
+    return size_t(ret);
+}
+
+/***********************************************************************
+ * Completion queue
+ **********************************************************************/
+bool IoUring::reap(IoUringCompletion &completion)
+{
+    while (true)
+    {
+        const unsigned head = *_cqHead;
+        if (head == __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE)) return false;
+        const auto cqe = reinterpret_cast<const struct io_uring_cqe *>(_cqes) + (head & *_cqMask);
+        completion.userData = cqe->user_data;
+        completion.result = cqe->res;
+        __atomic_store_n(_cqHead, head+1, __ATOMIC_RELEASE);
+        if (completion.userData == IO_URING_CANCEL_DATA) continue;
+        _inFlight--;
+        return true;
+    }
+}
+
+bool IoUring::wait(const long long timeoutNs)
+{
+    const unsigned head = *_cqHead;
+    if (head != __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE)) return true;
+    if (timeoutNs <= 0) return false;
+
+    struct pollfd pfd;
+    pfd.fd = _fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    struct timespec ts;
+    ts.tv_sec = time_t(timeoutNs/1000000000);
+    ts.tv_nsec = long(timeoutNs%1000000000);
+    return ::ppoll(&pfd, 1, &ts, nullptr) > 0;
+}
+
+#else //HAS_IO_URING
+
+bool IoUring::available(void)
+{
+    return false;
+}
+
+IoUring::IoUring(const unsigned):
+    _fd(-1)
+{
+    throw Pothos::IOException("IoUring()", "io_uring not supported on this platform");
+}
+
+IoUring::~IoUring(void)
+{
+    return;
+}
+
+void IoUring::teardown(void)
+{
+    return;
+}
+
+bool IoUring::registerBuffers(void *, const size_t, const size_t)
+{
+    return false;
+}
+
+bool IoUring::prepRead(const int, void *, const size_t, const long long, const uint64_t)
+{
+    return false;
+}
+
+bool IoUring::prepWrite(const int, const void *, const size_t, const long long, const uint64_t)
+{
+    return false;
+}
+
+bool IoUring::prepRecvMsg(const int, struct msghdr *, const uint64_t)
+{
+    return false;
+}
+
+bool IoUring::prepCancel(const uint64_t)
+{
+    return false;
+}
+
+size_t IoUring::submit(void)
+{
+    return 0;
+}
+
+bool IoUring::reap(IoUringCompletion &)
+{
+    return false;
+}
+
+bool IoUring::wait(const long long)
+{
+    return false;
+}
+
+#endif //HAS_IO_URING
+
+/***********************************************************************
+ * Slots that return to the free list when released downstream
+ **********************************************************************/
+IoUringSlots::IoUringSlots(const size_t slotSize, const size_t numSlots):
+    _state(std::make_shared<State>()),
+    _memory(Pothos::SharedBuffer::make(slotSize*numSlots)),
+    _base(reinterpret_cast<char *>(_memory.getAddress())),
+    _slotSize(slotSize),
+    _numSlots(numSlots)
+{
+    for (size_t i = 0; i < numSlots; i++) _state->freeSlots.push_back(numSlots-i-1);
+}
+
+bool IoUringSlots::acquire(size_t &slot)
+{
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    if (_state->freeSlots.empty()) return false;
+    slot = _state->freeSlots.back();
+    _state->freeSlots.pop_back();
+    return true;
+}
+
+bool IoUringSlots::waitFree(const long long timeoutNs)
+{
+    std::unique_lock<std::mutex> lock(_state->mutex);
+    return _state->cond.wait_for(lock, std::chrono::nanoseconds(timeoutNs), [this]{return not _state->freeSlots.empty();});
+}
+
+Pothos::BufferChunk IoUringSlots::take(const size_t slot, const size_t length)
+{
+    auto state = _state;
+    auto memory = _memory;
+    std::shared_ptr<void> container(this->addr(slot), [state, memory, slot](void *)
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->freeSlots.push_back(slot);
+        state->cond.notify_one();
+    });
+    return Pothos::BufferChunk(Pothos::SharedBuffer(size_t(this->addr(slot)), length, container));
+}
+
+void IoUringSlots::release(const size_t slot)
+{
+    std::lock_guard<std::mutex> lock(_state->mutex);
+    _state->freeSlots.push_back(slot);
+    _state->cond.notify_one();
+}
@@ -0,0 +1,174 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Pothos/Framework/BufferChunk.hpp>
+#include <condition_variable>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+struct msghdr;
+
+//! The result of a completed IoUring operation
+struct IoUringCompletion
+{
+    uint64_t userData;
+    int result; //bytes transferred or a negative errno
+};
+
+/*!
+ * A minimal io_uring submission and completion queue pair.
+ * The ring is driven with the raw system calls, no extra library is required.
+ *
+ * Operations are prepared into the submission queue, and handed to the kernel
+ * with one system call for the entire group. Completions are reaped from the
+ * shared completion queue without system calls, and waiting is a poll() on the ring.
+ * Each block owns a ring, so that work() reaps and re-arms without blocking
+ * and a single scheduler thread can service many devices.
+ *
+ * The engine requires Linux 5.7 (read/write opcodes and fast poll for sockets).
+ * Use available() to check the running kernel; otherwise construction throws.
+ */
+class IoUring
+{
+public:
+    //! Is io_uring supported by the running kernel and not disabled by policy?
+    static bool available(void);
+
+    /*!
+     * Create a ring with the given submission queue depth.
+     * \throws Pothos::IOException when io_uring is not available
+     */
+    IoUring(const unsigned entries);
+
+    ~IoUring(void);
+
+    /*!
+     * Register equally sized buffers with the kernel for fixed reads and writes.
+     * Registration can fail on kernels that charge it to RLIMIT_MEMLOCK,
+     * in which case the slots are used as normal buffers.
+     * \return true when the buffers are registered
+     */
+    bool registerBuffers(void *addr, const size_t slotSize, const size_t numSlots);
+
+    /*!
+     * Prepare a read into buff (using the fixed buffer when it was registered).
+     * An offset of -1 reads from the current file position.
+     * \return false when the submission queue is full
+     */
+    bool prepRead(const int fd, void *buff, const size_t length, const long long offset, const uint64_t userData);
+
+    //! Prepare a write from buff, an offset of -1 writes at the current file position
+    bool prepWrite(const int fd, const void *buff, const size_t length, const long long offset, const uint64_t userData);
+
+    //! Prepare a recvmsg(), the message must remain valid until the completion
+    bool prepRecvMsg(const int fd, struct msghdr *msg, const uint64_t userData);
+
+    //! Prepare a cancellation of the operation with the given user data
+    bool prepCancel(const uint64_t userData);
+
+    //! Submit the prepared operations, return the number accepted by the kernel
+    size_t submit(void);
+
+    //! Pop a completion, false when the completion queue is empty
+    bool reap(IoUringCompletion &completion);
+
+    //! Wait up to timeoutNs for a completion, true when one is ready
+    bool wait(const long long timeoutNs);
+
+    //! The number of submitted or prepared operations without a reaped completion
+    size_t inFlight(void) const
+    {
+        return _inFlight;
+    }
+
+private:
+    void teardown(void);
+    bool isFixed(const void *buff, const size_t length) const;
+    void *nextSqe(void);
+
+    int _fd;
+    unsigned _entries;
+    void *_sqRing;
+    void *_cqRing;
+    void *_sqes;
+    size_t _sqRingBytes;
+    size_t _cqRingBytes;
+    size_t _sqesBytes;
+
+    //pointers into the shared rings
+    unsigned *_sqHead;
+    unsigned *_sqTail;
+    unsigned *_sqMask;
+    unsigned *_sqArray;
+    unsigned *_cqHead;
+    unsigned *_cqTail;
+    unsigned *_cqMask;
+    void *_cqes;
+
+    unsigned _sqLocalTail;
+    unsigned _sqSubmitted;
+    size_t _inFlight;
+
+    //registered fixed buffers
+    char *_fixedAddr;
+    size_t _fixedSlotSize;
+    size_t _fixedNumSlots;
+};
+
+/*!
+ * Equally sized I/O slots in one allocation that can be registered with a ring.
+ * A completed slot is handed downstream as a BufferChunk, and the slot is
+ * returned to the free list when the last copy of that chunk is released,
+ * from any thread. The memory remains valid while any chunk references it.
+ */
+class IoUringSlots
+{
+public:
+    IoUringSlots(const size_t slotSize, const size_t numSlots);
+
+    size_t slotSize(void) const
+    {
+        return _slotSize;
+    }
+
+    size_t numSlots(void) const
+    {
+        return _numSlots;
+    }
+
+    //! The memory of a slot
+    char *addr(const size_t slot) const
+    {
+        return _base + slot*_slotSize;
+    }
+
+    //! Take a free slot, false when all slots are in use
+    bool acquire(size_t &slot);
+
+    //! Wait up to timeoutNs for a slot to be released
+    bool waitFree(const long long timeoutNs);
+
+    //! Reference an acquired slot, the slot is free again when the chunk and its copies are released
+    Pothos::BufferChunk take(const size_t slot, const size_t length);
+
+    //! Return an acquired slot that was not taken
+    void release(const size_t slot);
+
+private:
+    struct State
+    {
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::vector<size_t> freeSlots;
+    };
+    std::shared_ptr<State> _state;
+    Pothos::SharedBuffer _memory;
+    char *_base;
+    size_t _slotSize;
+    size_t _numSlots;
+};
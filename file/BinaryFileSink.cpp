@@ -1,6 +1,7 @@
 // Copyright (c) 2014-2017 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
+#include "IoUring.hpp"
 #include <Pothos/Framework.hpp>
 
 #include <fcntl.h>
@@ -13,6 +14,10 @@
 #endif //_MSC_VER
 #include <stdio.h>
 #include <cerrno>
+#include <cstring> //strerror
+#include <chrono>
+#include <memory>
+#include <vector>
 
 #ifndef O_BINARY
 #define O_BINARY 0
@@ -27,6 +32,8 @@
 
 #include <Poco/Logger.h>
 
+#define IO_URING_WRITE_DEPTH 8 //writes kept outstanding by the io_uring engine
+
 /***********************************************************************
  * |PothosDoc Binary File Sink
  *
@@ -45,10 +52,30 @@
  * |option [Disabled] false
  * |default true
  *
+ * |param ioEngine[IO Engine] The system interface used to write the file.
+ * <ul>
+ * <li>"SYSCALL" - Write each input buffer with a blocking write().</li>
+ * <li>"IO_URING" - Keep up to 8 input buffers in flight as writes with io_uring (Linux 5.7).
+ * Each input buffer is consumed when its write is submitted and held until the write completes.</li>
+ * </ul>
+ * When io_uring is not available, a warning is logged and the system calls are used.
+ * |default "SYSCALL"
+ * |option [System Calls] "SYSCALL"
+ * |option [io_uring] "IO_URING"
+ * |preview valid
+ *
  * |factory /blocks/binary_file_sink()
  * |setter setFilePath(path)
  * |setter setEnabled(enabled)
+ * |setter setIoEngine(ioEngine)
  **********************************************************************/
+struct BinaryFileWrite
+{
+    Pothos::BufferChunk buffer; //held until the write completes
+    long long offset; //-1 for the current position of unseekable files
+    bool busy;
+};
+
 class BinaryFileSink : public Pothos::Block
 {
 public:
@@ -59,11 +86,15 @@ public:
 
     BinaryFileSink(void):
         _fd(-1),
-        _enabled(true)
+        _enabled(true),
+        _ioUring(false),
+        _seekable(true),
+        _writeOffset(0)
     {
         this->setupInput(0);
         this->registerCall(this, POTHOS_FCN_TUPLE(BinaryFileSink, setFilePath));
         this->registerCall(this, POTHOS_FCN_TUPLE(BinaryFileSink, setEnabled));
+        this->registerCall(this, POTHOS_FCN_TUPLE(BinaryFileSink, setIoEngine));
     }
 
     void setFilePath(const std::string &path)
@@ -82,6 +113,13 @@ public:
         _enabled = enabled;
     }
 
+    void setIoEngine(const std::string &engine)
+    {
+        if (engine == "SYSCALL") _ioUring = false;
+        else if (engine == "IO_URING") _ioUring = true;
+        else throw Pothos::InvalidArgumentException("BinaryFileSink::setIoEngine("+engine+")", "unknown engine");
+    }
+
     void activate(void)
     {
         if (_path.empty()) throw Pothos::FileException("BinaryFileSink", "empty file path");
@@ -90,16 +128,32 @@ public:
         {
             poco_error_f4(Poco::Logger::get("BinaryFileSink"), "open(%s) returned %d -- %s(%d)", _path, _fd, std::string(strerror(errno)), errno);
         }
+
+        if (_ioUring and _fd >= 0 and not IoUring::available())
+        {
+            poco_warning(Poco::Logger::get("BinaryFileSink"), "io_uring not available, using system calls");
+        }
+        else if (_ioUring and _fd >= 0)
+        {
+            //pipes and devices write one at a time at the current position
+            _seekable = lseek(_fd, 0, SEEK_CUR) >= 0;
+            _writeOffset = _seekable?0:-1;
+            _ring.reset(new IoUring(IO_URING_WRITE_DEPTH));
+            _writes.assign(_seekable?IO_URING_WRITE_DEPTH:1, BinaryFileWrite());
+        }
     }
 
     void deactivate(void)
     {
+        if (_ring) this->closeRing();
         close(_fd);
         _fd = -1;
     }
 
     void work(void)
     {
+        if (_ring) return this->workRing();
+
         auto in0 = this->input(0);
         if (in0->elements() == 0) return;
         if (!_enabled) in0->consume(in0->elements());
@@ -116,9 +170,94 @@ public:
     }
 
 private:
+
+    /*******************************************************************
+     * io_uring engine: input buffers are consumed when their write
+     * is submitted, and held until the write is reaped here.
+     ******************************************************************/
+    void workRing(void)
+    {
+        this->reapRing();
+
+        auto in0 = this->input(0);
+        bool consumed = false;
+        if (in0->elements() != 0 and not _enabled)
+        {
+            in0->consume(in0->elements());
+            consumed = true;
+        }
+        else if (in0->elements() != 0) for (size_t i = 0; i < _writes.size(); i++)
+        {
+            auto &write = _writes[i];
+            if (write.busy) continue;
+            write.buffer = in0->buffer();
+            write.offset = _writeOffset;
+            if (not _ring->prepWrite(_fd, write.buffer.as<const void *>(), write.buffer.length, write.offset, i)) break;
+            write.busy = true;
+            in0->consume(write.buffer.length);
+            if (_seekable) _writeOffset += write.buffer.length;
+            _ring->submit();
+            consumed = true;
+            break;
+        }
+
+        //keep reaping while writes are outstanding, the held buffers are not returned upstream until then
+        if (_ring->inFlight() == 0) return;
+        if (not consumed) _ring->wait(this->workInfo().maxTimeoutNs);
+        return this->yield();
+    }
+
+    void reapRing(void)
+    {
+        IoUringCompletion completion;
+        while (_ring->reap(completion))
+        {
+            auto &write = _writes[size_t(completion.userData)];
+            if (completion.result < 0)
+            {
+                poco_error_f2(Poco::Logger::get("BinaryFileSink"), "write() returned %s(%d)", std::string(strerror(-completion.result)), -completion.result);
+            }
+
+            //a short write submits the remainder
+            else if (completion.result != 0 and size_t(completion.result) < write.buffer.length)
+            {
+                write.buffer.address += size_t(completion.result);
+                write.buffer.length -= size_t(completion.result);
+                if (write.offset >= 0) write.offset += completion.result;
+                if (_ring->prepWrite(_fd, write.buffer.as<const void *>(), write.buffer.length, write.offset, completion.userData)) continue;
+            }
+            write.busy = false;
+            write.buffer = Pothos::BufferChunk();
+        }
+        _ring->submit();
+    }
+
+    //finish the outstanding writes before the file is closed
+    void closeRing(void)
+    {
+        const auto exitTime = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (_ring->inFlight() != 0 and std::chrono::steady_clock::now() < exitTime)
+        {
+            if (_ring->wait(10000000)) this->reapRing();
+        }
+        if (_ring->inFlight() != 0)
+        {
+            poco_error_f1(Poco::Logger::get("BinaryFileSink"), "%d writes did not complete before close", int(_ring->inFlight()));
+        }
+        _ring.reset();
+        _writes.clear();
+    }
+
     int _fd;
     std::string _path;
     bool _enabled;
+
+    //io_uring engine with the buffers of the outstanding writes
+    bool _ioUring;
+    bool _seekable;
+    long long _writeOffset;
+    std::unique_ptr<IoUring> _ring;
+    std::vector<BinaryFileWrite> _writes;
 };
 
 static Pothos::BlockRegistry registerBinaryFileSink(
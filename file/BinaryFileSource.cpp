@@ -1,6 +1,7 @@
 // Copyright (c) 2014-2016 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
+#include "IoUring.hpp"
 #include <Pothos/Framework.hpp>
 
 #include <fcntl.h>
@@ -13,6 +14,11 @@
 #endif //_MSC_VER
 #include <stdio.h>
 #include <cerrno>
+#include <cstring> //strerror
+#include <algorithm> //max
+#include <chrono>
+#include <memory>
+#include <deque>
 
 #ifndef O_BINARY
 #define O_BINARY 0
@@ -20,6 +26,9 @@
 
 #include <Poco/Logger.h>
 
+#define IO_URING_READ_SLOTS 8 //reads kept outstanding by the io_uring engine
+#define IO_URING_READ_BYTES (64*1024)
+
 /***********************************************************************
  * |PothosDoc Binary File Source
  *
@@ -46,10 +55,31 @@
  * |option [Enabled] true
  * |preview valid
  *
+ * |param ioEngine[IO Engine] The system interface used to read the file.
+ * <ul>
+ * <li>"SYSCALL" - Wait on the file with select() and read() into the output buffer.</li>
+ * <li>"IO_URING" - Keep 8 reads of 64 KiB outstanding in registered buffers with io_uring (Linux 5.7).
+ * Completed reads are reaped in work() and passed downstream in file order without a copy.</li>
+ * </ul>
+ * When io_uring is not available, a warning is logged and the system calls are used.
+ * |default "SYSCALL"
+ * |option [System Calls] "SYSCALL"
+ * |option [io_uring] "IO_URING"
+ * |preview valid
+ *
  * |factory /blocks/binary_file_source(dtype)
  * |setter setFilePath(path)
  * |setter setAutoRewind(rewind)
+ * |setter setIoEngine(ioEngine)
  **********************************************************************/
+struct BinaryFileRead
+{
+    size_t slot;
+    long long offset; //-1 for the current position of unseekable files
+    bool done;
+    int result;
+};
+
 class BinaryFileSource : public Pothos::Block
 {
 public:
@@ -60,11 +90,16 @@ public:
 
     BinaryFileSource(const Pothos::DType &dtype):
         _fd(-1),
-        _rewind(false)
+        _rewind(false),
+        _ioUring(false),
+        _seekable(true),
+        _readOffset(0),
+        _postOffset(0)
     {
         this->setupOutput(0, dtype);
         this->registerCall(this, POTHOS_FCN_TUPLE(BinaryFileSource, setFilePath));
         this->registerCall(this, POTHOS_FCN_TUPLE(BinaryFileSource, setAutoRewind));
+        this->registerCall(this, POTHOS_FCN_TUPLE(BinaryFileSource, setIoEngine));
     }
 
     void setFilePath(const std::string &path)
@@ -83,6 +118,13 @@ public:
         _rewind = rewind;
     }
 
+    void setIoEngine(const std::string &engine)
+    {
+        if (engine == "SYSCALL") _ioUring = false;
+        else if (engine == "IO_URING") _ioUring = true;
+        else throw Pothos::InvalidArgumentException("BinaryFileSource::setIoEngine("+engine+")", "unknown engine");
+    }
+
     void activate(void)
     {
         if (_path.empty()) throw Pothos::FileException("BinaryFileSource", "empty file path");
@@ -91,16 +133,35 @@ public:
         {
             poco_error_f4(Poco::Logger::get("BinaryFileSource"), "open(%s) returned %d -- %s(%d)", _path, _fd, std::string(strerror(errno)), errno);
         }
+
+        if (_ioUring and _fd >= 0 and not IoUring::available())
+        {
+            poco_warning(Poco::Logger::get("BinaryFileSource"), "io_uring not available, using system calls");
+        }
+        else if (_ioUring and _fd >= 0)
+        {
+            //pipes and devices read one at a time from the current position
+            _seekable = lseek(_fd, 0, SEEK_CUR) >= 0;
+            _readOffset = _postOffset = _seekable?0:-1;
+            const size_t elemSize = this->output(0)->dtype().size();
+            _ring.reset(new IoUring(2*IO_URING_READ_SLOTS)); //room to cancel every read
+            _ringSlots.reset(new IoUringSlots(std::max<size_t>(IO_URING_READ_BYTES/elemSize, 1)*elemSize, IO_URING_READ_SLOTS));
+            _ring->registerBuffers(_ringSlots->addr(0), _ringSlots->slotSize(), _ringSlots->numSlots());
+            this->armRing();
+        }
     }
 
     void deactivate(void)
     {
+        if (_ring) this->closeRing();
         close(_fd);
         _fd = -1;
     }
 
     void work(void)
     {
+        if (_ring) return this->workRing();
+
         #ifdef _MSC_VER
         //TODO use windows API to have timeout
         #else
@@ -130,9 +191,123 @@ public:
     }
 
 private:
+
+    /*******************************************************************
+     * io_uring engine: reads stay outstanding in registered slots,
+     * completions are reaped here and posted downstream in file order.
+     ******************************************************************/
+    void workRing(void)
+    {
+        //completions can arrive out of order
+        IoUringCompletion completion;
+        while (_ring->reap(completion))
+        {
+            for (auto &read : _reads)
+            {
+                if (read.slot != completion.userData) continue;
+                read.done = true;
+                read.result = completion.result;
+            }
+        }
+
+        auto out0 = this->output(0);
+        const size_t elemSize = out0->dtype().size();
+        bool posted = false;
+        while (not _reads.empty() and _reads.front().done)
+        {
+            const auto read = _reads.front();
+            _reads.pop_front();
+
+            //the slot returns to the pool when the last reference downstream is released
+            auto chunk = _ringSlots->take(read.slot, size_t(std::max(read.result, 0)));
+            chunk.dtype = out0->dtype();
+            if (read.offset != _postOffset) continue; //issued past the end of file
+            if (read.result < 0)
+            {
+                poco_error_f2(Poco::Logger::get("BinaryFileSource"), "read() returned %s(%d)", std::string(strerror(-read.result)), -read.result);
+                _readOffset = _postOffset; //retry from the failed read
+                continue;
+            }
+
+            //a short read is the end of a file, the following reads are discarded
+            const bool eof = _seekable?(size_t(read.result) < _ringSlots->slotSize()):(read.result == 0);
+            if (_seekable) _postOffset += read.result;
+            if (eof and _seekable) _readOffset = _postOffset = _rewind?0:_postOffset;
+            else if (eof and _rewind) lseek(_fd, 0, SEEK_SET);
+
+            chunk.length = (chunk.length/elemSize)*elemSize;
+            if (chunk.length == 0) continue;
+            out0->postBuffer(chunk);
+            posted = true;
+        }
+
+        this->armRing();
+        if (posted) return;
+
+        //wait on the outstanding reads, or for downstream to release a slot
+        const long long timeoutNs = this->workInfo().maxTimeoutNs;
+        if (_ring->inFlight() == 0) _ringSlots->waitFree(timeoutNs);
+        else _ring->wait(timeoutNs);
+        return this->yield();
+    }
+
+    void armRing(void)
+    {
+        size_t slot = 0;
+        while ((_seekable or _reads.empty()) and _ringSlots->acquire(slot))
+        {
+            if (not _ring->prepRead(_fd, _ringSlots->addr(slot), _ringSlots->slotSize(), _readOffset, slot))
+            {
+                _ringSlots->release(slot);
+                break;
+            }
+            BinaryFileRead read;
+            read.slot = slot;
+            read.offset = _readOffset;
+            read.done = false;
+            read.result = 0;
+            _reads.push_back(read);
+            if (_seekable) _readOffset += _ringSlots->slotSize();
+        }
+        _ring->submit();
+    }
+
+    //cancel the outstanding reads and wait for the kernel to let go of the slots
+    void closeRing(void)
+    {
+        for (const auto &read : _reads)
+        {
+            if (not read.done) _ring->prepCancel(read.slot);
+        }
+        _ring->submit();
+        const auto exitTime = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (_ring->inFlight() != 0 and std::chrono::steady_clock::now() < exitTime)
+        {
+            IoUringCompletion completion;
+            if (_ring->wait(10000000)) while (_ring->reap(completion)) continue;
+        }
+        if (_ring->inFlight() != 0)
+        {
+            poco_warning_f1(Poco::Logger::get("BinaryFileSource"), "%d reads still outstanding after cancel", int(_ring->inFlight()));
+            _ringSlots.release(); //leaked rather than freed under the kernel
+        }
+        _reads.clear();
+        _ring.reset();
+        _ringSlots.reset();
+    }
+
     int _fd;
     std::string _path;
     bool _rewind;
+
+    //io_uring engine with reads in file order
+    bool _ioUring;
+    bool _seekable;
+    long long _readOffset;
+    long long _postOffset;
+    std::unique_ptr<IoUring> _ring;
+    std::unique_ptr<IoUringSlots> _ringSlots;
+    std::deque<BinaryFileRead> _reads;
 };
 
 static Pothos::BlockRegistry registerBinaryFileSource(
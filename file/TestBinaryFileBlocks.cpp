@@ -1,6 +1,7 @@
 // Copyright (c) 2014-2017 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
+#include "IoUring.hpp"
 #include <Pothos/Testing.hpp>
 #include <Pothos/Framework.hpp>
 #include <Pothos/Proxy.hpp>
@@ -10,8 +11,9 @@
 
 using json = nlohmann::json;
 
-POTHOS_TEST_BLOCK("/blocks/tests", test_binary_file_blocks)
+static void binary_file_test_harness(const std::string &ioEngine)
 {
+    std::cout << "binary_file_test_harness: " << ioEngine << std::endl;
     auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", "int");
     auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", "int");
 
@@ -21,9 +23,11 @@ POTHOS_TEST_BLOCK("/blocks/tests", test_binary_file_blocks)
 
     auto fileSource = Pothos::BlockRegistry::make("/blocks/binary_file_source", "int");
     fileSource.call("setFilePath", tempFile.path());
+    fileSource.call("setIoEngine", ioEngine);
 
     auto fileSink = Pothos::BlockRegistry::make("/blocks/binary_file_sink");
     fileSink.call("setFilePath", tempFile.path());
+    fileSink.call("setIoEngine", ioEngine);
 
     //create a test plan
     json testPlan;
@@ -52,3 +56,14 @@ POTHOS_TEST_BLOCK("/blocks/tests", test_binary_file_blocks)
 
     collector.call("verifyTestPlan", expected);
 }
+
+POTHOS_TEST_BLOCK("/blocks/tests", test_binary_file_blocks)
+{
+    binary_file_test_harness("SYSCALL");
+    if (not IoUring::available())
+    {
+        std::cout << "Skipping IO_URING engine test: io_uring not available" << std::endl;
+        return;
+    }
+    binary_file_test_harness("IO_URING");
+}
@@ -0,0 +1,480 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include <Pothos/Testing.hpp>
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Pothos/Util/Network.hpp>
+#include <Poco/Environment.h>
+#include <Poco/Net/DatagramSocket.h>
+#include <iostream>
+#include <fstream>
+#include <algorithm> //sort
+#include <cstring> //memcpy
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <json.hpp>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif //__linux__
+
+using json = nlohmann::json;
+
+/***********************************************************************
+ * The network benchmark:
+ * Stream buffers through the network blocks over loopback,
+ * and report the throughput, system calls per megabyte,
+ * and per-buffer latency of each configuration as JSON.
+ *
+ * The benchmark only runs when POTHOS_BENCH is set in the environment,
+ * so that the self tests do not spend their time on it.
+ * The bytes per run can be set with POTHOS_BENCH_BYTES,
+ * and the report is also written to the file in POTHOS_BENCH_OUTPUT.
+ **********************************************************************/
+#define BENCH_CREDIT_BYTES (1024*1024) //bytes in flight between the source and sink
+#define BENCH_CREDIT_MIN_BUFFERS 2
+#define BENCH_LOSS_TIMEOUT_NS 100000000 //dropped datagrams never return credit
+
+static long long benchNowNs(void)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/***********************************************************************
+ * Count the system calls of this thread and the threads it creates
+ * with the raw_syscalls:sys_enter tracepoint. The count is not available
+ * without tracefs access or when perf events are restricted.
+ **********************************************************************/
+class BenchSyscallCounter
+{
+public:
+    BenchSyscallCounter(void):
+        _fd(-1)
+    {
+        #ifdef __linux__
+        unsigned long long id = 0;
+        for (const auto &path : {
+            "/sys/kernel/tracing/events/raw_syscalls/sys_enter/id",
+            "/sys/kernel/debug/tracing/events/raw_syscalls/sys_enter/id"})
+        {
+            std::ifstream file(path);
+            if (file >> id) break;
+        }
+        if (id == 0) return;
+
+        struct perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_TRACEPOINT;
+        attr.size = sizeof(attr);
+        attr.config = id;
+        attr.inherit = 1; //includes the thread pool created after the counter
+        _fd = int(::syscall(__NR_perf_event_open, &attr, 0/*this thread*/, -1/*any cpu*/, -1, 0));
+        #endif //__linux__
+    }
+
+    ~BenchSyscallCounter(void)
+    {
+        #ifdef __linux__
+        if (_fd >= 0) ::close(_fd);
+        #endif //__linux__
+    }
+
+    //the count, or -1 when not available
+    long long count(void) const
+    {
+        #ifdef __linux__
+        unsigned long long value = 0;
+        if (_fd >= 0 and ::read(_fd, &value, sizeof(value)) == sizeof(value)) return (long long)(value);
+        #endif //__linux__
+        return -1;
+    }
+
+private:
+    int _fd;
+};
+
+/***********************************************************************
+ * The credit shared by the source and the sink of one run:
+ * the sink returns credit for each buffer that arrived, so that
+ * the latency is the time of each buffer through the blocks
+ * rather than the time that it waited in an unbounded queue.
+ **********************************************************************/
+struct BenchCredit
+{
+    BenchCredit(void):
+        recvBuffers(0),
+        lostBuffers(0),
+        lastRecvNs(0)
+    {
+        return;
+    }
+
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::vector<long long> sentNs; //production time of each stream buffer
+    unsigned long long recvBuffers;
+    unsigned long long lostBuffers;
+    long long lastRecvNs;
+};
+
+/***********************************************************************
+ * Produce buffers of a fixed size while the sink has credit.
+ * Packets are stamped with the time of production.
+ * Labels and messages are interleaved at the configured densities.
+ **********************************************************************/
+class BenchSource : public Pothos::Block
+{
+public:
+    BenchSource(BenchCredit &credit, const size_t bufferSize, const unsigned long long totalBytes,
+        const size_t labelsPerBuffer, const size_t buffersPerMessage, const bool packetMode):
+        _credit(credit),
+        _bufferSize(bufferSize),
+        _totalBytes(totalBytes),
+        _labelsPerBuffer(labelsPerBuffer),
+        _buffersPerMessage(buffersPerMessage),
+        _packetMode(packetMode),
+        _creditBuffers(std::max<size_t>(BENCH_CREDIT_BYTES/bufferSize, BENCH_CREDIT_MIN_BUFFERS)),
+        _sentBytes(0),
+        _numBuffers(0)
+    {
+        this->setupOutput(0, "uint8");
+    }
+
+    void activate(void)
+    {
+        _sentBytes = 0;
+        _numBuffers = 0;
+        std::lock_guard<std::mutex> lock(_credit.mutex);
+        _credit.lastRecvNs = benchNowNs();
+    }
+
+    void work(void)
+    {
+        if (_sentBytes >= _totalBytes) return;
+        auto outPort = this->output(0);
+
+        //wait for credit from the sink
+        {
+            std::unique_lock<std::mutex> lock(_credit.mutex);
+            const auto timeout = std::chrono::nanoseconds(this->workInfo().maxTimeoutNs);
+            if (not _credit.cond.wait_for(lock, timeout, [this]{return this->inFlight() < _creditBuffers;}))
+            {
+                //only datagrams are lost, and then the credit is given up on
+                if (not _packetMode or benchNowNs() - _credit.lastRecvNs < BENCH_LOSS_TIMEOUT_NS) return this->yield();
+                _credit.lostBuffers += this->inFlight();
+                _credit.lastRecvNs = benchNowNs();
+            }
+            _credit.sentNs.push_back(benchNowNs());
+        }
+
+        Pothos::BufferChunk buffer("uint8", _bufferSize);
+        std::memset(buffer.as<void *>(), 0, buffer.length);
+        const long long timeNs = benchNowNs();
+        std::memcpy(buffer.as<void *>(), &timeNs, sizeof(timeNs));
+
+        if (_packetMode)
+        {
+            Pothos::Packet packet;
+            packet.payload = buffer;
+            outPort->postMessage(packet);
+        }
+        else
+        {
+            if (_buffersPerMessage != 0 and (_numBuffers % _buffersPerMessage) == 0)
+            {
+                outPort->postMessage(Pothos::Object(_numBuffers));
+            }
+            for (size_t i = 0; i < _labelsPerBuffer; i++)
+            {
+                outPort->postLabel(Pothos::Label("bench", _numBuffers, (i*_bufferSize)/_labelsPerBuffer));
+            }
+            outPort->postBuffer(std::move(buffer));
+        }
+
+        _sentBytes += _bufferSize;
+        _numBuffers++;
+    }
+
+private:
+    BenchCredit &_credit;
+    const size_t _bufferSize;
+    const unsigned long long _totalBytes;
+    const size_t _labelsPerBuffer;
+    const size_t _buffersPerMessage;
+    const bool _packetMode;
+    const unsigned long long _creditBuffers;
+    unsigned long long _sentBytes;
+    unsigned long long _numBuffers;
+
+    //buffers that were neither received nor given up on
+    unsigned long long inFlight(void) const
+    {
+        const auto doneBuffers = _credit.recvBuffers + _credit.lostBuffers;
+        return (_numBuffers > doneBuffers)?(_numBuffers - doneBuffers):0;
+    }
+};
+
+/***********************************************************************
+ * Consume the stream or packets, return credit to the source,
+ * and record the latency of each buffer from production to arrival.
+ * A stream buffer arrives with its last byte, a packet with its stamp.
+ **********************************************************************/
+class BenchSink : public Pothos::Block
+{
+public:
+    BenchSink(BenchCredit &credit, const size_t bufferSize):
+        bytes(0),
+        labels(0),
+        messages(0),
+        firstNs(0),
+        lastNs(0),
+        _credit(credit),
+        _bufferSize(bufferSize)
+    {
+        this->setupInput(0, "uint8");
+    }
+
+    void activate(void)
+    {
+        bytes = 0;
+        labels = 0;
+        messages = 0;
+        firstNs = 0;
+        lastNs = 0;
+        latencies.clear();
+    }
+
+    void work(void)
+    {
+        auto inPort = this->input(0);
+        const long long timeNs = benchNowNs();
+
+        while (inPort->hasMessage())
+        {
+            const auto msg = inPort->popMessage();
+            if (msg.type() != typeid(Pothos::Packet))
+            {
+                messages++;
+                continue;
+            }
+            const auto &payload = msg.extract<Pothos::Packet>().payload;
+            if (payload.length >= sizeof(long long))
+            {
+                long long sentNs = 0;
+                std::memcpy(&sentNs, payload.as<const char *>(), sizeof(sentNs));
+                this->record(timeNs - sentNs, timeNs);
+            }
+            bytes += payload.length;
+            std::lock_guard<std::mutex> lock(_credit.mutex);
+            _credit.recvBuffers++;
+            _credit.lastRecvNs = timeNs;
+            _credit.cond.notify_one();
+        }
+
+        const size_t numBytes = inPort->elements();
+        if (numBytes == 0) return;
+        for (const auto &label : inPort->labels())
+        {
+            if (label.index < numBytes) labels++;
+        }
+        bytes += numBytes;
+        inPort->consume(numBytes);
+
+        //the stream buffers that were completed by these bytes
+        std::lock_guard<std::mutex> lock(_credit.mutex);
+        while ((_credit.recvBuffers+1)*_bufferSize <= bytes)
+        {
+            this->record(timeNs - _credit.sentNs[_credit.recvBuffers], timeNs);
+            _credit.recvBuffers++;
+        }
+        _credit.lastRecvNs = timeNs;
+        _credit.cond.notify_one();
+    }
+
+    unsigned long long bytes;
+    unsigned long long labels;
+    unsigned long long messages;
+    long long firstNs;
+    long long lastNs;
+    std::vector<long long> latencies;
+
+private:
+    BenchCredit &_credit;
+    const size_t _bufferSize;
+
+    void record(const long long latencyNs, const long long timeNs)
+    {
+        if (firstNs == 0) firstNs = timeNs;
+        lastNs = timeNs;
+        latencies.push_back(latencyNs);
+    }
+};
+
+/***********************************************************************
+ * Run one configuration through the tx and rx blocks
+ **********************************************************************/
+static json bench_run(json result, const Pothos::Proxy &tx, const Pothos::Proxy &rx,
+    const size_t bufferSize, const unsigned long long totalBytes,
+    const size_t labelsPerBuffer, const size_t buffersPerMessage, const bool packetMode)
+{
+    BenchCredit credit;
+    auto sourceImpl = new BenchSource(credit, bufferSize, totalBytes, labelsPerBuffer, buffersPerMessage, packetMode);
+    auto sinkImpl = new BenchSink(credit, bufferSize);
+    std::shared_ptr<Pothos::Block> source(sourceImpl);
+    std::shared_ptr<Pothos::Block> sink(sinkImpl);
+
+    const BenchSyscallCounter counter;
+    const long long startNs = benchNowNs();
+    {
+        //the thread pool is created after the counter so that its system calls are included
+        Pothos::ThreadPoolArgs args;
+        Pothos::ThreadPool threadPool(args);
+        source->setThreadPool(threadPool);
+        sink->setThreadPool(threadPool);
+        tx.call("setThreadPool", threadPool);
+        rx.call("setThreadPool", threadPool);
+
+        Pothos::Topology topology;
+        topology.connect(source, 0, tx, 0);
+        topology.connect(rx, 0, sink, 0);
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive(0.1, 60.0));
+    }
+    const long long syscalls = counter.count();
+
+    auto &latencies = sinkImpl->latencies;
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&latencies](const double p)
+    {
+        if (latencies.empty()) return 0.0;
+        return latencies[size_t(p*(latencies.size()-1))]/1e3;
+    };
+    const double elapsed = (sinkImpl->lastNs - startNs)/1e9;
+    const double megabytes = sinkImpl->bytes/1e6;
+
+    result["bufferSize"] = bufferSize;
+    result["creditBytes"] = std::max<size_t>(BENCH_CREDIT_BYTES/bufferSize, BENCH_CREDIT_MIN_BUFFERS)*bufferSize;
+    result["labelsPerBuffer"] = labelsPerBuffer;
+    result["buffersPerMessage"] = buffersPerMessage;
+    result["sentBytes"] = totalBytes;
+    result["recvBytes"] = sinkImpl->bytes;
+    result["labels"] = sinkImpl->labels;
+    result["messages"] = sinkImpl->messages;
+    result["throughputMBps"] = (elapsed > 0.0)?(megabytes/elapsed):0.0;
+    result["syscallsPerMB"] = (syscalls < 0 or megabytes == 0.0)?json(nullptr):json(syscalls/megabytes);
+    result["latencyP50Us"] = percentile(0.50);
+    result["latencyP99Us"] = percentile(0.99);
+    std::cout << result.dump() << std::endl;
+    return result;
+}
+
+static json bench_network(const std::string &scheme, const size_t bufferSize,
+    const unsigned long long totalBytes, const size_t labelsPerBuffer, const size_t buffersPerMessage)
+{
+    auto server_uri = scheme + "://" + Pothos::Util::getWildcardAddr();
+    if (scheme == "unix" or scheme == "shm") server_uri = scheme + "://" + std::string((scheme == "unix")?"@":"") +
+        "pothos-network-bench-" + std::to_string(benchNowNs());
+    auto source = Pothos::BlockRegistry::make("/blocks/network_source", server_uri, "BIND");
+    std::string client_uri = scheme + "://" + Pothos::Util::getLoopbackAddr(source.call("getActualPort"));
+    if (scheme == "unix" or scheme == "shm") client_uri = server_uri;
+    auto sink = Pothos::BlockRegistry::make("/blocks/network_sink", client_uri, "CONNECT");
+
+    json result;
+    result["blocks"] = "network_sink/network_source";
+    result["transport"] = scheme;
+    result = bench_run(result, sink, source, bufferSize, totalBytes, labelsPerBuffer, buffersPerMessage, false);
+
+    //the transport is reliable, everything arrives in order
+    POTHOS_TEST_EQUAL(result["recvBytes"].get<unsigned long long>(), totalBytes);
+    return result;
+}
+
+static json bench_datagram(const size_t packetSize, const size_t batchSize, const unsigned long long totalBytes)
+{
+    //find a free port for the receiver
+    unsigned short port = 0;
+    {
+        Poco::Net::DatagramSocket sock(Poco::Net::SocketAddress("127.0.0.1", 0));
+        port = sock.address().port();
+    }
+    const auto uri = "udp://127.0.0.1:" + std::to_string(port);
+
+    auto rx = Pothos::BlockRegistry::make("/blocks/datagram_io", "uint8");
+    rx.call("setupSocket", uri, "BIND");
+    rx.call("setMode", "PACKET");
+    rx.call("setBatchSize", batchSize);
+    rx.call("setBufferSize", size_t(4*1024*1024), size_t(0));
+    auto tx = Pothos::BlockRegistry::make("/blocks/datagram_io", "uint8");
+    tx.call("setupSocket", uri, "CONNECT");
+    tx.call("setBatchSize", batchSize);
+
+    json result;
+    result["blocks"] = "datagram_io/datagram_io";
+    result["transport"] = "udp";
+    result["batchSize"] = batchSize;
+    result = bench_run(result, tx, rx, packetSize, totalBytes, 0, 0, true);
+
+    //datagrams can be dropped when the receiver falls behind
+    POTHOS_TEST_TRUE(result["recvBytes"].get<unsigned long long>() != 0);
+    return result;
+}
+
+POTHOS_TEST_BLOCK("/blocks/bench", network)
+{
+    if (Poco::Environment::get("POTHOS_BENCH", "").empty())
+    {
+        std::cout << "Skipping network benchmark: set POTHOS_BENCH=1 to run it" << std::endl;
+        return;
+    }
+
+    const unsigned long long totalBytes = std::stoull(Poco::Environment::get("POTHOS_BENCH_BYTES", "8388608"));
+    json report(json::array());
+
+    //the network sink and source over each transport
+    std::vector<std::string> schemes({"tcp", "udp"});
+    #ifndef _MSC_VER
+    schemes.push_back("unix");
+    #endif
+    #ifdef __linux__
+    schemes.push_back("shm");
+    #endif
+    for (const auto &scheme : schemes)
+    {
+        for (const size_t bufferSize : {1024, 16*1024, 256*1024})
+        {
+            report.push_back(bench_network(scheme, bufferSize, totalBytes, 0, 0));
+        }
+    }
+
+    //label densities and message rates over tcp
+    for (const size_t labelsPerBuffer : {1, 16})
+    {
+        report.push_back(bench_network("tcp", 16*1024, totalBytes, labelsPerBuffer, 0));
+    }
+    for (const size_t buffersPerMessage : {1, 16})
+    {
+        report.push_back(bench_network("tcp", 16*1024, totalBytes, 0, buffersPerMessage));
+    }
+
+    //datagram io with and without batching
+    for (const size_t packetSize : {64, 512, 1472})
+    {
+        for (const size_t batchSize : {1, 32})
+        {
+            report.push_back(bench_datagram(packetSize, batchSize, totalBytes/8));
+        }
+    }
+
+    std::cout << report.dump(4) << std::endl;
+    const auto outputPath = Poco::Environment::get("POTHOS_BENCH_OUTPUT", "");
+    if (outputPath.empty()) return;
+    std::ofstream outputFile(outputPath);
+    outputFile << report.dump(4) << std::endl;
+}
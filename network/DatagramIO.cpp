@@ -1,12 +1,64 @@
 // Copyright (c) 2016-2017 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
+#include "IoUring.hpp"
 #include <Pothos/Framework.hpp>
 #include <Poco/URI.h>
 #include <Poco/Logger.h>
 #include <Poco/Net/DatagramSocket.h>
 #include <algorithm> //min/max
+#include <cstring> //memmove
 #include <iostream>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+/***********************************************************************
+ * Batched socket calls:
+ * recvmmsg() and sendmmsg() move multiple datagrams per system call.
+ **********************************************************************/
+#ifdef __linux__
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <cerrno>
+#define HAS_SENDRECV_MMSG
+#endif
+
+/***********************************************************************
+ * UDP segmentation offload (Linux 4.18) and receive offload (Linux 5.0):
+ * one system call moves a super-buffer of many MTU-sized datagrams.
+ **********************************************************************/
+#ifdef HAS_SENDRECV_MMSG
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#endif //HAS_SENDRECV_MMSG
+
+/***********************************************************************
+ * Kernel receive timestamps: SO_TIMESTAMPNS or software SO_TIMESTAMPING
+ **********************************************************************/
+#ifdef HAS_SENDRECV_MMSG
+#include <linux/net_tstamp.h>
+#include <ctime>
+#define RECV_CTRL_SIZE (CMSG_SPACE(sizeof(int)) + CMSG_SPACE(3*sizeof(struct timespec)))
+#endif //HAS_SENDRECV_MMSG
+
+#define UDP_OFFLOAD_MAX_BYTES 65507 //largest UDP payload
+#define UDP_OFFLOAD_MAX_SEGMENTS 64 //kernel limit on segments per send
+
+#define IO_URING_RECV_SLOTS 32 //receives kept outstanding by the io_uring engine
+
+#define MAX_GAP_FILL_DATAGRAMS 1024 //larger gaps are only flagged with a label
+#define REORDER_HOLD_TIMEOUT std::chrono::milliseconds(10) //give up on missing datagrams
+#define DUPLICATE_WINDOW_MIN 64 //late datagrams within this distance are duplicates, not restarts
 
 /***********************************************************************
  * |PothosDoc Datagram IO
@@ -91,12 +143,129 @@
  * |preview valid
  * |default 0
  *
+ * |param batchSize[Batch Size] The maximum number of datagrams per socket call.
+ * When greater than 1, the block receives as many datagrams as fit into the output buffer
+ * and sends multiple queued packets and MTU-sized stream fragments with a single system call.
+ * In the "STREAM" mode, received datagrams are placed back to back in the output buffer.
+ * In the "PACKET" mode, each received datagram is produced as its own packet.
+ * Batching requires recvmmsg()/sendmmsg() support, otherwise the batch size is 1.
+ * |default 1
+ * |tab Advanced
+ * |preview valid
+ *
+ * |param seqOffset[Sequence Offset] The byte offset of the sequence field in each datagram.
+ * |default 0
+ * |units bytes
+ * |tab Sequence
+ * |preview valid
+ *
+ * |param seqWidth[Sequence Width] The width of the big endian sequence field in bytes.
+ * When the width is 0, received datagrams are forwarded without sequence tracking.
+ * Otherwise, the block counts consecutive datagrams by their sequence field,
+ * releases reordered datagrams in order, and accounts for missing datagrams.
+ * A datagram that jumps back by more than the reorder window (at least 64 datagrams)
+ * is taken as a restarted sender: the held datagrams are released and tracking
+ * resumes from the new sequence number.
+ * The counters are available through the "dropped", "reordered", "duplicates", and "restarts" probes.
+ * |default 0
+ * |option [Disabled] 0
+ * |option [8 bits] 1
+ * |option [16 bits] 2
+ * |option [32 bits] 4
+ * |option [64 bits] 8
+ * |tab Sequence
+ * |preview valid
+ *
+ * |param headerSize[Header Size] The number of bytes to remove from the front of each datagram.
+ * Only applies when sequence tracking is enabled, so that the output contains only the payload.
+ * |default 0
+ * |units bytes
+ * |tab Sequence
+ * |preview valid
+ *
+ * |param reorderWindow[Reorder Window] The maximum number of datagrams held while waiting for a missing datagram.
+ * When the window is full, or a missing datagram does not arrive within 10 ms,
+ * the missing datagrams are counted as dropped and the held datagrams are released.
+ * A window of 0 releases every datagram as it arrives.
+ * |default 32
+ * |tab Sequence
+ * |preview valid
+ *
+ * |param gapMode[Gap Mode] How missing datagrams are represented in the "STREAM" mode.
+ * <ul>
+ * <li>"ZEROS" - Fill each missing datagram with zeros of the last datagram size.</li>
+ * <li>"LABEL" - Flag the next element with an "rxGap" label whose value is the number of missing datagrams.</li>
+ * </ul>
+ * Gaps of more than 1024 datagrams are always flagged with a label.
+ * In the "PACKET" mode, missing datagrams are only counted.
+ * |default "ZEROS"
+ * |option [Zeros] "ZEROS"
+ * |option [Label] "LABEL"
+ * |tab Sequence
+ * |preview valid
+ *
+ * |param gso[Segmentation Offload] Send stream fragments as super-buffers with UDP_SEGMENT (GSO).
+ * The kernel or network device splits each super-buffer into MTU-sized datagrams,
+ * so that up to 64 datagrams are sent with one system call.
+ * Packets are still sent as a single datagram of at most MTU bytes.
+ * |default false
+ * |option [Disabled] false
+ * |option [Enabled] true
+ * |tab Advanced
+ * |preview valid
+ *
+ * |param gro[Receive Offload] Receive coalesced datagrams with UDP_GRO.
+ * The kernel delivers consecutive datagrams from the same sender as one large buffer,
+ * which is produced as a contiguous stream in the "STREAM" mode,
+ * and split back into one packet per datagram in the "PACKET" mode.
+ * Offload requires a recent Linux kernel, otherwise a warning is logged and offload stays disabled.
+ * |default false
+ * |option [Disabled] false
+ * |option [Enabled] true
+ * |tab Advanced
+ * |preview valid
+ *
+ * |param timestamps[Timestamps] Attach the kernel receive time to each datagram.
+ * The socket is configured for SO_TIMESTAMPNS, or software SO_TIMESTAMPING as a fallback,
+ * and the time is read from the control messages of each received datagram.
+ * The time is in nanoseconds since the epoch (CLOCK_REALTIME).
+ * In the "STREAM" mode, the time is an "rxTime" label on the first element of the datagram.
+ * In the "PACKET" mode, the time is the "rxTime" entry in the packet metadata.
+ * Coalesced receives (see Receive Offload) carry a single timestamp.
+ * |default false
+ * |option [Disabled] false
+ * |option [Enabled] true
+ * |tab Advanced
+ * |preview valid
+ *
+ * |param ioEngine[IO Engine] The system interface used to receive datagrams.
+ * <ul>
+ * <li>"SYSCALL" - Poll the socket and receive with recv() or recvmmsg() calls.</li>
+ * <li>"IO_URING" - Keep 32 receives outstanding in pre-allocated datagram slots with io_uring (Linux 5.7).
+ * Completed receives are reaped in work() and passed downstream without a copy,
+ * and each slot is re-armed once downstream releases it.</li>
+ * </ul>
+ * When io_uring is not available, a warning is logged and the system calls are used.
+ * |default "SYSCALL"
+ * |option [System Calls] "SYSCALL"
+ * |option [io_uring] "IO_URING"
+ * |tab Advanced
+ * |preview valid
+ *
  * |factory /blocks/datagram_io(dtype)
  * |initializer setupSocket(uri, opt)
  * |setter setMode(mode)
  * |setter setMTU(mtu)
  * |setter setRecvTimeout(recvTimeout)
  * |setter setBufferSize(recvBuffSize, sendBuffSize)
+ * |setter setBatchSize(batchSize)
+ * |setter setOffload(gso, gro)
+ * |setter setTimestamps(timestamps)
+ * |setter setIoEngine(ioEngine)
+ * |setter setSequenceField(seqOffset, seqWidth)
+ * |setter setHeaderSize(headerSize)
+ * |setter setReorderWindow(reorderWindow)
+ * |setter setGapMode(gapMode)
  **********************************************************************/
 class DatagramIO : public Pothos::Block
 {
@@ -110,7 +279,27 @@ public:
         _logger(Poco::Logger::get("DatagramIO")),
         _packetMode(false),
         _timeoutUs(10),
-        _mtu(1472)
+        _mtu(1472),
+        _batchSize(1),
+        _slotSize(1472),
+        _gsoBytes(1472),
+        _gso(false),
+        _gro(false),
+        _timestamps(false),
+        _rxTime(0),
+        _ioUring(false),
+        _seqOffset(0),
+        _seqWidth(0),
+        _headerSize(0),
+        _reorderWindow(32),
+        _gapLabel(false),
+        _seqValid(false),
+        _nextSeq(0),
+        _lastLength(0),
+        _dropped(0),
+        _reordered(0),
+        _duplicates(0),
+        _restarts(0)
     {
         this->setupInput(0);
         this->setupOutput(0, dtype);
@@ -119,6 +308,23 @@ public:
         this->registerCall(this, POTHOS_FCN_TUPLE(DatagramIO, setMTU));
         this->registerCall(this, POTHOS_FCN_TUPLE(DatagramIO, setRecvTimeout));
         this->registerCall(this, POTHOS_FCN_TUPLE(DatagramIO, setBufferSize));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramIO, setBatchSize));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramIO, setOffload));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramIO, setTimestamps));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramIO, setIoEngine));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramIO, setSequenceField));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramIO, setHeaderSize));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramIO, setReorderWindow));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramIO, setGapMode));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramIO, dropped));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramIO, reordered));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramIO, duplicates));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramIO, restarts));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramIO, getActualPort));
+        this->registerProbe("dropped");
+        this->registerProbe("reordered");
+        this->registerProbe("duplicates");
+        this->registerProbe("restarts");
     }
 
     ~DatagramIO(void)
@@ -157,8 +363,8 @@ public:
         if ((mtu % elemSize) != 0) throw Pothos::InvalidArgumentException("DatagramIO::setMTU("+std::to_string(mtu)+")",
             "The MTU is not a multiple of the output data-type size: " + outPort->dtype().toString());
 
-        outPort->setReserve(_mtu/elemSize);
         _mtu = mtu;
+        this->updateOffload();
     }
 
     void setRecvTimeout(const long timeoutUs)
@@ -194,8 +400,159 @@ public:
         }
     }
 
+    void setBatchSize(const size_t batchSize)
+    {
+        if (batchSize == 0) throw Pothos::InvalidArgumentException("DatagramIO::setBatchSize(0)", "batch size must be positive");
+        #ifdef HAS_SENDRECV_MMSG
+        _batchSize = batchSize;
+        _msgs.resize(_batchSize);
+        _iovs.resize(_batchSize);
+        _addrs.resize(_batchSize);
+        _ctrls.resize(_batchSize*RECV_CTRL_SIZE);
+        _sendBuffs.reserve(_batchSize);
+        #else
+        if (batchSize != 1) poco_warning(_logger, "Batched datagram IO not supported on this platform");
+        #endif
+    }
+
+    void setOffload(const bool gso, const bool gro)
+    {
+        #ifdef HAS_SENDRECV_MMSG
+        _gso = gso;
+        _gro = gro;
+        this->setBatchSize(_batchSize); //offload uses the batched socket calls
+        this->updateOffload();
+        #else
+        if (gso or gro) poco_warning(_logger, "UDP segmentation offload not supported on this platform");
+        #endif
+    }
+
+    void setTimestamps(const bool enable)
+    {
+        #ifdef HAS_SENDRECV_MMSG
+        const int fd = _sock.impl()->sockfd();
+        const int nsEnable = enable?1:0;
+        _timestamps = enable;
+        this->setBatchSize(_batchSize); //timestamps use the batched socket calls
+        if (::setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &nsEnable, sizeof(nsEnable)) == 0 or not enable) return;
+
+        //fallback to software receive timestamps
+        const int flags = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+        if (::setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) == 0) return;
+        poco_warning_f1(_logger, "Kernel receive timestamps not available: %s", std::string(strerror(errno)));
+        _timestamps = false;
+        #else
+        if (enable) poco_warning(_logger, "Kernel receive timestamps not supported on this platform");
+        #endif
+    }
+
+    void setIoEngine(const std::string &engine)
+    {
+        if (engine == "SYSCALL") _ioUring = false;
+        else if (engine == "IO_URING") _ioUring = true;
+        else throw Pothos::InvalidArgumentException("DatagramIO::setIoEngine("+engine+")", "unknown engine");
+        #ifndef HAS_SENDRECV_MMSG
+        if (_ioUring) poco_warning(_logger, "io_uring not supported on this platform");
+        _ioUring = false;
+        #endif
+    }
+
+    void setSequenceField(const size_t offset, const size_t width)
+    {
+        if (width != 0 and width != 1 and width != 2 and width != 4 and width != 8)
+        {
+            throw Pothos::InvalidArgumentException("DatagramIO::setSequenceField("+std::to_string(width)+")", "width must be 0, 1, 2, 4, or 8 bytes");
+        }
+        _seqOffset = offset;
+        _seqWidth = width;
+        _seqValid = false;
+    }
+
+    void setHeaderSize(const size_t headerSize)
+    {
+        _headerSize = headerSize;
+    }
+
+    void setReorderWindow(const size_t window)
+    {
+        _reorderWindow = window;
+    }
+
+    void setGapMode(const std::string &mode)
+    {
+        if (mode == "ZEROS") _gapLabel = false;
+        else if (mode == "LABEL") _gapLabel = true;
+        else throw Pothos::InvalidArgumentException("DatagramIO::setGapMode("+mode+")", "unknown gap mode");
+    }
+
+    unsigned long long dropped(void) const
+    {
+        return _dropped;
+    }
+
+    unsigned long long reordered(void) const
+    {
+        return _reordered;
+    }
+
+    unsigned long long duplicates(void) const
+    {
+        return _duplicates;
+    }
+
+    unsigned long long restarts(void) const
+    {
+        return _restarts;
+    }
+
+    std::string getActualPort(void) const
+    {
+        return std::to_string(_sock.address().port());
+    }
+
+    void activate(void)
+    {
+        _seqValid = false;
+        _held.clear();
+
+        #ifdef HAS_SENDRECV_MMSG
+        if (_ioUring and not IoUring::available())
+        {
+            poco_warning(_logger, "io_uring not available, using system calls");
+        }
+        else if (_ioUring)
+        {
+            this->setBatchSize(_batchSize); //sends use the batched socket calls
+            _ring.reset(new IoUring(2*IO_URING_RECV_SLOTS)); //room to cancel every receive
+            _ringSlots.reset(new IoUringSlots(_slotSize, IO_URING_RECV_SLOTS));
+            _ringMsgs.resize(IO_URING_RECV_SLOTS);
+            _ringIovs.resize(IO_URING_RECV_SLOTS);
+            _ringAddrs.resize(IO_URING_RECV_SLOTS);
+            _ringCtrls.resize(IO_URING_RECV_SLOTS*RECV_CTRL_SIZE);
+            _ringPending.assign(IO_URING_RECV_SLOTS, false);
+            this->armRing();
+        }
+        #endif //HAS_SENDRECV_MMSG
+    }
+
+    void deactivate(void)
+    {
+        #ifdef HAS_SENDRECV_MMSG
+        if (_ring) this->closeRing();
+        #endif //HAS_SENDRECV_MMSG
+        _held.clear();
+    }
+
     void work(void)
     {
+        //release held datagrams when the missing datagram did not arrive in time
+        if (not _held.empty() and std::chrono::steady_clock::now() > _holdExpires) this->flushHeld(_held.size());
+
+        #ifdef HAS_SENDRECV_MMSG
+        if (_ring) return this->workRing();
+        if (_batchSize > 1 or _gso or _gro or _timestamps) return this->workBatched();
+        #endif
+
         auto inPort = this->input(0);
         bool hadEvent = false;
 
@@ -255,7 +612,14 @@ public:
                     }
 
                     outBuff.length = ret;
-                    if (_packetMode)
+                    if (_seqWidth != 0)
+                    {
+                        const size_t elemSize = outBuff.dtype.size();
+                        outPort->popElements((outBuff.length+elemSize-1)/elemSize);
+                        _rxTime = 0; //timestamps use the batched receive
+                        this->handleSequenced(outBuff);
+                    }
+                    else if (_packetMode)
                     {
                         Pothos::Packet pkt;
                         pkt.payload = std::move(outBuff);
@@ -286,6 +650,531 @@ public:
 
 private:
 
+    //apply the offload socket options and size the receive slots and send fragments
+    void updateOffload(void)
+    {
+        auto outPort = this->output(0);
+        const size_t elemSize = outPort->dtype().size();
+
+        #ifdef HAS_SENDRECV_MMSG
+        const int fd = _sock.impl()->sockfd();
+        const int segmentSize = _gso?int(_mtu):0;
+        if (::setsockopt(fd, SOL_UDP, UDP_SEGMENT, &segmentSize, sizeof(segmentSize)) != 0 and _gso)
+        {
+            poco_warning_f1(_logger, "UDP segmentation offload not available: %s", std::string(strerror(errno)));
+            _gso = false;
+        }
+        const int groEnable = _gro?1:0;
+        if (::setsockopt(fd, SOL_UDP, UDP_GRO, &groEnable, sizeof(groEnable)) != 0 and _gro)
+        {
+            poco_warning_f1(_logger, "UDP receive offload not available: %s", std::string(strerror(errno)));
+            _gro = false;
+        }
+        #endif //HAS_SENDRECV_MMSG
+
+        //a coalesced receive can hold the largest UDP payload
+        _slotSize = _gro?(((UDP_OFFLOAD_MAX_BYTES+elemSize-1)/elemSize)*elemSize):_mtu;
+        _gsoBytes = _gso?(std::max<size_t>(std::min<size_t>(UDP_OFFLOAD_MAX_SEGMENTS, UDP_OFFLOAD_MAX_BYTES/_mtu), 1)*_mtu):_mtu;
+        outPort->setReserve(_slotSize/elemSize);
+    }
+
+    #ifdef HAS_SENDRECV_MMSG
+    void workBatched(void)
+    {
+        //flush queued packets and stream fragments
+        const bool hadEvent = this->sendBatch();
+
+        //small polling sleep if nothing happened and the socket was drained
+        if (this->recvBatch() == 0 and not hadEvent)
+        {
+            const auto pollTimeUs = std::min<Poco::Timespan::TimeDiff>(_timeoutUs, this->workInfo().maxTimeoutNs/1000);
+            if (_sock.poll(Poco::Timespan(pollTimeUs), Poco::Net::Socket::SELECT_READ)) this->recvBatch();
+        }
+
+        return this->yield(); //always yield to service recv() again
+    }
+
+    void setupMsg(const size_t i, void *buff, const size_t length)
+    {
+        std::memset(&_msgs[i], 0, sizeof(_msgs[i]));
+        _iovs[i].iov_base = buff;
+        _iovs[i].iov_len = length;
+        _msgs[i].msg_hdr.msg_iov = &_iovs[i];
+        _msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    size_t recvBatch(void)
+    {
+        auto outPort = this->output(0);
+        auto outBuff = outPort->buffer();
+        const size_t elemSize = outBuff.dtype.size();
+
+        //one slot per datagram (or coalesced datagrams), limited by the available output buffer
+        const size_t numSlots = std::min(_batchSize, outBuff.length/_slotSize);
+        if (numSlots == 0) return 0;
+        const size_t ctrlSize = RECV_CTRL_SIZE;
+        for (size_t i = 0; i < numSlots; i++)
+        {
+            this->setupMsg(i, outBuff.as<char *>() + i*_slotSize, _slotSize);
+            _msgs[i].msg_hdr.msg_name = &_addrs[i];
+            _msgs[i].msg_hdr.msg_namelen = sizeof(_addrs[i]);
+            if (not _gro and not _timestamps) continue;
+            _msgs[i].msg_hdr.msg_control = _ctrls.data() + i*ctrlSize;
+            _msgs[i].msg_hdr.msg_controllen = ctrlSize;
+        }
+
+        const int ret = ::recvmmsg(_sock.impl()->sockfd(), _msgs.data(), numSlots, MSG_DONTWAIT, nullptr);
+        if (ret < 0)
+        {
+            if (errno != EAGAIN and errno != EWOULDBLOCK)
+            {
+                poco_error_f2(_logger, "Socket recvmmsg %d datagrams failed: %s", int(numSlots), std::string(strerror(errno)));
+            }
+            return 0;
+        }
+        if (ret == 0) return 0;
+
+        size_t bytesOut = 0;
+        for (int i = 0; i < ret; i++)
+        {
+            const size_t slot = i*_slotSize;
+            const size_t length = _msgs[i].msg_len;
+            if ((_msgs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0)
+            {
+                poco_warning_f1(_logger, "Received datagram truncated to the MTU of %d bytes", int(_slotSize));
+            }
+
+            //the kernel receive time applies to every datagram in the slot
+            _rxTime = this->rxTimestamp(_msgs[i].msg_hdr);
+
+            //split coalesced receives back into the datagrams on the wire
+            const size_t segmentSize = this->groSegmentSize(_msgs[i].msg_hdr, length);
+            for (size_t offset = 0; offset < length; offset += segmentSize)
+            {
+                size_t segmentLength = std::min(segmentSize, length-offset);
+                if ((segmentLength % elemSize) != 0)
+                {
+                    poco_warning_f2(_logger,
+                        "Received %d bytes is not a multiple of the output size: %s.\n"
+                        "Until the sender is fixed, expect possible truncation of data.",
+                        int(segmentLength), outBuff.dtype.toString());
+                }
+
+                //each datagram references its slot and passes through the reorder window
+                if (_seqWidth != 0)
+                {
+                    Pothos::BufferChunk datagram(outBuff);
+                    datagram.address += slot+offset;
+                    datagram.length = segmentLength;
+                    this->handleSequenced(datagram);
+                    bytesOut = slot + offset + ((segmentLength+elemSize-1)/elemSize)*elemSize;
+                }
+
+                //each datagram becomes a packet that references its slot
+                else if (_packetMode)
+                {
+                    Pothos::Packet pkt;
+                    pkt.payload = outBuff;
+                    pkt.payload.address += slot+offset;
+                    pkt.payload.length = segmentLength;
+                    if (_rxTime != 0) pkt.metadata["rxTime"] = Pothos::Object(_rxTime);
+                    outPort->postMessage(std::move(pkt));
+                    bytesOut = slot + offset + ((segmentLength+elemSize-1)/elemSize)*elemSize;
+                }
+
+                //compact the datagrams back to back in the stream
+                else
+                {
+                    segmentLength = (segmentLength/elemSize)*elemSize;
+                    if (_rxTime != 0 and offset == 0 and segmentLength != 0)
+                    {
+                        outPort->postLabel(Pothos::Label("rxTime", Pothos::Object(_rxTime), bytesOut/elemSize));
+                    }
+                    if (bytesOut != slot+offset) std::memmove(outBuff.as<char *>() + bytesOut, outBuff.as<const char *>() + slot + offset, segmentLength);
+                    bytesOut += segmentLength;
+                }
+            }
+        }
+
+        if (_packetMode or _seqWidth != 0) outPort->popElements(bytesOut/elemSize);
+        else outPort->produce(bytesOut/elemSize);
+
+        //the new send-to address for bound sockets
+        if (not _socketConnected) _sendAddr = Poco::Net::SocketAddress(
+            reinterpret_cast<const struct sockaddr *>(&_addrs[ret-1]), _msgs[ret-1].msg_hdr.msg_namelen);
+
+        return size_t(ret);
+    }
+
+    //the kernel receive time in nanoseconds, or 0 when not available
+    long long rxTimestamp(const struct msghdr &hdr)
+    {
+        if (not _timestamps) return 0;
+        for (auto cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(const_cast<struct msghdr *>(&hdr), cmsg))
+        {
+            if (cmsg->cmsg_level != SOL_SOCKET) continue;
+            if (cmsg->cmsg_type != SCM_TIMESTAMPNS and cmsg->cmsg_type != SCM_TIMESTAMPING) continue;
+            struct timespec ts; //software time is the first entry of SCM_TIMESTAMPING
+            std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+            return (long long)(ts.tv_sec)*1000000000 + ts.tv_nsec;
+        }
+        return 0;
+    }
+
+    //the size of the datagrams in a coalesced receive, or the entire length
+    size_t groSegmentSize(const struct msghdr &hdr, const size_t length)
+    {
+        if (not _gro) return std::max<size_t>(length, 1);
+        for (auto cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(const_cast<struct msghdr *>(&hdr), cmsg))
+        {
+            if (cmsg->cmsg_level != SOL_UDP or cmsg->cmsg_type != UDP_GRO) continue;
+            int segmentSize = 0;
+            std::memcpy(&segmentSize, CMSG_DATA(cmsg), sizeof(segmentSize));
+            if (segmentSize > 0) return size_t(segmentSize);
+        }
+        return std::max<size_t>(length, 1);
+    }
+
+    bool sendBatch(void)
+    {
+        auto inPort = this->input(0);
+
+        //gather queued packets, truncated to the MTU size
+        _sendBuffs.clear();
+        while (_sendBuffs.size() < _batchSize and inPort->hasMessage())
+        {
+            const auto msg = inPort->popMessage();
+            if (msg.type() != typeid(Pothos::Packet))
+            {
+                poco_error_f1(_logger, "Dropped input message of type %s; only Pothos::Packet supported", msg.getTypeString());
+                continue;
+            }
+            _sendBuffs.push_back(msg.extract<Pothos::Packet>().payload);
+            _sendBuffs.back().length = std::min(_sendBuffs.back().length, _mtu);
+        }
+
+        //fragment the input stream into MTU-sized datagrams (or super-buffers with GSO)
+        const auto &inBuff = inPort->buffer();
+        const size_t elemSize = inBuff.dtype.size();
+        size_t bytesConsumed = 0;
+        while (_sendBuffs.size() < _batchSize)
+        {
+            Pothos::BufferChunk fragment(inBuff);
+            fragment.address += bytesConsumed;
+            fragment.length = std::min(inBuff.length-bytesConsumed, _gsoBytes);
+            fragment.length = (fragment.length/elemSize)*elemSize;
+            if (fragment.length == 0) break;
+            bytesConsumed += fragment.length;
+            _sendBuffs.push_back(std::move(fragment));
+        }
+        if (bytesConsumed != 0) inPort->consume(bytesConsumed);
+
+        if (_sendBuffs.empty()) return false;
+        if (not _socketConnected and _sendAddr == Poco::Net::SocketAddress())
+        {
+            poco_error(_logger, "A bound socket cannot send until it has received!");
+            return true;
+        }
+
+        //send the entire batch with a single call
+        for (size_t i = 0; i < _sendBuffs.size(); i++)
+        {
+            this->setupMsg(i, _sendBuffs[i].as<void *>(), _sendBuffs[i].length);
+            if (_socketConnected) continue;
+            _msgs[i].msg_hdr.msg_name = const_cast<struct sockaddr *>(_sendAddr.addr());
+            _msgs[i].msg_hdr.msg_namelen = _sendAddr.length();
+        }
+
+        size_t numSent = 0;
+        while (numSent < _sendBuffs.size())
+        {
+            const int ret = ::sendmmsg(_sock.impl()->sockfd(), _msgs.data()+numSent, _sendBuffs.size()-numSent, 0);
+            if (ret <= 0)
+            {
+                poco_error_f2(_logger, "Socket sendmmsg %d datagrams failed: %s",
+                    int(_sendBuffs.size()-numSent), std::string(strerror(errno)));
+                break;
+            }
+            numSent += size_t(ret);
+        }
+        return true;
+    }
+
+    /*******************************************************************
+     * io_uring engine: receives stay outstanding in datagram slots,
+     * completions are reaped here and passed downstream without a copy.
+     ******************************************************************/
+    void workRing(void)
+    {
+        const bool hadEvent = this->sendBatch();
+
+        //reap the completed receives, then re-arm the released slots
+        const size_t numRecv = this->reapRing();
+        this->armRing();
+
+        //small polling sleep if nothing happened
+        if (numRecv == 0 and not hadEvent)
+        {
+            const auto timeoutNs = std::min<long long>(_timeoutUs*1000, this->workInfo().maxTimeoutNs);
+            if (_ring->inFlight() == 0) _ringSlots->waitFree(timeoutNs); //downstream holds every slot
+            else if (_ring->wait(timeoutNs)) this->reapRing();
+            this->armRing();
+        }
+
+        return this->yield(); //always yield to reap again
+    }
+
+    void armRing(void)
+    {
+        const int fd = _sock.impl()->sockfd();
+        size_t slot = 0;
+        while (_ringSlots->acquire(slot))
+        {
+            std::memset(&_ringMsgs[slot], 0, sizeof(_ringMsgs[slot]));
+            _ringIovs[slot].iov_base = _ringSlots->addr(slot);
+            _ringIovs[slot].iov_len = _ringSlots->slotSize();
+            _ringMsgs[slot].msg_iov = &_ringIovs[slot];
+            _ringMsgs[slot].msg_iovlen = 1;
+            _ringMsgs[slot].msg_name = &_ringAddrs[slot];
+            _ringMsgs[slot].msg_namelen = sizeof(_ringAddrs[slot]);
+            _ringMsgs[slot].msg_control = _ringCtrls.data() + slot*RECV_CTRL_SIZE;
+            _ringMsgs[slot].msg_controllen = RECV_CTRL_SIZE;
+            if (not _ring->prepRecvMsg(fd, &_ringMsgs[slot], slot))
+            {
+                _ringSlots->release(slot);
+                break;
+            }
+            _ringPending[slot] = true;
+        }
+        _ring->submit();
+    }
+
+    size_t reapRing(void)
+    {
+        auto outPort = this->output(0);
+        const size_t elemSize = outPort->dtype().size();
+        size_t numRecv = 0;
+        IoUringCompletion completion;
+        while (_ring->reap(completion))
+        {
+            //the slot returns to the pool when the last reference downstream is released
+            const size_t slot = size_t(completion.userData);
+            _ringPending[slot] = false;
+            auto chunk = _ringSlots->take(slot, _ringSlots->slotSize());
+            chunk.dtype = outPort->dtype();
+            if (completion.result < 0)
+            {
+                if (completion.result != -ECANCELED)
+                {
+                    poco_error_f1(_logger, "Socket recvmsg failed: %s", std::string(strerror(-completion.result)));
+                }
+                continue;
+            }
+
+            const auto &hdr = _ringMsgs[slot];
+            const size_t length = size_t(completion.result);
+            if ((hdr.msg_flags & MSG_TRUNC) != 0)
+            {
+                poco_warning_f1(_logger, "Received datagram truncated to the MTU of %d bytes", int(_slotSize));
+            }
+            const size_t segmentSize = this->groSegmentSize(hdr, length);
+            if ((segmentSize % elemSize) != 0 or (length % elemSize) != 0)
+            {
+                poco_warning_f2(_logger,
+                    "Received %d bytes is not a multiple of the output size: %s.\n"
+                    "Until the sender is fixed, expect possible truncation of data.",
+                    int(segmentSize), outPort->dtype().toString());
+            }
+            _rxTime = this->rxTimestamp(hdr);
+
+            //coalesced datagrams are already contiguous in the stream
+            if (_seqWidth == 0 and not _packetMode)
+            {
+                chunk.length = (length/elemSize)*elemSize;
+                this->release(chunk, _rxTime);
+            }
+
+            //otherwise each datagram on the wire references the slot
+            else for (size_t offset = 0; offset < length; offset += segmentSize)
+            {
+                Pothos::BufferChunk datagram(chunk);
+                datagram.address += offset;
+                datagram.length = std::min(segmentSize, length-offset);
+                if (_seqWidth != 0) this->handleSequenced(datagram);
+                else this->release(datagram, _rxTime);
+            }
+
+            //the new send-to address for bound sockets
+            if (not _socketConnected) _sendAddr = Poco::Net::SocketAddress(
+                reinterpret_cast<const struct sockaddr *>(&_ringAddrs[slot]), hdr.msg_namelen);
+            numRecv++;
+        }
+        return numRecv;
+    }
+
+    //cancel the outstanding receives and wait for the kernel to let go of the slots
+    void closeRing(void)
+    {
+        for (size_t slot = 0; slot < _ringPending.size(); slot++)
+        {
+            if (_ringPending[slot]) _ring->prepCancel(slot);
+        }
+        _ring->submit();
+        const auto exitTime = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (_ring->inFlight() != 0 and std::chrono::steady_clock::now() < exitTime)
+        {
+            IoUringCompletion completion;
+            if (_ring->wait(10000000)) while (_ring->reap(completion)) _ringPending[size_t(completion.userData)] = false;
+        }
+        if (_ring->inFlight() != 0)
+        {
+            poco_warning_f1(_logger, "%d receives still outstanding after cancel", int(_ring->inFlight()));
+            _ringSlots.release(); //leaked rather than freed under the kernel
+        }
+        _ring.reset();
+        _ringSlots.reset();
+    }
+    #endif //HAS_SENDRECV_MMSG
+
+    /*******************************************************************
+     * Sequence tracking: datagrams are held in a bounded window
+     * until they can be released in sequence order.
+     ******************************************************************/
+    void handleSequenced(const Pothos::BufferChunk &datagram)
+    {
+        if (datagram.length < _seqOffset+_seqWidth)
+        {
+            poco_warning_f1(_logger, "Dropped %d byte datagram without a sequence field", int(datagram.length));
+            return;
+        }
+
+        //extract the big endian sequence number
+        const auto p = datagram.as<const uint8_t *>() + _seqOffset;
+        uint64_t seq = 0;
+        for (size_t i = 0; i < _seqWidth; i++) seq = (seq << 8) | p[i];
+
+        //remove the header so that the output only contains the payload
+        Pothos::BufferChunk payload(datagram);
+        payload.address += std::min(_headerSize, datagram.length);
+        payload.length -= std::min(_headerSize, datagram.length);
+
+        if (not _seqValid)
+        {
+            _seqValid = true;
+            _nextSeq = seq;
+        }
+
+        //the sequence distance modulo the field width, negative values are in the past
+        const uint64_t mask = (_seqWidth == 8)? ~uint64_t(0) : ((uint64_t(1) << (8*_seqWidth))-1);
+        const uint64_t distance = (seq - _nextSeq) & mask;
+        if (distance > mask/2)
+        {
+            //a late datagram was already released or given up on,
+            //but a jump back past the reorder window means that the sender restarted
+            const uint64_t backward = (_nextSeq - seq) & mask;
+            if (backward <= std::max<uint64_t>(_reorderWindow, DUPLICATE_WINDOW_MIN))
+            {
+                _duplicates++;
+                return;
+            }
+            this->flushHeld(_held.size());
+            _restarts++;
+            _nextSeq = seq;
+            return this->handleSequenced(datagram);
+        }
+
+        if (distance == 0)
+        {
+            if (not _held.empty()) _reordered++; //arrived after its successors
+            this->release(payload, _rxTime);
+            _nextSeq++;
+            this->releaseHeld();
+            return;
+        }
+
+        //a large jump forward means that many datagrams were lost
+        if (distance > MAX_GAP_FILL_DATAGRAMS)
+        {
+            this->flushHeld(_held.size());
+            const uint64_t missing = (seq - _nextSeq) & mask;
+            if (missing > mask/2) return; //released while flushing
+            this->gap(missing);
+            _nextSeq += missing;
+            return this->handleSequenced(datagram);
+        }
+
+        //hold datagrams that arrived ahead of a missing datagram,
+        //the held datagrams are keyed by the unwrapped sequence number
+        if (not _held.emplace(_nextSeq+distance, std::make_pair(payload, _rxTime)).second)
+        {
+            _duplicates++;
+            return;
+        }
+        if (_held.size() == 1) _holdExpires = std::chrono::steady_clock::now() + REORDER_HOLD_TIMEOUT;
+        if (_held.size() > _reorderWindow) this->flushHeld(_held.size()-_reorderWindow);
+    }
+
+    //give up on missing datagrams until numDatagrams held datagrams have been released
+    void flushHeld(size_t numDatagrams)
+    {
+        while (numDatagrams != 0 and not _held.empty())
+        {
+            this->gap(_held.begin()->first - _nextSeq);
+            _nextSeq = _held.begin()->first;
+            numDatagrams -= std::min(numDatagrams, this->releaseHeld());
+        }
+    }
+
+    //release consecutive held datagrams, return the number released
+    size_t releaseHeld(void)
+    {
+        size_t numReleased = 0;
+        while (not _held.empty() and _held.begin()->first == _nextSeq)
+        {
+            this->release(_held.begin()->second.first, _held.begin()->second.second);
+            _held.erase(_held.begin());
+            _nextSeq++;
+            numReleased++;
+        }
+        if (not _held.empty()) _holdExpires = std::chrono::steady_clock::now() + REORDER_HOLD_TIMEOUT;
+        return numReleased;
+    }
+
+    void release(const Pothos::BufferChunk &payload, const long long rxTime)
+    {
+        auto outPort = this->output(0);
+        _lastLength = payload.length;
+        if (payload.length == 0) return;
+        if (_packetMode)
+        {
+            Pothos::Packet pkt;
+            pkt.payload = payload;
+            if (rxTime != 0) pkt.metadata["rxTime"] = Pothos::Object(rxTime);
+            outPort->postMessage(std::move(pkt));
+            return;
+        }
+        if (rxTime != 0) outPort->postLabel(Pothos::Label("rxTime", Pothos::Object(rxTime), 0));
+        outPort->postBuffer(payload);
+    }
+
+    void gap(const uint64_t numMissing)
+    {
+        if (numMissing == 0) return;
+        _dropped += numMissing;
+        if (_packetMode) return;
+
+        auto outPort = this->output(0);
+        const size_t elemSize = outPort->dtype().size();
+        if (_gapLabel or numMissing > MAX_GAP_FILL_DATAGRAMS or _lastLength < elemSize)
+        {
+            outPort->postLabel(Pothos::Label("rxGap", Pothos::Object(numMissing), 0));
+            return;
+        }
+        Pothos::BufferChunk zeros(outPort->dtype(), size_t(numMissing)*(_lastLength/elemSize));
+        std::memset(zeros.as<void *>(), 0, zeros.length);
+        outPort->postBuffer(std::move(zeros));
+    }
+
     void sendBuffer(const Pothos::BufferChunk &buff)
     {
         try
@@ -317,6 +1206,54 @@ private:
     bool _packetMode;
     long _timeoutUs;
     size_t _mtu;
+    size_t _batchSize;
+
+    //segmentation offload
+    size_t _slotSize;
+    size_t _gsoBytes;
+    bool _gso;
+    bool _gro;
+
+    //kernel receive time of the datagrams being handled
+    bool _timestamps;
+    long long _rxTime;
+
+    #ifdef HAS_SENDRECV_MMSG
+    //scratch space for batched socket calls
+    std::vector<struct mmsghdr> _msgs;
+    std::vector<struct iovec> _iovs;
+    std::vector<struct sockaddr_storage> _addrs;
+    std::vector<char> _ctrls;
+    std::vector<Pothos::BufferChunk> _sendBuffs;
+    #endif
+
+    //io_uring engine with one message per datagram slot
+    bool _ioUring;
+    #ifdef HAS_SENDRECV_MMSG
+    std::unique_ptr<IoUring> _ring;
+    std::unique_ptr<IoUringSlots> _ringSlots;
+    std::vector<struct msghdr> _ringMsgs;
+    std::vector<struct iovec> _ringIovs;
+    std::vector<struct sockaddr_storage> _ringAddrs;
+    std::vector<char> _ringCtrls;
+    std::vector<bool> _ringPending;
+    #endif
+
+    //sequence tracking and reorder window
+    size_t _seqOffset;
+    size_t _seqWidth;
+    size_t _headerSize;
+    size_t _reorderWindow;
+    bool _gapLabel;
+    bool _seqValid;
+    uint64_t _nextSeq;
+    size_t _lastLength;
+    std::map<uint64_t, std::pair<Pothos::BufferChunk, long long>> _held; //payload and receive time
+    std::chrono::steady_clock::time_point _holdExpires;
+    unsigned long long _dropped;
+    unsigned long long _reordered;
+    unsigned long long _duplicates;
+    unsigned long long _restarts;
 
     //bound sockets only send to the last received address
     bool _socketConnected;
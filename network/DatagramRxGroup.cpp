@@ -0,0 +1,445 @@
+// Copyright (c) 2016-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "SpscQueue.hpp"
+#include "IoUring.hpp" //IoUringSlots
+#include <Pothos/Framework.hpp>
+#include <Poco/URI.h>
+#include <Poco/Logger.h>
+#include <Poco/Net/DatagramSocket.h>
+#include <algorithm> //min/max
+#include <cstring> //memmove
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/***********************************************************************
+ * Linux specific: batched receive, CPU affinity, and incoming CPU hints.
+ **********************************************************************/
+#ifdef __linux__
+#include <sys/socket.h>
+#include <pthread.h>
+#include <sched.h>
+#include <cerrno>
+#define HAS_SENDRECV_MMSG
+#define HAS_CPU_AFFINITY
+#ifndef SO_INCOMING_CPU
+#define SO_INCOMING_CPU 49
+#endif
+#endif
+
+#define RX_GROUP_QUEUE_DEPTH 256 //received batches held per socket
+#define RX_GROUP_NUM_SLOTS 32 //recycled batch buffers per socket
+#define RX_GROUP_SLOT_WAIT_NS 100000000 //wait for downstream to release a batch buffer
+
+/***********************************************************************
+ * |PothosDoc Datagram RX Group
+ *
+ * The datagram RX group binds several UDP sockets to the same address
+ * with SO_REUSEPORT, so that the kernel spreads incoming datagrams
+ * from different senders across the sockets.
+ * Each socket is serviced by its own receive thread,
+ * so that ingest of many senders scales with the number of cores.
+ *
+ * <h2>Fanout</h2>
+ *
+ * In the "PARALLEL" fanout, each socket produces on its own output port,
+ * so that downstream processing can also run in parallel.
+ * In the "MERGE" fanout, the datagrams from all sockets are produced on output port 0.
+ * The kernel always steers a given sender to the same socket,
+ * so the datagrams of each sender keep their order in both fanouts.
+ *
+ * Each receive thread cycles through a fixed set of batch buffers.
+ * When downstream still holds every buffer, the thread waits
+ * and the socket receive buffer absorbs the incoming datagrams.
+ *
+ * <h2>CPU pinning</h2>
+ *
+ * When a list of CPUs is specified, receive thread i is pinned to CPU[i],
+ * and socket i prefers datagrams that the kernel processed on that CPU (SO_INCOMING_CPU).
+ * Match the CPU list with the RX queue interrupt affinity of the network device
+ * so that each RX queue is serviced by one socket on the same core.
+ *
+ * |category /Network
+ * |keywords udp datagram packet network reuseport
+ *
+ * |param dtype[Data Type] The output data type.
+ * Sets the data type of the output ports and also of the buffer in packet mode.
+ * |widget DTypeChooser(float=1,cfloat=1,int=1,cint=1,uint=1,cuint=1,dim=1)
+ * |default "complex_float32"
+ * |preview disable
+ *
+ * |param numSockets[Num Sockets] The number of sockets bound to the address.
+ * |default 4
+ * |widget SpinBox(minimum=1)
+ * |preview disable
+ *
+ * |param fanout[Fanout] Produce each socket on its own port or merge onto port 0.
+ * |option [Parallel] "PARALLEL"
+ * |option [Merge] "MERGE"
+ * |default "PARALLEL"
+ * |preview disable
+ *
+ * |param uri[URI] The bind uri string.
+ * |default "udp://0.0.0.0:1234"
+ * |widget StringEntry()
+ *
+ * |param mode[Mode] The output mode (stream or packets).
+ * <ul>
+ * <li>"STREAM" - Produce the received datagrams as a sample stream.</li>
+ * <li>"PACKET" - Preserve the datagram boundaries and produce Pothos::Packet.</li>
+ * </ul>
+ * |default "STREAM"
+ * |option [Stream] "STREAM"
+ * |option [Packet] "PACKET"
+ *
+ * |param mtu[MTU] The maximum size of a datagram payload in bytes.
+ * |default 1472
+ * |units bytes
+ *
+ * |param batchSize[Batch Size] The maximum number of datagrams per socket call.
+ * |default 32
+ * |tab Advanced
+ * |preview valid
+ *
+ * |param cpus[CPUs] A list of CPU numbers to pin the receive threads to.
+ * An empty list leaves the threads unpinned.
+ * |default []
+ * |tab Advanced
+ * |preview valid
+ *
+ * |param recvBuffSize[Receive Buffer] The size of the receive buffer of each socket.
+ * Set the size of the receive socket buffer (0 for default).
+ * |units bytes
+ * |tab Advanced
+ * |preview valid
+ * |default 0
+ *
+ * |factory /blocks/datagram_rx_group(dtype, numSockets, fanout)
+ * |initializer setupSocket(uri)
+ * |setter setMode(mode)
+ * |setter setMTU(mtu)
+ * |setter setBatchSize(batchSize)
+ * |setter setCpus(cpus)
+ * |setter setBufferSize(recvBuffSize)
+ **********************************************************************/
+class DatagramRxGroup : public Pothos::Block
+{
+public:
+    static Block *make(const Pothos::DType &dtype, const size_t numSockets, const std::string &fanout)
+    {
+        return new DatagramRxGroup(dtype, numSockets, fanout);
+    }
+
+    DatagramRxGroup(const Pothos::DType &dtype, const size_t numSockets, const std::string &fanout):
+        _logger(Poco::Logger::get("DatagramRxGroup")),
+        _dtype(dtype),
+        _socks(numSockets),
+        _merge(fanout == "MERGE"),
+        _packetMode(false),
+        _mtu(1472),
+        _batchSize(32),
+        _running(false),
+        _dropped(0)
+    {
+        if (numSockets == 0) throw Pothos::InvalidArgumentException("DatagramRxGroup(0)", "need at least one socket");
+        if (fanout != "PARALLEL" and fanout != "MERGE") throw Pothos::InvalidArgumentException("DatagramRxGroup("+fanout+")", "unknown fanout");
+        for (size_t i = 0; i < (_merge?1:numSockets); i++) this->setupOutput(i, dtype);
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramRxGroup, setupSocket));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramRxGroup, getActualPort));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramRxGroup, setMode));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramRxGroup, setMTU));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramRxGroup, setBatchSize));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramRxGroup, setCpus));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramRxGroup, setBufferSize));
+        this->registerCall(this, POTHOS_FCN_TUPLE(DatagramRxGroup, dropped));
+        this->registerProbe("dropped");
+    }
+
+    ~DatagramRxGroup(void)
+    {
+        this->stopThreads();
+        for (auto &sock : _socks) sock.close();
+    }
+
+    void setupSocket(const std::string &uri)
+    {
+        try
+        {
+            Poco::URI uriObj(uri);
+            Poco::Net::SocketAddress addr(uriObj.getHost(), uriObj.getPort());
+            for (auto &sock : _socks)
+            {
+                sock = Poco::Net::DatagramSocket(addr.family());
+                sock.bind(addr, true/*reuseAddress*/, true/*reusePort*/);
+                addr = sock.address(); //the remaining sockets bind to the same port
+            }
+        }
+        catch (const Poco::Exception &ex)
+        {
+            throw Pothos::InvalidArgumentException("DatagramRxGroup::setupSocket("+uri+")", ex.displayText());
+        }
+    }
+
+    std::string getActualPort(void) const
+    {
+        return std::to_string(_socks.front().address().port());
+    }
+
+    void setMode(const std::string &mode)
+    {
+        if (mode == "STREAM") _packetMode = false;
+        else if (mode == "PACKET") _packetMode = true;
+        else throw Pothos::InvalidArgumentException("DatagramRxGroup::setMode("+mode+")", "unknown mode");
+    }
+
+    void setMTU(const size_t mtu)
+    {
+        if ((mtu % _dtype.size()) != 0) throw Pothos::InvalidArgumentException("DatagramRxGroup::setMTU("+std::to_string(mtu)+")",
+            "The MTU is not a multiple of the output data-type size: " + _dtype.toString());
+        _mtu = mtu;
+    }
+
+    void setBatchSize(const size_t batchSize)
+    {
+        if (batchSize == 0) throw Pothos::InvalidArgumentException("DatagramRxGroup::setBatchSize(0)", "batch size must be positive");
+        _batchSize = batchSize;
+    }
+
+    void setCpus(const std::vector<int> &cpus)
+    {
+        #ifndef HAS_CPU_AFFINITY
+        if (not cpus.empty()) poco_warning(_logger, "CPU pinning not supported on this platform");
+        #endif
+        _cpus = cpus;
+    }
+
+    void setBufferSize(const size_t recvSize)
+    {
+        if (recvSize == 0) return;
+        for (auto &sock : _socks)
+        {
+            sock.setReceiveBufferSize(recvSize);
+            const int actualSize = sock.getReceiveBufferSize();
+            if (actualSize < int(recvSize))
+            {
+                poco_warning_f2(_logger,
+                    "Attempted to set the socket receive buffer to %d bytes.\n"
+                    "The actual size was %d bytes. System limits may require reconfiguration.",
+                    int(recvSize), actualSize);
+                break;
+            }
+        }
+    }
+
+    unsigned long long dropped(void) const
+    {
+        return _dropped.load();
+    }
+
+    void activate(void)
+    {
+        _queues.clear();
+        for (size_t i = 0; i < _socks.size(); i++)
+        {
+            _queues.emplace_back(new SpscQueue<Pothos::BufferChunk>(RX_GROUP_QUEUE_DEPTH));
+        }
+        _running = true;
+        for (size_t i = 0; i < _socks.size(); i++)
+        {
+            _threads.emplace_back(&DatagramRxGroup::recvLoop, this, i);
+        }
+    }
+
+    void deactivate(void)
+    {
+        this->stopThreads();
+        _queues.clear();
+    }
+
+    void work(void)
+    {
+        //post the batches handed over from the receive threads
+        bool hadEvent = false;
+        for (size_t i = 0; i < _queues.size(); i++)
+        {
+            auto outPort = this->output(_merge?0:i);
+            auto &queue = *_queues[i];
+            for (size_t n = 0; n < RX_GROUP_QUEUE_DEPTH and not queue.empty(); n++)
+            {
+                auto buff = std::move(queue.front());
+                queue.pop();
+                if (_packetMode)
+                {
+                    Pothos::Packet pkt;
+                    pkt.payload = std::move(buff);
+                    outPort->postMessage(std::move(pkt));
+                }
+                else outPort->postBuffer(std::move(buff));
+                hadEvent = true;
+            }
+        }
+
+        //wait for a receive thread when nothing happened
+        if (not hadEvent)
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _cond.wait_for(lock, std::chrono::nanoseconds(this->workInfo().maxTimeoutNs), [this]{
+                for (const auto &queue : _queues) if (not queue->empty()) return true;
+                return false;
+            });
+        }
+
+        return this->yield(); //always yield to service the queues again
+    }
+
+private:
+    void stopThreads(void)
+    {
+        _running = false;
+        for (auto &thread : _threads) thread.join();
+        _threads.clear();
+    }
+
+    void recvLoop(const size_t index)
+    {
+        auto &sock = _socks[index];
+        #ifdef HAS_CPU_AFFINITY
+        if (index < _cpus.size())
+        {
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(_cpus[index], &cpuset);
+            if (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) != 0)
+            {
+                poco_warning_f1(_logger, "Failed to pin receive thread to CPU %d", _cpus[index]);
+            }
+            const int cpu = _cpus[index];
+            ::setsockopt(sock.impl()->sockfd(), SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu));
+        }
+        #endif //HAS_CPU_AFFINITY
+
+        #ifdef HAS_SENDRECV_MMSG
+        std::vector<struct mmsghdr> msgs(_batchSize);
+        std::vector<struct iovec> iovs(_batchSize);
+        const size_t batchBytes = _batchSize*_mtu;
+        #else
+        const size_t batchBytes = _mtu;
+        #endif //HAS_SENDRECV_MMSG
+
+        //batches are received into recycled buffers, a buffer is free again
+        //once downstream releases every datagram that references it
+        IoUringSlots slots(batchBytes, RX_GROUP_NUM_SLOTS);
+
+        while (_running)
+        {
+            if (not sock.poll(Poco::Timespan(0, 100*1000), Poco::Net::Socket::SELECT_READ)) continue;
+
+            //downstream holds every buffer, the socket buffer absorbs the datagrams meanwhile
+            size_t slot = 0;
+            if (not slots.acquire(slot))
+            {
+                slots.waitFree(RX_GROUP_SLOT_WAIT_NS);
+                continue;
+            }
+            auto buff = slots.take(slot, batchBytes);
+            buff.dtype = _dtype;
+
+            //receive a batch of MTU-sized slots into the buffer
+            #ifdef HAS_SENDRECV_MMSG
+            for (size_t i = 0; i < _batchSize; i++)
+            {
+                std::memset(&msgs[i], 0, sizeof(msgs[i]));
+                iovs[i].iov_base = buff.as<char *>() + i*_mtu;
+                iovs[i].iov_len = _mtu;
+                msgs[i].msg_hdr.msg_iov = &iovs[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+            const int ret = ::recvmmsg(sock.impl()->sockfd(), msgs.data(), _batchSize, MSG_DONTWAIT, nullptr);
+            if (ret < 0 and errno != EAGAIN and errno != EWOULDBLOCK)
+            {
+                poco_error_f1(_logger, "Socket recvmmsg failed: %s", std::string(strerror(errno)));
+            }
+            if (ret <= 0) continue;
+            std::vector<size_t> lengths(static_cast<size_t>(ret));
+            for (int i = 0; i < ret; i++) lengths[i] = msgs[i].msg_len;
+            #else
+            std::vector<size_t> lengths(1);
+            try
+            {
+                const int ret = sock.receiveBytes(buff.as<void *>(), int(_mtu));
+                if (ret <= 0) continue;
+                lengths[0] = size_t(ret);
+            }
+            catch (const Poco::Exception &ex)
+            {
+                poco_error_f1(_logger, "Socket recv failed: %s", ex.displayText());
+                continue;
+            }
+            #endif //HAS_SENDRECV_MMSG
+
+            this->handoff(index, buff, lengths);
+        }
+    }
+
+    //split or compact the received slots and hand them to work()
+    void handoff(const size_t index, const Pothos::BufferChunk &buff, const std::vector<size_t> &lengths)
+    {
+        auto &queue = *_queues[index];
+        const size_t elemSize = _dtype.size();
+        size_t numDropped = 0;
+        if (_packetMode)
+        {
+            for (size_t i = 0; i < lengths.size(); i++)
+            {
+                if (lengths[i] == 0) continue;
+                Pothos::BufferChunk payload(buff);
+                payload.address += i*_mtu;
+                payload.length = lengths[i];
+                if (not queue.push(std::move(payload))) numDropped++;
+            }
+        }
+        else
+        {
+            size_t bytesOut = 0;
+            for (size_t i = 0; i < lengths.size(); i++)
+            {
+                const size_t length = (lengths[i]/elemSize)*elemSize;
+                if (bytesOut != i*_mtu) std::memmove(buff.as<char *>() + bytesOut, buff.as<const char *>() + i*_mtu, length);
+                bytesOut += length;
+            }
+            Pothos::BufferChunk stream(buff);
+            stream.length = bytesOut;
+            if (bytesOut != 0 and not queue.push(std::move(stream))) numDropped += lengths.size();
+        }
+
+        //work() is not keeping up, count the dropped datagrams
+        if (numDropped != 0) _dropped += numDropped;
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cond.notify_one();
+    }
+
+    Poco::Logger &_logger;
+    const Pothos::DType _dtype;
+    std::vector<Poco::Net::DatagramSocket> _socks;
+    const bool _merge;
+    bool _packetMode;
+    size_t _mtu;
+    size_t _batchSize;
+    std::vector<int> _cpus;
+
+    //receive threads hand batches to work() through one queue per socket
+    std::atomic<bool> _running;
+    std::vector<std::thread> _threads;
+    std::vector<std::unique_ptr<SpscQueue<Pothos::BufferChunk>>> _queues;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::atomic<unsigned long long> _dropped;
+};
+
+static Pothos::BlockRegistry registerDatagramRxGroup(
+    "/blocks/datagram_rx_group", &DatagramRxGroup::make);
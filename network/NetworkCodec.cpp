@@ -0,0 +1,363 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "NetworkCodec.hpp"
+#include <Pothos/Exception.hpp>
+#include <Poco/ByteOrder.h>
+#include <streambuf>
+#include <istream>
+#include <ostream>
+#include <complex>
+#include <cstring>
+
+/***********************************************************************
+ * Value tags for the compact encoding:
+ * The tag selects the exact C++ type of the decoded object.
+ * All integer types are transmitted as 64-bit network order.
+ **********************************************************************/
+enum PothosPacketValueTag
+{
+    VALUE_TAG_NULL,
+    VALUE_TAG_BOOL,
+    VALUE_TAG_CHAR,
+    VALUE_TAG_SCHAR,
+    VALUE_TAG_UCHAR,
+    VALUE_TAG_SHORT,
+    VALUE_TAG_USHORT,
+    VALUE_TAG_INT,
+    VALUE_TAG_UINT,
+    VALUE_TAG_LONG,
+    VALUE_TAG_ULONG,
+    VALUE_TAG_LLONG,
+    VALUE_TAG_ULLONG,
+    VALUE_TAG_FLOAT,
+    VALUE_TAG_DOUBLE,
+    VALUE_TAG_CFLOAT,
+    VALUE_TAG_CDOUBLE,
+    VALUE_TAG_STRING,
+};
+
+#define POTHOS_PACKET_CODEC_INTEGERS(fcn) \
+    fcn(VALUE_TAG_CHAR, char) \
+    fcn(VALUE_TAG_SCHAR, signed char) \
+    fcn(VALUE_TAG_UCHAR, unsigned char) \
+    fcn(VALUE_TAG_SHORT, short) \
+    fcn(VALUE_TAG_USHORT, unsigned short) \
+    fcn(VALUE_TAG_INT, int) \
+    fcn(VALUE_TAG_UINT, unsigned int) \
+    fcn(VALUE_TAG_LONG, long) \
+    fcn(VALUE_TAG_ULONG, unsigned long) \
+    fcn(VALUE_TAG_LLONG, long long) \
+    fcn(VALUE_TAG_ULLONG, unsigned long long)
+
+/***********************************************************************
+ * Stream buffers for the serialization fallback without copies
+ **********************************************************************/
+struct PothosPacketOutputBuf : std::streambuf
+{
+    PothosPacketOutputBuf(std::vector<char> &buff):
+        buff(buff)
+    {
+        return;
+    }
+
+    int_type overflow(int_type ch)
+    {
+        if (ch != traits_type::eof()) buff.push_back(char(ch));
+        return ch;
+    }
+
+    std::streamsize xsputn(const char *s, std::streamsize n)
+    {
+        buff.insert(buff.end(), s, s+n);
+        return n;
+    }
+
+    std::vector<char> &buff;
+};
+
+struct PothosPacketInputBuf : std::streambuf
+{
+    PothosPacketInputBuf(const char *buff, const size_t length)
+    {
+        char *begin = const_cast<char *>(buff);
+        this->setg(begin, begin, begin+length);
+    }
+};
+
+/***********************************************************************
+ * Encoder implementation
+ **********************************************************************/
+void PothosPacketEncoder::put8(const uint8_t value)
+{
+    _buff.push_back(char(value));
+}
+
+void PothosPacketEncoder::put32(const uint32_t value)
+{
+    const auto valueN = Poco::ByteOrder::toNetwork(Poco::UInt32(value));
+    const char *p = reinterpret_cast<const char *>(&valueN);
+    _buff.insert(_buff.end(), p, p+sizeof(valueN));
+}
+
+void PothosPacketEncoder::put64(const uint64_t value)
+{
+    const auto valueN = Poco::ByteOrder::toNetwork(Poco::UInt64(value));
+    const char *p = reinterpret_cast<const char *>(&valueN);
+    _buff.insert(_buff.end(), p, p+sizeof(valueN));
+}
+
+void PothosPacketEncoder::putString(const std::string &value)
+{
+    this->put32(uint32_t(value.size()));
+    _buff.insert(_buff.end(), value.begin(), value.end());
+}
+
+bool PothosPacketEncoder::encode(const Pothos::Object &obj)
+{
+    if (not obj)
+    {
+        this->put8(VALUE_TAG_NULL);
+        return true;
+    }
+
+    const auto &type = obj.type();
+
+    #define POTHOS_PACKET_ENCODE_INTEGER(tag, T) \
+        if (type == typeid(T)) \
+        { \
+            this->put8(tag); \
+            this->put64(uint64_t(obj.extract<T>())); \
+            return true; \
+        }
+    POTHOS_PACKET_CODEC_INTEGERS(POTHOS_PACKET_ENCODE_INTEGER)
+
+    if (type == typeid(bool))
+    {
+        this->put8(VALUE_TAG_BOOL);
+        this->put8(obj.extract<bool>()?1:0);
+        return true;
+    }
+    if (type == typeid(float))
+    {
+        uint32_t bits; const float value(obj.extract<float>());
+        std::memcpy(&bits, &value, sizeof(bits));
+        this->put8(VALUE_TAG_FLOAT);
+        this->put32(bits);
+        return true;
+    }
+    if (type == typeid(double))
+    {
+        uint64_t bits; const double value(obj.extract<double>());
+        std::memcpy(&bits, &value, sizeof(bits));
+        this->put8(VALUE_TAG_DOUBLE);
+        this->put64(bits);
+        return true;
+    }
+    if (type == typeid(std::complex<float>))
+    {
+        uint32_t bits[2]; const auto &value = obj.extract<std::complex<float>>();
+        const float parts[2] = {value.real(), value.imag()};
+        std::memcpy(bits, parts, sizeof(bits));
+        this->put8(VALUE_TAG_CFLOAT);
+        this->put32(bits[0]);
+        this->put32(bits[1]);
+        return true;
+    }
+    if (type == typeid(std::complex<double>))
+    {
+        uint64_t bits[2]; const auto &value = obj.extract<std::complex<double>>();
+        const double parts[2] = {value.real(), value.imag()};
+        std::memcpy(bits, parts, sizeof(bits));
+        this->put8(VALUE_TAG_CDOUBLE);
+        this->put64(bits[0]);
+        this->put64(bits[1]);
+        return true;
+    }
+    if (type == typeid(std::string))
+    {
+        this->put8(VALUE_TAG_STRING);
+        this->putString(obj.extract<std::string>());
+        return true;
+    }
+
+    return false;
+}
+
+bool PothosPacketEncoder::encode(const Pothos::Label &label)
+{
+    this->put64(label.index);
+    this->put32(uint32_t(label.width));
+    this->putString(label.id);
+    return this->encode(label.data);
+}
+
+bool PothosPacketEncoder::encode(const Pothos::DType &dtype)
+{
+    //only data types that can be reconstructed from their markup
+    const auto markup = dtype.toMarkup();
+    try
+    {
+        if (Pothos::DType(markup) != dtype) return false;
+    }
+    catch (const Pothos::Exception &)
+    {
+        return false;
+    }
+    this->putString(markup);
+    return true;
+}
+
+bool PothosPacketEncoder::encode(const Pothos::Packet &packet)
+{
+    this->put32(uint32_t(packet.metadata.size()));
+    for (const auto &pair : packet.metadata)
+    {
+        this->putString(pair.first);
+        if (not this->encode(pair.second)) return false;
+    }
+    this->put32(uint32_t(packet.labels.size()));
+    for (const auto &label : packet.labels)
+    {
+        if (not this->encode(label)) return false;
+    }
+    return true;
+}
+
+void PothosPacketEncoder::serialize(const Pothos::Object &obj)
+{
+    PothosPacketOutputBuf buf(_buff);
+    std::ostream os(&buf);
+    obj.serialize(os);
+}
+
+/***********************************************************************
+ * Decoder implementation
+ **********************************************************************/
+PothosPacketDecoder::PothosPacketDecoder(const void *buff, const size_t length):
+    _buff(reinterpret_cast<const char *>(buff)),
+    _length(length),
+    _offset(0)
+{
+    return;
+}
+
+const char *PothosPacketDecoder::take(const size_t numBytes)
+{
+    if (_offset + numBytes > _length)
+    {
+        throw Pothos::RangeException("PothosPacketDecoder", "truncated frame");
+    }
+    const char *p = _buff + _offset;
+    _offset += numBytes;
+    return p;
+}
+
+uint8_t PothosPacketDecoder::get8(void)
+{
+    return uint8_t(*this->take(1));
+}
+
+uint32_t PothosPacketDecoder::get32(void)
+{
+    Poco::UInt32 valueN;
+    std::memcpy(&valueN, this->take(sizeof(valueN)), sizeof(valueN));
+    return Poco::ByteOrder::fromNetwork(valueN);
+}
+
+uint64_t PothosPacketDecoder::get64(void)
+{
+    Poco::UInt64 valueN;
+    std::memcpy(&valueN, this->take(sizeof(valueN)), sizeof(valueN));
+    return Poco::ByteOrder::fromNetwork(valueN);
+}
+
+std::string PothosPacketDecoder::getString(void)
+{
+    const size_t length = this->get32();
+    return std::string(this->take(length), length);
+}
+
+Pothos::Object PothosPacketDecoder::object(void)
+{
+    const auto tag = this->get8();
+    switch (tag)
+    {
+    case VALUE_TAG_NULL: return Pothos::Object();
+    case VALUE_TAG_BOOL: return Pothos::Object(this->get8() != 0);
+
+    #define POTHOS_PACKET_DECODE_INTEGER(tag, T) \
+        case tag: return Pothos::Object(static_cast<T>(this->get64()));
+    POTHOS_PACKET_CODEC_INTEGERS(POTHOS_PACKET_DECODE_INTEGER)
+
+    case VALUE_TAG_FLOAT:
+    {
+        const uint32_t bits(this->get32()); float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return Pothos::Object(value);
+    }
+    case VALUE_TAG_DOUBLE:
+    {
+        const uint64_t bits(this->get64()); double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return Pothos::Object(value);
+    }
+    case VALUE_TAG_CFLOAT:
+    {
+        const uint32_t bits[2] = {this->get32(), this->get32()}; float parts[2];
+        std::memcpy(parts, bits, sizeof(parts));
+        return Pothos::Object(std::complex<float>(parts[0], parts[1]));
+    }
+    case VALUE_TAG_CDOUBLE:
+    {
+        const uint64_t bits[2] = {this->get64(), this->get64()}; double parts[2];
+        std::memcpy(parts, bits, sizeof(parts));
+        return Pothos::Object(std::complex<double>(parts[0], parts[1]));
+    }
+    case VALUE_TAG_STRING: return Pothos::Object(this->getString());
+    }
+
+    throw Pothos::RangeException("PothosPacketDecoder::object()", "unknown value tag " + std::to_string(tag));
+}
+
+Pothos::Label PothosPacketDecoder::label(void)
+{
+    Pothos::Label label;
+    label.index = this->get64();
+    label.width = this->get32();
+    label.id = this->getString();
+    label.data = this->object();
+    return label;
+}
+
+Pothos::DType PothosPacketDecoder::dtype(void)
+{
+    return Pothos::DType(this->getString());
+}
+
+Pothos::Packet PothosPacketDecoder::packet(void)
+{
+    Pothos::Packet packet;
+    const size_t numMetadata = this->get32();
+    for (size_t i = 0; i < numMetadata; i++)
+    {
+        auto key = this->getString();
+        packet.metadata[key] = this->object();
+    }
+    const size_t numLabels = this->get32();
+    for (size_t i = 0; i < numLabels; i++)
+    {
+        packet.labels.push_back(this->label());
+    }
+    return packet;
+}
+
+Pothos::Object PothosPacketDecoder::deserialize(void)
+{
+    PothosPacketInputBuf buf(_buff + _offset, _length - _offset);
+    std::istream is(&buf);
+    Pothos::Object obj;
+    obj.deserialize(is);
+    _offset = _length;
+    return obj;
+}
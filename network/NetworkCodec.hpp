@@ -0,0 +1,94 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Pothos/Framework.hpp>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/*!
+ * The packet encoder writes a compact binary representation
+ * of labels, data types, packet headers, and common messages.
+ * The encoder owns a reusable buffer so that each frame
+ * is encoded directly into memory that is passed to send().
+ *
+ * Values of booleans, integers, floats, complex floats, strings,
+ * and null objects are supported by the compact encoding.
+ * Encode calls return false for any other type, in which case
+ * the caller should clear() and fallback to serialize().
+ */
+class PothosPacketEncoder
+{
+public:
+    //! Reset the buffer for a new frame
+    void clear(void)
+    {
+        _buff.clear();
+    }
+
+    //! The encoded frame bytes
+    const void *data(void) const
+    {
+        return _buff.data();
+    }
+
+    //! The number of encoded bytes
+    size_t size(void) const
+    {
+        return _buff.size();
+    }
+
+    bool encode(const Pothos::Object &obj);
+
+    bool encode(const Pothos::Label &label);
+
+    bool encode(const Pothos::DType &dtype);
+
+    //! Encode the packet metadata and labels (the payload is not encoded)
+    bool encode(const Pothos::Packet &packet);
+
+    //! Fallback to the generic object serialization
+    void serialize(const Pothos::Object &obj);
+
+private:
+    void put8(const uint8_t value);
+    void put32(const uint32_t value);
+    void put64(const uint64_t value);
+    void putString(const std::string &value);
+    std::vector<char> _buff;
+};
+
+/*!
+ * The packet decoder parses frames from the packet encoder.
+ * The decoder reads directly from the received buffer without copying,
+ * and throws Pothos::RangeException for truncated or malformed frames.
+ */
+class PothosPacketDecoder
+{
+public:
+    PothosPacketDecoder(const void *buff, const size_t length);
+
+    Pothos::Object object(void);
+
+    Pothos::Label label(void);
+
+    Pothos::DType dtype(void);
+
+    Pothos::Packet packet(void);
+
+    //! Fallback to the generic object deserialization
+    Pothos::Object deserialize(void);
+
+private:
+    const char *take(const size_t numBytes);
+    uint8_t get8(void);
+    uint32_t get32(void);
+    uint64_t get64(void);
+    std::string getString(void);
+    const char *_buff;
+    size_t _length;
+    size_t _offset;
+};
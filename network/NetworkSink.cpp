@@ -2,59 +2,456 @@
 // SPDX-License-Identifier: BSL-1.0
 
 #include "SocketEndpoint.hpp"
+#include "NetworkCodec.hpp"
+#include "SpscQueue.hpp"
 #include <Pothos/Framework.hpp>
+#include <Poco/Logger.h>
+#include <Poco/ByteOrder.h>
 #include <thread>
-#include <sstream>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <deque>
+#include <list>
+#include <cstring> //memcpy
+#include <limits>
 #include <string>
 #include <chrono>
 #include <cassert>
 #include <iostream>
 
+/***********************************************************************
+ * A frame queued for the sender thread
+ **********************************************************************/
+struct NetworkSinkFrame
+{
+    NetworkSinkFrame(void):
+        type(0),
+        more(false)
+    {
+        return;
+    }
+
+    NetworkSinkFrame(const uint16_t type, const Pothos::BufferChunk &buffer, const bool more):
+        type(type),
+        buffer(buffer),
+        more(more)
+    {
+        return;
+    }
+
+    uint16_t type;
+    Pothos::BufferChunk buffer;
+    bool more;
+};
+
+/***********************************************************************
+ * A subscriber of a publishing network sink:
+ * The work function queues references to the encoded frames
+ * and the subscriber's sender thread transmits them as its own
+ * flow control window allows. The receiver thread services
+ * the flow control messages from the subscriber.
+ **********************************************************************/
+enum NetworkSinkPolicy
+{
+    POLICY_BLOCK,
+    POLICY_DROP_OLDEST,
+    POLICY_DISCONNECT,
+};
+
+class NetworkSinkSubscriber
+{
+public:
+    NetworkSinkSubscriber(const std::shared_ptr<PothosPacketSocketEndpoint> &ep):
+        ep(ep),
+        connected(true),
+        stopping(false),
+        midGroup(false),
+        dropCount(0)
+    {
+        sender = std::thread(&NetworkSinkSubscriber::handleSend, this);
+        receiver = std::thread(&NetworkSinkSubscriber::handleRecv, this);
+    }
+
+    ~NetworkSinkSubscriber(void)
+    {
+        this->stop();
+    }
+
+    //false once the subscriber closed or was disconnected
+    bool isConnected(void) const
+    {
+        return connected;
+    }
+
+    unsigned long long dropped(void) const
+    {
+        return dropCount;
+    }
+
+    //queue a frame, the policy applies when the queue is at its depth
+    void push(const NetworkSinkFrame &frame, const NetworkSinkPolicy policy, const size_t depth)
+    {
+        if (not connected) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        if (frames.size() >= depth)
+        {
+            if (policy == POLICY_DISCONNECT)
+            {
+                connected = false;
+                cond.notify_all();
+                return;
+            }
+            if (policy == POLICY_DROP_OLDEST) this->dropOldest();
+            //POLICY_BLOCK waits for space before each frame group in work()
+        }
+        frames.push_back(frame);
+        cond.notify_all();
+    }
+
+    //the number of frames that fit below the depth, unlimited when disconnected
+    size_t space(const size_t depth)
+    {
+        if (not connected) return std::numeric_limits<size_t>::max();
+        std::lock_guard<std::mutex> lock(mutex);
+        return (frames.size() < depth)?(depth - frames.size()):0;
+    }
+
+    //wait for the queue to drain below the depth, false on timeout
+    bool waitSpace(const size_t depth, const std::chrono::high_resolution_clock::duration &timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cond.wait_for(lock, timeout, [this, depth]{return frames.size() < depth or not connected;});
+    }
+
+    //send the queued frames and close the connection
+    void stop(void)
+    {
+        if (not sender.joinable()) return;
+        stopping = true;
+        cond.notify_all();
+        sender.join();
+        receiver.join();
+        try {ep->closeComms();}
+        catch (...){} //failure OK, the subscriber may be gone
+    }
+
+private:
+    //drop the oldest complete frame group, keeping data type frames
+    //so that the subscriber interprets the following buffers correctly
+    void dropOldest(void)
+    {
+        auto it = frames.begin();
+        if (midGroup) //the sender is in the middle of the first group
+        {
+            while (it != frames.end() and (it++)->more);
+        }
+        while (it != frames.end())
+        {
+            const bool more = it->more;
+            if ((it->type & 0xff) == PothosPacketTypeDType or (it->type & 0xff) == PothosPacketTypeDTypeCompact) it++;
+            else it = frames.erase(it);
+            if (not more) break;
+        }
+        dropCount++;
+    }
+
+    void handleSend(void)
+    {
+        const auto timeout = std::chrono::milliseconds(100);
+        while (connected)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait_for(lock, timeout, [this]{return not frames.empty() or stopping or not connected;});
+            if (frames.empty())
+            {
+                if (stopping) return;
+                continue;
+            }
+            const auto frame = std::move(frames.front());
+            frames.pop_front();
+            midGroup = frame.more;
+            cond.notify_all();
+            lock.unlock();
+
+            //when stopping, the remaining frames are dropped if the window does not open
+            while (not ep->waitReady(timeout))
+            {
+                if (stopping or not connected) return;
+            }
+
+            try {ep->send(frame.type, frame.buffer, frame.more);}
+            catch (...) {connected = false;}
+        }
+    }
+
+    void handleRecv(void)
+    {
+        uint16_t type = 0;
+        Pothos::BufferChunk buffer(1024);
+        while (connected and not stopping)
+        {
+            try {ep->recv(type, buffer);}
+            catch (...) {connected = false;}
+        }
+        cond.notify_all();
+    }
+
+    std::shared_ptr<PothosPacketSocketEndpoint> ep;
+    std::atomic<bool> connected;
+    std::atomic<bool> stopping;
+    std::deque<NetworkSinkFrame> frames;
+    bool midGroup;
+    std::atomic<unsigned long long> dropCount;
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::thread sender;
+    std::thread receiver;
+};
+
 /***********************************************************************
  * |PothosDoc Network Sink
  *
  * The network sink accepts data on its input port and serializes it over a socket.
  * All input port data is serialized, which includes stream buffers, inline labels, and async messages.
  *
- * The underlying supports the tcp transport option:
- * TCP - tcp://host:port
+ * The underlying supports the tcp, udp, unix, and shm transport options:
+ * TCP - tcp://host:port or tcp://host:port?streams=N (striped over N connections)
+ * UDP - udp://host:port or udp://host:port?rate=bytesPerSec (reliable, NAK-based retransmission)
+ * UNIX - unix:///path/to/socket or unix://@name (abstract namespace)
+ * SHM - shm://name or shm://name?size=bytes (shared memory rings, Linux only)
+ *
+ * <h2>Publisher mode</h2>
+ *
+ * With the "PUBLISH" option, the sink listens on a tcp://host:port address
+ * and accepts any number of network sources that connect as subscribers.
+ * Each frame is serialized once, and the encoded bytes are queued by reference
+ * to every subscriber, which has its own sender thread and flow control window.
+ * Subscribers that connect later receive the stream from the next frame.
+ * The subscriber policy decides what happens when a subscriber's queue is full.
  *
  * |category /Network
  * |category /Sinks
- * |keywords sink network
+ * |keywords sink network publish subscribe
  *
  * |param uri[URI] The bind or connection uri string.
  * |default "tcp://192.168.10.2:1234"
  *
  * |param opt[Option] Control if the socket is a server (BIND) or client (CONNECT).
  * The "DISCONNECT" option is used to make a disconnected endpoint for object inspection.
+ * The "PUBLISH" option is a server for many subscribers (tcp only).
  * |option [Disconnect] "DISCONNECT"
  * |option [Connect] "CONNECT"
  * |option [Bind] "BIND"
+ * |option [Publish] "PUBLISH"
  * |default "DISCONNECT"
  *
+ * |param window[Flow Window] The flow control window size in bytes.
+ * The window is negotiated with the remote endpoint when the connection opens.
+ * Specify 0 to automatically size the window from the measured round trip time and throughput.
+ * A window other than the default also sizes the socket send and receive buffers,
+ * otherwise the buffers are left to the kernel's autotuning.
+ * |units bytes
+ * |default 262144
+ * |preview valid
+ * |tab Advanced
+ *
+ * |param zeroCopy[Zero Copy] Transmit large stream buffers without copying.
+ * The sink holds each buffer until the kernel reports that the transfer completed.
+ * This option requires MSG_ZEROCOPY support on the host (Linux 4.14 and up).
+ * |option [Disabled] false
+ * |option [Enabled] true
+ * |default false
+ * |preview valid
+ * |tab Advanced
+ *
+ * |param asyncSend[Async Send] Transmit from a dedicated sender thread.
+ * When enabled, the work function queues references to the input buffers,
+ * and the sender thread transmits them as the flow control window allows.
+ * Backpressure is applied when the queue is full.
+ * |option [Disabled] false
+ * |option [Enabled] true
+ * |default false
+ * |preview valid
+ * |tab Advanced
+ *
+ * |param queueDepth[Queue Depth] The maximum number of frames queued for the sender thread.
+ * In publisher mode, this is the depth of the queue of each subscriber.
+ * |units frames
+ * |default 64
+ * |preview valid
+ * |tab Advanced
+ *
+ * |param policy[Subscriber Policy] What to do when a subscriber falls behind in publisher mode.
+ * <ul>
+ * <li>"BLOCK" - Wait for the subscriber, which applies backpressure to the sink.</li>
+ * <li>"DROP_OLDEST" - Drop the oldest queued frames of the subscriber to make room.</li>
+ * <li>"DISCONNECT" - Close the connection to the subscriber.</li>
+ * </ul>
+ * |option [Block] "BLOCK"
+ * |option [Drop Oldest] "DROP_OLDEST"
+ * |option [Disconnect] "DISCONNECT"
+ * |default "BLOCK"
+ * |preview valid
+ * |tab Advanced
+ *
+ * |param coalesceBytes[Coalesce Bytes] Coalesce small label and message frames.
+ * When enabled, the label, message, and data type frames are gathered
+ * and transmitted in one contiguous send with the header of the following buffer.
+ * The gathered frames are also sent once their size reaches this threshold.
+ * The frames keep their order, so labels still match the stream position.
+ * Specify 0 to send each frame immediately.
+ * Coalescing does not apply to the async send and publisher modes.
+ * |units bytes
+ * |default 0
+ * |preview valid
+ * |tab Advanced
+ *
+ * |param coalesceDelay[Coalesce Delay] The maximum time that frames wait to be coalesced.
+ * Frames that were not sent with a buffer are flushed after this delay,
+ * or as soon as no further input is pending to join them.
+ * Specify 0 to flush at the end of every work call.
+ * |units us
+ * |default 0
+ * |preview valid
+ * |tab Advanced
+ *
  * |factory /blocks/network_sink(uri, opt)
+ * |setter setFlowControlWindow(window)
+ * |setter setZeroCopy(zeroCopy)
+ * |setter setAsyncSend(asyncSend)
+ * |setter setQueueDepth(queueDepth)
+ * |setter setSubscriberPolicy(policy)
+ * |setter setCoalesce(coalesceBytes, coalesceDelay)
+ **********************************************************************/
+
+/***********************************************************************
+ * |PothosDoc Network Mux Sink
+ *
+ * The network mux sink serializes several input ports over a single connection.
+ * Each input port is a logical channel, and the channel number is carried
+ * in the frame header, so that a network mux source with the same number
+ * of channels reproduces each channel on the output port of the same index.
+ *
+ * Each channel has its own flow control window:
+ * the mux source returns credit for a channel once the downstream blocks
+ * release the buffers of that channel, and the sink stops sending on a channel
+ * without credit, while the other channels continue over the shared connection.
+ *
+ * The transport options are the same as the network sink.
+ *
+ * |category /Network
+ * |category /Sinks
+ * |keywords sink network multiplex channel
+ *
+ * |param uri[URI] The bind or connection uri string.
+ * |default "tcp://192.168.10.2:1234"
+ *
+ * |param opt[Option] Control if the socket is a server (BIND) or client (CONNECT).
+ * |option [Connect] "CONNECT"
+ * |option [Bind] "BIND"
+ * |default "CONNECT"
+ *
+ * |param numChannels[Num Channels] The number of input ports.
+ * |default 2
+ * |widget SpinBox(minimum=1, maximum=256)
+ * |preview disable
+ *
+ * |param window[Flow Window] The flow control window of the connection in bytes.
+ * Specify 0 to automatically size the window from the measured round trip time and throughput.
+ * |units bytes
+ * |default 262144
+ * |preview valid
+ * |tab Advanced
+ *
+ * |param channelWindow[Channel Window] The flow control window of each channel in bytes.
+ * The maximum number of stream and packet payload bytes that a channel
+ * can have in flight or held by the blocks downstream of the mux source.
+ * |units bytes
+ * |default 1048576
+ * |preview valid
+ * |tab Advanced
+ *
+ * |param asyncSend[Async Send] Transmit from a dedicated sender thread.
+ * |option [Disabled] false
+ * |option [Enabled] true
+ * |default false
+ * |preview valid
+ * |tab Advanced
+ *
+ * |factory /blocks/network_mux_sink(uri, opt, numChannels)
+ * |setter setFlowControlWindow(window)
+ * |setter setChannelWindow(channelWindow)
+ * |setter setAsyncSend(asyncSend)
  **********************************************************************/
 class NetworkSink : public Pothos::Block
 {
 public:
     static Block *make(const std::string &uri, const std::string &opt)
     {
-        return new NetworkSink(uri, opt);
+        return new NetworkSink(uri, opt, 1);
+    }
+
+    static Block *makeMux(const std::string &uri, const std::string &opt, const size_t numChannels)
+    {
+        if (numChannels == 0 or numChannels > PothosPacketMaxChannels) throw Pothos::InvalidArgumentException(
+            "NetworkSink("+std::to_string(numChannels)+")", "channels out of range");
+        if (opt == "PUBLISH") throw Pothos::InvalidArgumentException(
+            "NetworkSink("+opt+")", "publisher mode does not support channels");
+        return new NetworkSink(uri, opt, numChannels);
     }
 
-    NetworkSink(const std::string &uri, const std::string &opt):
+    NetworkSink(const std::string &uri, const std::string &opt, const size_t numChannels):
         _ep(PothosPacketSocketEndpoint(uri, opt)),
-        running(false)
+        running(false),
+        _lastDtypes(numChannels),
+        _compact(false),
+        _channel(0),
+        _channelWindow(1024*1024),
+        _channelSent(numChannels),
+        _labelsQueued(numChannels),
+        _channelAcked(new std::atomic<unsigned long long>[numChannels]),
+        _publishing(opt == "PUBLISH"),
+        _policy(POLICY_BLOCK),
+        _zeroCopy(false),
+        _subscriberCount(0),
+        _dropCount(0),
+        _dropCountRemoved(0),
+        _asyncSend(false),
+        _queueDepth(64),
+        _senderRunning(false),
+        _coalesceBytes(0),
+        _coalesceDelay(0),
+        _logger(Poco::Logger::get("NetworkSink"))
     {
         //std::cout << "NetworkSink " << opt << " " << uri << std::endl;
-        this->setupInput(0);
+        for (size_t i = 0; i < numChannels; i++) this->setupInput(i);
         this->registerCall(this, POTHOS_FCN_TUPLE(NetworkSink, getActualPort));
+        this->registerCall(this, POTHOS_FCN_TUPLE(NetworkSink, setChannelWindow));
+        this->registerCall(this, POTHOS_FCN_TUPLE(NetworkSink, setSubscriberPolicy));
+        this->registerCall(this, POTHOS_FCN_TUPLE(NetworkSink, subscriberCount));
+        this->registerCall(this, POTHOS_FCN_TUPLE(NetworkSink, dropCount));
+        this->registerCall(this, POTHOS_FCN_TUPLE(NetworkSink, setZeroCopy));
+        this->registerCall(this, POTHOS_FCN_TUPLE(NetworkSink, setFlowControlWindow));
+        this->registerCall(this, POTHOS_FCN_TUPLE(NetworkSink, setAsyncSend));
+        this->registerCall(this, POTHOS_FCN_TUPLE(NetworkSink, setQueueDepth));
+        this->registerCall(this, POTHOS_FCN_TUPLE(NetworkSink, setCoalesce));
+        this->registerCall(this, POTHOS_FCN_TUPLE(NetworkSink, flowControlWindow));
+        this->registerCall(this, POTHOS_FCN_TUPLE(NetworkSink, stallCount));
+        this->registerCall(this, POTHOS_FCN_TUPLE(NetworkSink, stallTime));
+        this->registerProbe("flowControlWindow");
+        this->registerProbe("stallCount");
+        this->registerProbe("stallTime");
+        this->registerProbe("subscriberCount");
+        this->registerProbe("dropCount");
     }
 
     ~NetworkSink(void)
     {
-        //the thread cannot be left running
+        //the threads cannot be left running
+        this->stopSender();
         if (handlerThread.joinable())
         {
             running = false;
@@ -67,18 +464,121 @@ public:
         return _ep.getActualPort();
     }
 
+    void setZeroCopy(const bool enable)
+    {
+        _zeroCopy = enable;
+        _ep.setZeroCopy(enable);
+    }
+
+    void setFlowControlWindow(const size_t numBytes)
+    {
+        _ep.setFlowControlWindow(numBytes);
+    }
+
+    void setChannelWindow(const size_t numBytes)
+    {
+        _channelWindow = numBytes;
+    }
+
+    void setSubscriberPolicy(const std::string &policy)
+    {
+        if (policy == "BLOCK") _policy = POLICY_BLOCK;
+        else if (policy == "DROP_OLDEST") _policy = POLICY_DROP_OLDEST;
+        else if (policy == "DISCONNECT") _policy = POLICY_DISCONNECT;
+        else throw Pothos::InvalidArgumentException("NetworkSink::setSubscriberPolicy("+policy+")", "unknown policy");
+    }
+
+    size_t subscriberCount(void) const
+    {
+        return _subscriberCount;
+    }
+
+    unsigned long long dropCount(void) const
+    {
+        return _dropCount;
+    }
+
+    void setAsyncSend(const bool enable)
+    {
+        _asyncSend = enable;
+    }
+
+    void setQueueDepth(const size_t depth)
+    {
+        if (depth < MIN_QUEUE_DEPTH) throw Pothos::InvalidArgumentException(
+            "NetworkSink::setQueueDepth("+std::to_string(depth)+")", "queue depth too small");
+        _queueDepth = depth;
+    }
+
+    void setCoalesce(const size_t maxBytes, const long long maxDelayUs)
+    {
+        if (maxDelayUs < 0) throw Pothos::InvalidArgumentException(
+            "NetworkSink::setCoalesce("+std::to_string(maxDelayUs)+")", "negative delay");
+        _coalesceBytes = maxBytes;
+        _coalesceDelay = std::chrono::microseconds(maxDelayUs);
+    }
+
+    size_t flowControlWindow(void) const
+    {
+        return _ep.getFlowControlWindow();
+    }
+
+    unsigned long long stallCount(void) const
+    {
+        return _ep.getStallCount();
+    }
+
+    double stallTime(void) const
+    {
+        return _ep.getStallTime();
+    }
+
     void activate(void)
     {
+        if (_publishing) return this->activatePublisher();
         _ep.openComms();
+        _compact = (_ep.getFeatures() & PothosPacketFeatureCompactCodec) != 0;
+        if (this->numChannels() > 1 and (_ep.getFeatures() & PothosPacketFeatureChannels) == 0)
+        {
+            _ep.closeComms();
+            throw Pothos::RuntimeException("NetworkSink::activate()", "remote endpoint does not support channels");
+        }
+        for (size_t i = 0; i < this->numChannels(); i++)
+        {
+            _lastDtypes[i] = Pothos::DType();
+            _channelSent[i] = 0;
+            _labelsQueued[i] = 0;
+            _channelAcked[i] = 0;
+        }
 
         //start the endpoint handler thread
         running = true;
         assert(not handlerThread.joinable());
         handlerThread = std::thread(&NetworkSink::handleState, this);
+
+        //start the sender thread
+        if (_asyncSend)
+        {
+            _queue.reset(new SpscQueue<NetworkSinkFrame>(_queueDepth));
+            _senderRunning = true;
+            senderThread = std::thread(&NetworkSink::handleSend, this);
+        }
     }
 
     void deactivate(void)
     {
+        if (_publishing) return this->deactivatePublisher();
+
+        //flush and stop the sender thread
+        this->stopSender();
+
+        //send the frames that are waiting to be coalesced
+        try {_ep.flush();}
+        catch (const Pothos::Exception &ex)
+        {
+            poco_error_f1(_logger, "Flush failed: %s", ex.displayText());
+        }
+
         //stop the endpoint handler thread
         assert(handlerThread.joinable());
         running = false;
@@ -88,47 +588,378 @@ public:
     }
 
     //NetworkSink is a send-only block and needs a polling thread.
+    //The thread also collects the channel credit from a mux source.
     void handleState(void)
-{
+    {
         uint16_t type = 0;
         Pothos::BufferChunk buffer(1024);
         while (running)
         {
             try {_ep.recv(type, buffer);}
-            catch (...){}
+            catch (...){continue;}
+            if ((type & 0xff) != PothosPacketTypeCredit or buffer.length < sizeof(uint64_t)) continue;
+            const size_t channel = type >> 8;
+            if (channel >= this->numChannels()) continue;
+            uint64_t totalN; std::memcpy(&totalN, buffer.as<const void *>(), sizeof(totalN));
+            _channelAcked[channel] = Poco::ByteOrder::fromNetwork(Poco::UInt64(totalN));
+        }
+    }
+
+    void activatePublisher(void)
+    {
+        _compact = true; //subscribers without the compact codec are refused
+        for (auto &dtype : _lastDtypes) dtype = Pothos::DType();
+        _subscriberCount = 0;
+        _dropCount = 0;
+        _dropCountRemoved = 0;
+        running = true;
+        assert(not handlerThread.joinable());
+        handlerThread = std::thread(&NetworkSink::handlePublish, this);
+    }
+
+    void deactivatePublisher(void)
+    {
+        assert(handlerThread.joinable());
+        running = false;
+        handlerThread.join();
+
+        //flush and disconnect every subscriber
+        std::lock_guard<std::mutex> lock(_pendingMutex);
+        _subscribers.clear();
+        _pending.clear();
+        _subscriberCount = 0;
+    }
+
+    //Accept subscribers and perform their handshakes.
+    void handlePublish(void)
+    {
+        while (running)
+        {
+            auto ep = _ep.accept(std::chrono::milliseconds(100));
+            if (not ep) continue;
+            try
+            {
+                ep->setZeroCopy(_zeroCopy);
+                ep->openComms(std::chrono::seconds(1));
+            }
+            catch (const Pothos::Exception &ex)
+            {
+                poco_warning_f1(_logger, "Subscriber handshake failed: %s", ex.displayText());
+                continue;
+            }
+            if ((ep->getFeatures() & PothosPacketFeatureCompactCodec) == 0)
+            {
+                poco_warning(_logger, "Subscriber refused: the compact codec is not supported");
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(_pendingMutex);
+            _pending.emplace_back(new NetworkSinkSubscriber(ep));
+            _subscriberCount++;
+        }
+    }
+
+    void workPublish(void);
+
+    //Transmit frames from the queue as the flow control window allows.
+    void handleSend(void)
+    {
+        const auto timeout = std::chrono::milliseconds(100);
+        while (_senderRunning or not _queue->empty())
+        {
+            if (not _queue->waitPop(timeout)) continue;
+
+            //when stopping, the remaining frames are dropped if the window does not open
+            while (not _ep.waitReady(timeout))
+            {
+                if (not _senderRunning) return;
+            }
+
+            auto &frame = _queue->front();
+            try
+            {
+                _ep.send(frame.type, frame.buffer, frame.more);
+            }
+            catch (const Pothos::Exception &ex)
+            {
+                poco_error_f1(_logger, "Sender thread failed: %s", ex.displayText());
+                _senderRunning = false;
+                return;
+            }
+            _queue->pop();
         }
     }
 
+    void stopSender(void)
+    {
+        if (not senderThread.joinable()) return;
+        _senderRunning = false;
+        _queue->interrupt();
+        senderThread.join();
+        _queue.reset();
+    }
+
     void work(void);
 
+    void workChannel(Pothos::InputPort *inputPort);
+
+    void workAsyncChannel(Pothos::InputPort *inputPort);
+
+    size_t sendMessagesAndLabels(Pothos::InputPort *inputPort);
+
+    void sendBuffer(Pothos::InputPort *inputPort, const size_t numElems);
+
+    //free frames in the asynchronous send queue or in the queues of blocking subscribers, unlimited otherwise
+    size_t queueSpace(void) const
+    {
+        size_t space = std::numeric_limits<size_t>::max();
+        if (_queue) space = _queue->capacity() - _queue->size();
+        if (_publishing and _policy == POLICY_BLOCK) for (const auto &subscriber : _subscribers)
+        {
+            space = std::min(space, subscriber->space(_queueDepth));
+        }
+        return space;
+    }
+
+    size_t numChannels(void) const
+    {
+        return _lastDtypes.size();
+    }
+
+    //a channel without credit from the mux source waits, the other channels continue
+    bool channelReady(void) const
+    {
+        if (this->numChannels() == 1) return true;
+        return _channelSent[_channel] < _channelAcked[_channel] + _channelWindow;
+    }
+
+    //send directly in synchronous mode, otherwise queue the frame
+    void sendFrame(const uint16_t type, const Pothos::BufferChunk &buffer, const bool more = false)
+    {
+        if (type == PothosPacketTypeBuffer or type == PothosPacketTypePayload) _channelSent[_channel] += buffer.length;
+        const auto channelType = PothosPacketChannelType(type, _channel);
+        if (_publishing)
+        {
+            const NetworkSinkFrame frame(channelType, buffer, more);
+            for (const auto &subscriber : _subscribers) subscriber->push(frame, _policy, _queueDepth);
+        }
+        else if (_queue)
+        {
+            const bool ok = _queue->push(NetworkSinkFrame(channelType, buffer, more));
+            assert(ok); (void)ok; //space is checked by workAsyncChannel()
+        }
+        else _ep.send(channelType, buffer, more);
+    }
+
+    //queued frames need their own copy of the encoded bytes
+    void sendEncoded(const uint16_t type, const bool more)
+    {
+        if (not _queue and not _publishing and _coalesceBytes != 0) return this->coalesceEncoded(type);
+        if (not _queue and not _publishing) return _ep.send(PothosPacketChannelType(type, _channel), _encoder.data(), _encoder.size(), more);
+        Pothos::BufferChunk buffer(_encoder.size());
+        std::memcpy(buffer.as<void *>(), _encoder.data(), _encoder.size());
+        this->sendFrame(type, buffer, more);
+    }
+
+    //gather the frame to go out in front of the next send
+    void coalesceEncoded(const uint16_t type)
+    {
+        if (_ep.queuedBytes() == 0) _coalesceStart = std::chrono::high_resolution_clock::now();
+        _ep.queue(PothosPacketChannelType(type, _channel), _encoder.data(), _encoder.size());
+        if (_ep.queuedBytes() >= _coalesceBytes) _ep.flush();
+    }
+
+    //send the gathered frames once they waited for the delay,
+    //or right away when no pending input could join them
+    void flushCoalesced(void)
+    {
+        if (_ep.queuedBytes() == 0) return;
+        bool pending = false;
+        for (auto inputPort : this->inputs())
+        {
+            pending = pending or inputPort->hasMessage() or inputPort->elements() != 0;
+        }
+        if (not pending or std::chrono::high_resolution_clock::now() - _coalesceStart >= _coalesceDelay) _ep.flush();
+    }
+
     void updateDType(const Pothos::DType &dtype)
     {
-        if (_lastDtype == dtype) return;
-        std::ostringstream oss;
-        Pothos::Object(dtype).serialize(oss);
-        _ep.send(PothosPacketTypeDType, oss.str().data(), oss.str().length(), true);
-        _lastDtype = dtype;
+        auto &lastDtype = _lastDtypes[_channel];
+        if (lastDtype == dtype) return;
+        this->sendEncoded(PothosPacketTypeDTypeCompact, PothosPacketTypeDType, dtype, true);
+        lastDtype = dtype;
+    }
+
+    //encode with the compact codec when possible, otherwise serialize
+    template <typename T>
+    void sendEncoded(const uint16_t compactType, const uint16_t type, const T &value, const bool more = false)
+    {
+        _encoder.clear();
+        if (_compact and _encoder.encode(value))
+        {
+            return this->sendEncoded(compactType, more);
+        }
+        _encoder.clear();
+        _encoder.serialize(Pothos::Object(value));
+        this->sendEncoded(type, more);
     }
 
 private:
     PothosPacketSocketEndpoint _ep;
     std::thread handlerThread;
     bool running;
-    Pothos::DType _lastDtype;
+    std::vector<Pothos::DType> _lastDtypes;
+    bool _compact;
+    PothosPacketEncoder _encoder;
+
+    //per-channel flow control
+    size_t _channel; //the channel being serialized
+    unsigned long long _channelWindow;
+    std::vector<unsigned long long> _channelSent;
+    std::vector<size_t> _labelsQueued; //labels at the front of the input that were already sent
+    std::unique_ptr<std::atomic<unsigned long long>[]> _channelAcked;
+
+    //publisher mode
+    const bool _publishing;
+    NetworkSinkPolicy _policy;
+    bool _zeroCopy;
+    std::list<std::unique_ptr<NetworkSinkSubscriber>> _subscribers;
+    std::list<std::unique_ptr<NetworkSinkSubscriber>> _pending; //accepted, not yet in the stream
+    std::mutex _pendingMutex;
+    std::atomic<size_t> _subscriberCount;
+    std::atomic<unsigned long long> _dropCount;
+    unsigned long long _dropCountRemoved; //drops by subscribers that are gone
+
+    //asynchronous sender
+    static const size_t MIN_QUEUE_DEPTH = 4; //header, dtype, payload + 1
+    bool _asyncSend;
+    size_t _queueDepth;
+    std::unique_ptr<SpscQueue<NetworkSinkFrame>> _queue;
+    std::atomic<bool> _senderRunning;
+    std::thread senderThread;
+
+    //frame coalescing
+    size_t _coalesceBytes;
+    std::chrono::high_resolution_clock::duration _coalesceDelay;
+    std::chrono::high_resolution_clock::time_point _coalesceStart;
+    Poco::Logger &_logger;
 };
 
 void NetworkSink::work(void)
 {
-    if (not _ep.isReady())
+    if (_publishing) return this->workPublish();
+
+    const auto timeout = std::chrono::nanoseconds(this->workInfo().maxTimeoutNs);
+    if (_queue)
     {
-        std::this_thread::sleep_for(std::chrono::nanoseconds(this->workInfo().maxTimeoutNs));
-        return this->yield();
+        if (not _senderRunning) throw Pothos::RuntimeException("NetworkSink::work()", "sender thread stopped");
+
+        //backpressure: wait for the sender thread to drain the queue
+        if (not _queue->waitPush(timeout, MIN_QUEUE_DEPTH)) return this->yield();
     }
 
-    auto inputPort = this->input(0);
+    //wait for window credit from the remote endpoint
+    else if (not _ep.waitReady(timeout)) return this->yield();
 
-    //serialize messages
-    while (inputPort->hasMessage())
+    //serialize each channel that has credit, the others are skipped
+    bool blocked = false;
+    for (auto inputPort : this->inputs())
+    {
+        _channel = size_t(inputPort->index());
+        if (not this->channelReady())
+        {
+            blocked = blocked or inputPort->hasMessage() or inputPort->elements() != 0;
+            continue;
+        }
+        if (_queue) this->workAsyncChannel(inputPort);
+        else this->workChannel(inputPort);
+    }
+    this->flushCoalesced();
+
+    //come back for the channels that wait on credit from the mux source
+    if (blocked) this->yield();
+}
+
+void NetworkSink::workPublish(void)
+{
+    const auto timeout = std::chrono::nanoseconds(this->workInfo().maxTimeoutNs);
+
+    //remove the subscribers that closed or were disconnected
+    unsigned long long dropCount = 0;
+    for (auto it = _subscribers.begin(); it != _subscribers.end();)
+    {
+        if ((*it)->isConnected()) dropCount += (*it++)->dropped();
+        else
+        {
+            _dropCountRemoved += (*it)->dropped();
+            it = _subscribers.erase(it);
+        }
+    }
+
+    //new subscribers join between frame groups, starting with the current data types
+    {
+        std::lock_guard<std::mutex> lock(_pendingMutex);
+        for (auto &subscriber : _pending)
+        {
+            for (size_t i = 0; i < this->numChannels(); i++)
+            {
+                if (_lastDtypes[i] == Pothos::DType()) continue;
+                _encoder.clear();
+                _encoder.encode(_lastDtypes[i]);
+                Pothos::BufferChunk buffer(_encoder.size());
+                std::memcpy(buffer.as<void *>(), _encoder.data(), _encoder.size());
+                subscriber->push(NetworkSinkFrame(PothosPacketChannelType(PothosPacketTypeDTypeCompact, i), buffer, false), POLICY_BLOCK, _queueDepth);
+            }
+            _subscribers.push_back(std::move(subscriber));
+        }
+        _pending.clear();
+        _subscriberCount = _subscribers.size();
+    }
+    _dropCount = _dropCountRemoved + dropCount;
+
+    //backpressure: blocking subscribers need room for a frame group
+    if (_policy == POLICY_BLOCK) for (const auto &subscriber : _subscribers)
+    {
+        if (not subscriber->waitSpace(_queueDepth-MIN_QUEUE_DEPTH+1, timeout)) return this->yield();
+    }
+
+    //each frame is encoded once and queued to every subscriber,
+    //blocking subscribers limit the frames to the space left in their queues
+    for (auto inputPort : this->inputs())
+    {
+        _channel = size_t(inputPort->index());
+        this->workAsyncChannel(inputPort);
+    }
+}
+
+void NetworkSink::workChannel(Pothos::InputPort *inputPort)
+{
+    const size_t numElems = this->sendMessagesAndLabels(inputPort);
+    if (numElems != 0) this->sendBuffer(inputPort, numElems);
+}
+
+void NetworkSink::workAsyncChannel(Pothos::InputPort *inputPort)
+{
+    const size_t numElems = this->sendMessagesAndLabels(inputPort);
+
+    //come back when the queue drains to handle the remaining input
+    if (inputPort->hasMessage() or numElems < inputPort->elements()) this->yield();
+
+    //queue a reference to the available buffer (dtype and buffer frames)
+    if (numElems == 0) return;
+    if (this->queueSpace() < 2) return this->yield();
+    this->sendBuffer(inputPort, numElems);
+}
+
+/***********************************************************************
+ * Serialize the messages and the labels ahead of the buffer,
+ * limited by the space in the asynchronous send queue.
+ * Labels are sent before the buffer to ensure ordering at the destination.
+ * Returns the number of elements that can be sent after the labels.
+ **********************************************************************/
+size_t NetworkSink::sendMessagesAndLabels(Pothos::InputPort *inputPort)
+{
+    //serialize messages (a packet uses up to 3 frames)
+    while (inputPort->hasMessage() and this->queueSpace() >= 3)
     {
         const auto msg = inputPort->popMessage();
 
@@ -141,47 +972,63 @@ void NetworkSink::work(void)
             packet.payload = Pothos::BufferChunk();
 
             //send the packet without buffer
-            std::ostringstream oss; Pothos::Object(packet).serialize(oss);
-            _ep.send(PothosPacketTypeHeader, oss.str().data(), oss.str().length(), true);
+            this->sendEncoded(PothosPacketTypeHeaderCompact, PothosPacketTypeHeader, packet, true);
 
             //send the dtype when changed
             this->updateDType(buffer.dtype);
 
             //send the packet buffer
-            _ep.send(PothosPacketTypePayload, buffer.as<const void *>(), buffer.length);
+            this->sendFrame(PothosPacketTypePayload, buffer);
         }
 
         //arbitrary serialization
         else
         {
-            std::ostringstream oss;
-            msg.serialize(oss);
-            _ep.send(PothosPacketTypeMessage, oss.str().data(), oss.str().length());
+            this->sendEncoded(PothosPacketTypeMessageCompact, PothosPacketTypeMessage, msg);
         }
     }
 
-    //serialize labels (all labels are sent before buffers to ensure ordering at the destination)
+    //serialize labels, skipping the ones that were sent on a previous call,
+    //and stop the elements at the first label that does not fit (label, dtype, buffer)
+    size_t numElems = inputPort->elements();
+    size_t labelIndex = 0;
     for (const auto &label : inputPort->labels())
     {
-        if (label.index >= inputPort->elements()) break;
-        std::ostringstream oss;
-        Pothos::Object(label).serialize(oss);
-        _ep.send(PothosPacketTypeLabel, oss.str().data(), oss.str().length());
+        if (label.index >= numElems) break;
+        if (labelIndex++ < _labelsQueued[_channel]) continue;
+        if (this->queueSpace() < 3)
+        {
+            numElems = label.index;
+            break;
+        }
+        this->sendEncoded(PothosPacketTypeLabelCompact, PothosPacketTypeLabel, label);
+        _labelsQueued[_channel]++;
     }
+    return numElems;
+}
 
-    //available buffer?
-    const auto &buffer = inputPort->buffer();
-    if (buffer.length == 0) return;
+void NetworkSink::sendBuffer(Pothos::InputPort *inputPort, const size_t numElems)
+{
+    auto buffer = inputPort->buffer();
+    buffer.length = numElems*buffer.dtype.size();
 
     //send the dtype when changed
     this->updateDType(buffer.dtype);
 
     //send a buffer
+    this->sendFrame(PothosPacketTypeBuffer, buffer);
+
+    //the labels within the consumed elements were all sent
+    for (const auto &label : inputPort->labels())
     {
-        _ep.send(PothosPacketTypeBuffer, buffer.as<const void *>(), buffer.length);
-        inputPort->consume(inputPort->elements());
+        if (label.index >= numElems) break;
+        _labelsQueued[_channel]--;
     }
+    inputPort->consume(numElems);
 }
 
 static Pothos::BlockRegistry registerNetworkSink(
     "/blocks/network_sink", &NetworkSink::make);
+
+static Pothos::BlockRegistry registerNetworkMuxSink(
+    "/blocks/network_mux_sink", &NetworkSink::makeMux);
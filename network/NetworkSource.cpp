@@ -2,10 +2,15 @@
 // SPDX-License-Identifier: BSL-1.0
 
 #include "SocketEndpoint.hpp"
+#include "NetworkCodec.hpp"
 #include <Pothos/Framework.hpp>
+#include <Poco/Logger.h>
+#include <Poco/ByteOrder.h>
 #include <cstring> //std::memset
-#include <sstream>
 #include <string>
+#include <memory>
+#include <atomic>
+#include <vector>
 #include <cassert>
 #include <iostream>
 
@@ -15,8 +20,11 @@
  * The network source deserializes data from the socket and produces on its output port.
  * Socket data encompasses stream buffers, inline labels, and async messages.
  *
- * The underlying supports the tcp transport option:
- * TCP - tcp://host:port
+ * The underlying supports the tcp, udp, unix, and shm transport options:
+ * TCP - tcp://host:port or tcp://host:port?streams=N (striped over N connections)
+ * UDP - udp://host:port or udp://host:port?rate=bytesPerSec (reliable, NAK-based retransmission)
+ * UNIX - unix:///path/to/socket or unix://@name (abstract namespace)
+ * SHM - shm://name or shm://name?size=bytes (shared memory rings, Linux only)
  *
  * |category /Network
  * |category /Sources
@@ -32,22 +40,92 @@
  * |option [Bind] "BIND"
  * |default "DISCONNECT"
  *
+ * |param window[Flow Window] The flow control window size in bytes.
+ * The window is negotiated with the remote endpoint when the connection opens.
+ * Specify 0 to automatically size the window from the measured round trip time and throughput.
+ * A window other than the default also sizes the socket send and receive buffers,
+ * otherwise the buffers are left to the kernel's autotuning.
+ * |units bytes
+ * |default 262144
+ * |preview valid
+ * |tab Advanced
+ *
  * |factory /blocks/network_source(uri, opt)
+ * |setter setFlowControlWindow(window)
+ **********************************************************************/
+
+/***********************************************************************
+ * |PothosDoc Network Mux Source
+ *
+ * The network mux source deserializes the channels of a network mux sink
+ * from a single connection, and produces each channel on the output port of the same index.
+ *
+ * Each channel is received into its own buffers, so that a slow consumer on one channel
+ * does not hold up the other channels. The source returns credit for a channel
+ * to the mux sink as the downstream blocks release the buffers of that channel.
+ *
+ * The transport options are the same as the network source.
+ *
+ * |category /Network
+ * |category /Sources
+ * |keywords source network multiplex channel
+ *
+ * |param uri[URI] The bind or connection uri string.
+ * |default "tcp://0.0.0.0:1234"
+ *
+ * |param opt[Option] Control if the socket is a server (BIND) or client (CONNECT).
+ * |option [Connect] "CONNECT"
+ * |option [Bind] "BIND"
+ * |default "BIND"
+ *
+ * |param numChannels[Num Channels] The number of output ports.
+ * |default 2
+ * |widget SpinBox(minimum=1, maximum=256)
+ * |preview disable
+ *
+ * |param window[Flow Window] The flow control window of the connection in bytes.
+ * Specify 0 to automatically size the window from the measured round trip time and throughput.
+ * |units bytes
+ * |default 262144
+ * |preview valid
+ * |tab Advanced
+ *
+ * |factory /blocks/network_mux_source(uri, opt, numChannels)
+ * |setter setFlowControlWindow(window)
  **********************************************************************/
+
+#define MUX_RECV_BYTES (64*1024) //receive buffer allocated per channel frame
+
+//bytes of each channel released by the downstream blocks
+typedef std::vector<std::atomic<unsigned long long>> NetworkSourceCredits;
 class NetworkSource : public Pothos::Block
 {
 public:
     static Block *make(const std::string &uri, const std::string &opt)
     {
-        return new NetworkSource(uri, opt);
+        return new NetworkSource(uri, opt, 1);
+    }
+
+    static Block *makeMux(const std::string &uri, const std::string &opt, const size_t numChannels)
+    {
+        if (numChannels == 0 or numChannels > PothosPacketMaxChannels) throw Pothos::InvalidArgumentException(
+            "NetworkSource("+std::to_string(numChannels)+")", "channels out of range");
+        return new NetworkSource(uri, opt, numChannels);
     }
 
-    NetworkSource(const std::string &uri, const std::string &opt):
-        _ep(PothosPacketSocketEndpoint(uri, opt))
+    NetworkSource(const std::string &uri, const std::string &opt, const size_t numChannels):
+        _ep(PothosPacketSocketEndpoint(uri, opt)),
+        _lastDtypes(numChannels),
+        _packetHeaders(numChannels),
+        _creditSent(numChannels),
+        _logger(Poco::Logger::get("NetworkSource"))
     {
         //std::cout << "NetworkSource " << opt << " " << uri << std::endl;
-        this->setupOutput(0);
+        for (size_t i = 0; i < numChannels; i++) this->setupOutput(i);
         this->registerCall(this, POTHOS_FCN_TUPLE(NetworkSource, getActualPort));
+        this->registerCall(this, POTHOS_FCN_TUPLE(NetworkSource, setFlowControlWindow));
+        this->registerCall(this, POTHOS_FCN_TUPLE(NetworkSource, flowControlWindow));
+        this->registerProbe("flowControlWindow");
     }
 
     std::string getActualPort(void) const
@@ -55,9 +133,34 @@ public:
         return _ep.getActualPort();
     }
 
+    void setFlowControlWindow(const size_t numBytes)
+    {
+        _ep.setFlowControlWindow(numBytes);
+    }
+
+    size_t flowControlWindow(void) const
+    {
+        return _ep.getFlowControlWindow();
+    }
+
     void activate(void)
     {
         _ep.openComms();
+        if (this->numChannels() > 1 and (_ep.getFeatures() & PothosPacketFeatureChannels) == 0)
+        {
+            _ep.closeComms();
+            throw Pothos::RuntimeException("NetworkSource::activate()", "remote endpoint does not support channels");
+        }
+        for (size_t i = 0; i < this->numChannels(); i++)
+        {
+            _lastDtypes[i] = Pothos::DType();
+            _creditSent[i] = 0;
+        }
+
+        //buffers from a previous activation credit the old counters
+        _credits.reset(new NetworkSourceCredits(this->numChannels()));
+        for (auto &credit : *_credits) credit = 0;
+        _muxBuffer = Pothos::BufferChunk();
     }
 
     void deactivate(void)
@@ -68,67 +171,148 @@ public:
     void work(void);
 
 private:
+    size_t numChannels(void) const
+    {
+        return _lastDtypes.size();
+    }
+
+    //return credit to the mux sink for the buffers released downstream
+    void sendCredits(void);
+
+    //the buffer calls back with credit when the last reference is released
+    Pothos::BufferChunk creditBuffer(const Pothos::BufferChunk &buffer, const size_t channel);
+
     PothosPacketSocketEndpoint _ep;
-    Pothos::DType _lastDtype;
-    Pothos::Packet _packetHeader;
+    std::vector<Pothos::DType> _lastDtypes;
+    std::vector<Pothos::Packet> _packetHeaders;
+
+    //per-channel flow control
+    std::shared_ptr<NetworkSourceCredits> _credits;
+    std::vector<unsigned long long> _creditSent;
+    Pothos::BufferChunk _muxBuffer;
+    Poco::Logger &_logger;
 };
 
+void NetworkSource::sendCredits(void)
+{
+    for (size_t i = 0; i < this->numChannels(); i++)
+    {
+        const unsigned long long released = (*_credits)[i];
+        if (released == _creditSent[i]) continue;
+        const uint64_t totalN = Poco::ByteOrder::toNetwork(Poco::UInt64(released));
+        _ep.send(PothosPacketChannelType(PothosPacketTypeCredit, i), &totalN, sizeof(totalN));
+        _creditSent[i] = released;
+    }
+}
+
+Pothos::BufferChunk NetworkSource::creditBuffer(const Pothos::BufferChunk &buffer, const size_t channel)
+{
+    auto credits = _credits;
+    const size_t length = buffer.length;
+    std::shared_ptr<void> container(buffer.as<void *>(), [credits, channel, length, buffer](void *){(*credits)[channel] += length;});
+    Pothos::BufferChunk chunk(Pothos::SharedBuffer(buffer.address, buffer.length, container));
+    chunk.dtype = buffer.dtype;
+    return chunk;
+}
+
 void NetworkSource::work(void)
 {
     const auto timeoutNanos = std::chrono::nanoseconds(this->workInfo().maxTimeoutNs);
     const auto timeout = std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(timeoutNanos);
 
-    auto outputPort = this->output(0);
+    //multiplexed channels receive into their own buffers and return credit
+    const bool mux = this->numChannels() > 1;
+    if (mux)
+    {
+        this->sendCredits();
+        if (_muxBuffer.length == 0) _muxBuffer = Pothos::BufferChunk(MUX_RECV_BYTES);
+    }
 
     //recv the header, use output buffer when possible for zero-copy
     uint16_t type = 0;
-    auto buffer = outputPort->buffer();
+    auto buffer = mux?_muxBuffer:this->output(0)->buffer();
     _ep.recv(type, buffer, timeout);
 
+    //the upper byte of the type selects the channel
+    const size_t channel = type >> 8;
+    type &= 0xff;
+    if (channel >= this->numChannels())
+    {
+        poco_error_f2(_logger, "Dropped frame for channel %d, %d channels configured", int(channel), int(this->numChannels()));
+        return this->yield();
+    }
+    auto outputPort = this->output(channel);
+    auto &lastDtype = _lastDtypes[channel];
+    auto &packetHeader = _packetHeaders[channel];
+
     //handle the output
     if (type == PothosPacketTypeBuffer)
     {
-        buffer.dtype = _lastDtype;
-        outputPort->popElements(buffer.length);
+        //the transport may provide its own buffer, only pop the output port buffer
+        buffer.dtype = lastDtype;
+        if (mux)
+        {
+            if (buffer.length != 0) outputPort->postBuffer(this->creditBuffer(buffer, channel));
+            _muxBuffer = Pothos::BufferChunk();
+            return this->yield();
+        }
+        if (buffer.address == outputPort->buffer().address) outputPort->popElements(buffer.length);
         outputPort->postBuffer(std::move(buffer));
     }
     else if (type == PothosPacketTypeMessage)
     {
-        std::istringstream iss(std::string(buffer.as<char *>(), buffer.length));
-        Pothos::Object msg;
-        msg.deserialize(iss);
+        auto msg = PothosPacketDecoder(buffer.as<const void *>(), buffer.length).deserialize();
+        outputPort->postMessage(std::move(msg));
+    }
+    else if (type == PothosPacketTypeMessageCompact)
+    {
+        auto msg = PothosPacketDecoder(buffer.as<const void *>(), buffer.length).object();
         outputPort->postMessage(std::move(msg));
     }
     else if (type == PothosPacketTypeHeader)
     {
-        std::istringstream iss(std::string(buffer.as<char *>(), buffer.length));
-        Pothos::Object msg; msg.deserialize(iss);
-        _packetHeader = std::move(msg.ref<Pothos::Packet>()); //store it, payload comes next
+        auto msg = PothosPacketDecoder(buffer.as<const void *>(), buffer.length).deserialize();
+        packetHeader = std::move(msg.ref<Pothos::Packet>()); //store it, payload comes next
+    }
+    else if (type == PothosPacketTypeHeaderCompact)
+    {
+        packetHeader = PothosPacketDecoder(buffer.as<const void *>(), buffer.length).packet(); //store it, payload comes next
     }
     else if (type == PothosPacketTypePayload)
     {
         //since this is not PothosPacketTypeBuffer, recv may have allocated a new buffer
         //only pop if this is really the buffer from the output port
-        if (buffer.address == outputPort->buffer().address) outputPort->popElements(buffer.length);
-
-        buffer.dtype = _lastDtype;
-        _packetHeader.payload = buffer;
-        outputPort->postMessage(std::move(_packetHeader));
+        buffer.dtype = lastDtype;
+        if (mux)
+        {
+            packetHeader.payload = this->creditBuffer(buffer, channel);
+            _muxBuffer = Pothos::BufferChunk();
+        }
+        else
+        {
+            if (buffer.address == outputPort->buffer().address) outputPort->popElements(buffer.length);
+            packetHeader.payload = buffer;
+        }
+        outputPort->postMessage(std::move(packetHeader));
     }
     else if (type == PothosPacketTypeLabel)
     {
-        std::istringstream iss(std::string(buffer.as<char *>(), buffer.length));
-        Pothos::Object data;
-        data.deserialize(iss);
+        auto data = PothosPacketDecoder(buffer.as<const void *>(), buffer.length).deserialize();
         auto &label = data.ref<Pothos::Label>();
         outputPort->postLabel(std::move(label));
     }
+    else if (type == PothosPacketTypeLabelCompact)
+    {
+        outputPort->postLabel(PothosPacketDecoder(buffer.as<const void *>(), buffer.length).label());
+    }
     else if (type == PothosPacketTypeDType)
     {
-        std::istringstream iss(std::string(buffer.as<char *>(), buffer.length));
-        Pothos::Object data;
-        data.deserialize(iss);
-        _lastDtype = std::move(data.ref<Pothos::DType>());
+        auto data = PothosPacketDecoder(buffer.as<const void *>(), buffer.length).deserialize();
+        lastDtype = std::move(data.ref<Pothos::DType>());
+    }
+    else if (type == PothosPacketTypeDTypeCompact)
+    {
+        lastDtype = PothosPacketDecoder(buffer.as<const void *>(), buffer.length).dtype();
     }
 
     return this->yield(); //always yield to service recv() again
@@ -136,3 +320,6 @@ void NetworkSource::work(void)
 
 static Pothos::BlockRegistry registerNetworkSource(
     "/blocks/network_source", &NetworkSource::make);
+
+static Pothos::BlockRegistry registerNetworkMuxSource(
+    "/blocks/network_mux_source", &NetworkSource::makeMux);
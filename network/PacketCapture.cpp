@@ -0,0 +1,395 @@
+// Copyright (c) 2016-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#ifdef __linux__
+
+#include <Pothos/Framework.hpp>
+#include <Poco/Logger.h>
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <net/if.h>
+#include <arpa/inet.h> //htons
+#include <linux/if_packet.h>
+#include <linux/if_ether.h>
+#include <linux/filter.h>
+#include <unistd.h>
+#include <poll.h>
+#include <cerrno>
+#include <cstring> //strerror
+#include <algorithm> //min/max
+#include <memory>
+#include <vector>
+
+#define CAPTURE_SNAP_BYTES 0x40000 //capture the whole packet
+#define CAPTURE_FRAME_BYTES TPACKET_ALIGNMENT*128 //frame size hint, frames are variable length in TPACKET_V3
+#define CAPTURE_BLOCK_TIMEOUT_MS 10 //partially filled blocks are retired to user space
+
+/***********************************************************************
+ * |PothosDoc Packet Capture
+ *
+ * The packet capture block passively taps UDP datagrams for a destination port
+ * on a network interface, and produces the UDP payloads on output port 0.
+ * It does not bind the port, so it can capture traffic that is received
+ * by another socket or application, or traffic that is only passing through.
+ *
+ * The capture uses an AF_PACKET socket with a TPACKET_V3 ring of memory blocks
+ * that is shared with the kernel, and a BPF filter for the destination port,
+ * so that only matching datagrams are placed in the ring.
+ * The payloads are produced as buffers that reference the ring memory,
+ * without any copy, and each block of the ring is handed back to the kernel
+ * once every payload in that block has been released downstream.
+ * The ring should be sized so that downstream does not hold every block,
+ * otherwise the kernel drops datagrams which are counted in the "dropped" probe.
+ *
+ * The capture works on any interface, including loopback, veth, and tun devices,
+ * because the link layer header is removed by the kernel (SOCK_DGRAM).
+ * IPv4 and IPv6 datagrams are captured, IP fragments and IPv6 extension headers are skipped.
+ * Datagrams sent by this host are only captured on the loopback interface.
+ *
+ * The packet capture requires Linux, and the CAP_NET_RAW capability (or root).
+ *
+ * |category /Network
+ * |keywords udp datagram packet network capture tap mmap
+ *
+ * |param dtype[Data Type] The output data type.
+ * Sets the data type of the output port and also of the buffer in packet mode.
+ * |widget DTypeChooser(float=1,cfloat=1,int=1,cint=1,uint=1,cuint=1,dim=1)
+ * |default "complex_float32"
+ * |preview disable
+ *
+ * |param iface[Interface] The name of the network interface to capture on.
+ * An empty name captures on all interfaces.
+ * |default "lo"
+ * |widget StringEntry()
+ *
+ * |param port[Port] The UDP destination port to capture, or 0 for all UDP datagrams.
+ * |default 1234
+ *
+ * |param mode[Mode] The output mode (stream or packets).
+ * <ul>
+ * <li>"STREAM" - Produce the captured payloads as a sample stream.</li>
+ * <li>"PACKET" - Preserve the datagram boundaries and produce Pothos::Packet.</li>
+ * </ul>
+ * |default "STREAM"
+ * |option [Stream] "STREAM"
+ * |option [Packet] "PACKET"
+ *
+ * |param timestamps[Timestamps] Attach the kernel capture time to each datagram.
+ * The time is in nanoseconds since the epoch (CLOCK_REALTIME).
+ * In the "STREAM" mode, the time is an "rxTime" label on the first element of the payload.
+ * In the "PACKET" mode, the time is the "rxTime" entry in the packet metadata.
+ * |default false
+ * |option [Disabled] false
+ * |option [Enabled] true
+ * |preview valid
+ *
+ * |param blockSize[Block Size] The size of each memory block in the ring.
+ * Must be a multiple of the page size.
+ * |default 262144
+ * |units bytes
+ * |tab Ring
+ * |preview valid
+ *
+ * |param numBlocks[Num Blocks] The number of memory blocks in the ring.
+ * |default 64
+ * |tab Ring
+ * |preview valid
+ *
+ * |factory /blocks/packet_capture(dtype)
+ * |initializer setupCapture(iface, port, blockSize, numBlocks)
+ * |setter setMode(mode)
+ * |setter setTimestamps(timestamps)
+ **********************************************************************/
+
+//! The mapped ring and socket, shared with the buffers that reference the ring
+struct PacketCaptureRing
+{
+    PacketCaptureRing(void):
+        fd(-1),
+        mem(MAP_FAILED),
+        blockSize(0),
+        numBlocks(0)
+    {
+        return;
+    }
+
+    ~PacketCaptureRing(void)
+    {
+        if (mem != MAP_FAILED) ::munmap(mem, blockSize*numBlocks);
+        if (fd >= 0) ::close(fd);
+    }
+
+    struct tpacket_block_desc *block(const size_t i) const
+    {
+        return reinterpret_cast<struct tpacket_block_desc *>(reinterpret_cast<char *>(mem) + i*blockSize);
+    }
+
+    int fd;
+    void *mem;
+    size_t blockSize;
+    size_t numBlocks;
+};
+
+class PacketCapture : public Pothos::Block
+{
+public:
+    static Block *make(const Pothos::DType &dtype)
+    {
+        return new PacketCapture(dtype);
+    }
+
+    PacketCapture(const Pothos::DType &dtype):
+        _logger(Poco::Logger::get("PacketCapture")),
+        _port(0),
+        _packetMode(false),
+        _timestamps(false),
+        _blockIndex(0),
+        _dropped(0)
+    {
+        this->setupOutput(0, dtype);
+        this->registerCall(this, POTHOS_FCN_TUPLE(PacketCapture, setupCapture));
+        this->registerCall(this, POTHOS_FCN_TUPLE(PacketCapture, setMode));
+        this->registerCall(this, POTHOS_FCN_TUPLE(PacketCapture, setTimestamps));
+        this->registerCall(this, POTHOS_FCN_TUPLE(PacketCapture, dropped));
+        this->registerProbe("dropped");
+    }
+
+    void setupCapture(const std::string &iface, const unsigned short port, const size_t blockSize, const size_t numBlocks)
+    {
+        const std::string what("PacketCapture::setupCapture("+iface+":"+std::to_string(port)+")");
+        const size_t pageSize = size_t(::sysconf(_SC_PAGESIZE));
+        if (blockSize == 0 or (blockSize % pageSize) != 0) throw Pothos::InvalidArgumentException(what, "block size must be a multiple of the page size");
+        if (numBlocks == 0) throw Pothos::InvalidArgumentException(what, "need at least one block");
+
+        std::shared_ptr<PacketCaptureRing> ring(new PacketCaptureRing());
+        ring->fd = ::socket(AF_PACKET, SOCK_DGRAM, htons(ETH_P_ALL));
+        if (ring->fd < 0) throw Pothos::RuntimeException(what, "socket(AF_PACKET) failed (requires CAP_NET_RAW): " + std::string(strerror(errno)));
+
+        //only the datagrams for the port are placed in the ring
+        this->attachFilter(ring->fd, port, what);
+
+        //setup the TPACKET_V3 ring of variable length frames
+        const int version = TPACKET_V3;
+        if (::setsockopt(ring->fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0)
+        {
+            throw Pothos::RuntimeException(what, "TPACKET_V3 not supported: " + std::string(strerror(errno)));
+        }
+        struct tpacket_req3 req;
+        std::memset(&req, 0, sizeof(req));
+        req.tp_block_size = unsigned(blockSize);
+        req.tp_block_nr = unsigned(numBlocks);
+        req.tp_frame_size = unsigned(std::min<size_t>(CAPTURE_FRAME_BYTES, blockSize));
+        req.tp_frame_nr = unsigned((blockSize/req.tp_frame_size)*numBlocks);
+        req.tp_retire_blk_tov = CAPTURE_BLOCK_TIMEOUT_MS;
+        if (::setsockopt(ring->fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) != 0)
+        {
+            throw Pothos::RuntimeException(what, "PACKET_RX_RING failed: " + std::string(strerror(errno)));
+        }
+        ring->mem = ::mmap(nullptr, blockSize*numBlocks, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, ring->fd, 0);
+        if (ring->mem == MAP_FAILED) ring->mem = ::mmap(nullptr, blockSize*numBlocks, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+        if (ring->mem == MAP_FAILED) throw Pothos::RuntimeException(what, "mmap() failed: " + std::string(strerror(errno)));
+        ring->blockSize = blockSize;
+        ring->numBlocks = numBlocks;
+
+        //bind to the interface, or capture on all interfaces
+        struct sockaddr_ll addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sll_family = AF_PACKET;
+        addr.sll_protocol = htons(ETH_P_ALL);
+        if (not iface.empty())
+        {
+            addr.sll_ifindex = int(::if_nametoindex(iface.c_str()));
+            if (addr.sll_ifindex == 0) throw Pothos::InvalidArgumentException(what, "unknown interface");
+        }
+        if (::bind(ring->fd, reinterpret_cast<const struct sockaddr *>(&addr), sizeof(addr)) != 0)
+        {
+            throw Pothos::RuntimeException(what, "bind() failed: " + std::string(strerror(errno)));
+        }
+
+        _ring = ring;
+        _port = port;
+        _blockIndex = 0;
+    }
+
+    void setMode(const std::string &mode)
+    {
+        if (mode == "STREAM") _packetMode = false;
+        else if (mode == "PACKET") _packetMode = true;
+        else throw Pothos::InvalidArgumentException("PacketCapture::setMode("+mode+")", "unknown mode");
+    }
+
+    void setTimestamps(const bool enable)
+    {
+        _timestamps = enable;
+    }
+
+    unsigned long long dropped(void)
+    {
+        this->updateStats();
+        return _dropped;
+    }
+
+    void activate(void)
+    {
+        if (not _ring) throw Pothos::RuntimeException("PacketCapture::activate()", "capture not setup");
+    }
+
+    void work(void)
+    {
+        //wait for the kernel to retire the next block to user space
+        auto desc = _ring->block(_blockIndex);
+        if ((__atomic_load_n(&desc->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0)
+        {
+            struct pollfd pfd;
+            pfd.fd = _ring->fd;
+            pfd.events = POLLIN | POLLERR;
+            pfd.revents = 0;
+            ::poll(&pfd, 1, int(this->workInfo().maxTimeoutNs/1000000));
+            if ((__atomic_load_n(&desc->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0) return this->yield();
+        }
+
+        //every payload references the block, which returns to the kernel when the last reference is released
+        auto ring = _ring;
+        std::shared_ptr<void> container(desc, [ring](void *p)
+        {
+            auto desc = reinterpret_cast<struct tpacket_block_desc *>(p);
+            __atomic_store_n(&desc->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        });
+
+        auto outPort = this->output(0);
+        const size_t elemSize = outPort->dtype().size();
+        auto frame = reinterpret_cast<const char *>(desc) + desc->hdr.bh1.offset_to_first_pkt;
+        for (unsigned i = 0; i < desc->hdr.bh1.num_pkts; i++)
+        {
+            auto hdr = reinterpret_cast<const struct tpacket3_hdr *>(frame);
+            auto sll = reinterpret_cast<const struct sockaddr_ll *>(frame + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+            const auto next = frame + hdr->tp_next_offset;
+
+            //loopback shows every datagram twice, skip the outgoing copy
+            if (sll->sll_pkttype == PACKET_OUTGOING)
+            {
+                frame = next;
+                continue;
+            }
+
+            size_t payloadOffset = 0, payloadLength = 0;
+            if (this->parseUdp(reinterpret_cast<const uint8_t *>(frame + hdr->tp_net), hdr->tp_snaplen, payloadOffset, payloadLength))
+            {
+                if ((payloadLength % elemSize) != 0)
+                {
+                    poco_warning_f2(_logger,
+                        "Captured %d bytes is not a multiple of the output size: %s.\n"
+                        "Until the sender is fixed, expect possible truncation of data.",
+                        int(payloadLength), outPort->dtype().toString());
+                }
+                Pothos::BufferChunk payload(Pothos::SharedBuffer(size_t(frame + hdr->tp_net + payloadOffset), payloadLength, container));
+                payload.dtype = outPort->dtype();
+                const long long rxTime = _timestamps?((long long)(hdr->tp_sec)*1000000000 + hdr->tp_nsec):0;
+
+                if (_packetMode)
+                {
+                    Pothos::Packet pkt;
+                    pkt.payload = std::move(payload);
+                    if (rxTime != 0) pkt.metadata["rxTime"] = Pothos::Object(rxTime);
+                    outPort->postMessage(std::move(pkt));
+                }
+                else if ((payload.length = (payloadLength/elemSize)*elemSize) != 0)
+                {
+                    if (rxTime != 0) outPort->postLabel(Pothos::Label("rxTime", Pothos::Object(rxTime), 0));
+                    outPort->postBuffer(std::move(payload));
+                }
+            }
+            frame = next;
+        }
+
+        _blockIndex = (_blockIndex + 1) % _ring->numBlocks;
+    }
+
+private:
+
+    /*******************************************************************
+     * BPF filter for UDP datagrams to the port, the program runs on the
+     * network header because the link layer header is removed.
+     ******************************************************************/
+    void attachFilter(const int fd, const unsigned short port, const std::string &what)
+    {
+        //port 0 matches any port (A >= 0)
+        const unsigned short portOp = (port == 0)?(BPF_JMP|BPF_JGE|BPF_K):(BPF_JMP|BPF_JEQ|BPF_K);
+        struct sock_filter code[] = {
+            /*0*/ BPF_STMT(BPF_LD|BPF_B|BPF_ABS, 0), //IP version
+            /*1*/ BPF_STMT(BPF_ALU|BPF_AND|BPF_K, 0xf0),
+            /*2*/ BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0x40, 0, 7), //IPv4 or goto 10
+            /*3*/ BPF_STMT(BPF_LD|BPF_B|BPF_ABS, 9), //IPv4 protocol
+            /*4*/ BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, IPPROTO_UDP, 0, 11),
+            /*5*/ BPF_STMT(BPF_LD|BPF_H|BPF_ABS, 6), //fragment offset
+            /*6*/ BPF_JUMP(BPF_JMP|BPF_JSET|BPF_K, 0x1fff, 9, 0),
+            /*7*/ BPF_STMT(BPF_LDX|BPF_B|BPF_MSH, 0), //IPv4 header length
+            /*8*/ BPF_STMT(BPF_LD|BPF_H|BPF_IND, 2), //UDP destination port
+            /*9*/ BPF_JUMP(portOp, port, 5, 6),
+            /*10*/ BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, 0x60, 0, 5), //IPv6
+            /*11*/ BPF_STMT(BPF_LD|BPF_B|BPF_ABS, 6), //IPv6 next header
+            /*12*/ BPF_JUMP(BPF_JMP|BPF_JEQ|BPF_K, IPPROTO_UDP, 0, 3),
+            /*13*/ BPF_STMT(BPF_LD|BPF_H|BPF_ABS, 40+2), //UDP destination port
+            /*14*/ BPF_JUMP(portOp, port, 0, 1),
+            /*15*/ BPF_STMT(BPF_RET|BPF_K, CAPTURE_SNAP_BYTES), //accept
+            /*16*/ BPF_STMT(BPF_RET|BPF_K, 0), //reject
+        };
+        struct sock_fprog prog;
+        prog.len = sizeof(code)/sizeof(code[0]);
+        prog.filter = code;
+        if (::setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog)) != 0)
+        {
+            throw Pothos::RuntimeException(what, "SO_ATTACH_FILTER failed: " + std::string(strerror(errno)));
+        }
+    }
+
+    //locate the UDP payload in an IPv4 or IPv6 datagram, false when it does not match
+    bool parseUdp(const uint8_t *p, const size_t length, size_t &payloadOffset, size_t &payloadLength) const
+    {
+        size_t udpOffset = 0;
+        if (length >= 20 and (p[0] >> 4) == 4)
+        {
+            if (p[9] != IPPROTO_UDP) return false;
+            if ((((p[6] << 8) | p[7]) & 0x3fff) != 0) return false; //fragment
+            udpOffset = size_t(p[0] & 0xf)*4;
+        }
+        else if (length >= 40 and (p[0] >> 4) == 6)
+        {
+            if (p[6] != IPPROTO_UDP) return false;
+            udpOffset = 40;
+        }
+        else return false;
+
+        if (length < udpOffset+8) return false;
+        const uint8_t *udp = p + udpOffset;
+        if (_port != 0 and ((udp[2] << 8) | udp[3]) != _port) return false;
+        const size_t udpLength = size_t((udp[4] << 8) | udp[5]);
+        if (udpLength < 8) return false;
+        payloadOffset = udpOffset+8;
+        payloadLength = std::min(udpLength, length-udpOffset)-8;
+        return true;
+    }
+
+    void updateStats(void)
+    {
+        if (not _ring) return;
+        struct tpacket_stats_v3 stats;
+        socklen_t len = sizeof(stats);
+        std::memset(&stats, 0, sizeof(stats));
+        if (::getsockopt(_ring->fd, SOL_PACKET, PACKET_STATISTICS, &stats, &len) != 0) return;
+        _dropped += stats.tp_drops; //the statistics reset when read
+    }
+
+    Poco::Logger &_logger;
+    std::shared_ptr<PacketCaptureRing> _ring;
+    unsigned short _port;
+    bool _packetMode;
+    bool _timestamps;
+    size_t _blockIndex;
+    unsigned long long _dropped;
+};
+
+static Pothos::BlockRegistry registerPacketCapture(
+    "/blocks/packet_capture", &PacketCapture::make);
+
+#endif //__linux__
@@ -0,0 +1,312 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#ifdef __linux__
+
+#include "SharedMemoryRing.hpp"
+#include <Pothos/Exception.hpp>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <ctime>
+#include <cerrno>
+#include <cstring> //strerror
+#include <atomic>
+#include <algorithm> //min/max
+#include <new>
+
+/***********************************************************************
+ * Shared segment layout:
+ * A header page with the ring controls, followed by two rings.
+ * Ring 0 carries client to server, and ring 1 server to client.
+ **********************************************************************/
+static const uint32_t SharedMemoryRingMagic = 0x50544853; //"PTHS"
+
+struct SharedMemoryRingControl
+{
+    //written by the writer
+    alignas(64) std::atomic<uint64_t> head;
+    std::atomic<uint32_t> dataSeq;
+    std::atomic<uint32_t> closed;
+
+    //written by the reader
+    alignas(64) std::atomic<uint64_t> tail;
+    std::atomic<uint32_t> spaceSeq;
+
+    //blocked waiters that need a wake
+    alignas(64) std::atomic<uint32_t> dataWaiters;
+    std::atomic<uint32_t> spaceWaiters;
+};
+
+struct SharedMemorySegmentHeader
+{
+    std::atomic<uint32_t> magic;
+    uint64_t ringSize;
+    SharedMemoryRingControl rings[2];
+};
+
+/***********************************************************************
+ * Futex helpers for process shared wait/wake
+ **********************************************************************/
+static void futexWait(std::atomic<uint32_t> &word, const uint32_t value, const std::chrono::high_resolution_clock::duration &timeout)
+{
+    const auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+    if (nanos <= 0) return;
+    struct timespec ts;
+    ts.tv_sec = time_t(nanos/1000000000);
+    ts.tv_nsec = long(nanos%1000000000);
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAIT, value, &ts, nullptr, 0);
+}
+
+static void futexWake(std::atomic<uint32_t> &word)
+{
+    ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+}
+
+/*!
+ * Wait until the predicate is true or the timeout expires.
+ * The sequence number is sampled before checking the predicate,
+ * so a change after the check causes the futex wait to return.
+ */
+template <typename Pred>
+static bool futexWaitFor(std::atomic<uint32_t> &seq, std::atomic<uint32_t> &waiters, const std::chrono::high_resolution_clock::duration &timeout, Pred pred)
+{
+    const auto exitTime = std::chrono::high_resolution_clock::now() + timeout;
+    while (true)
+    {
+        const uint32_t value = seq.load();
+        waiters++;
+        const bool ready = pred();
+        if (not ready) futexWait(seq, value, exitTime - std::chrono::high_resolution_clock::now());
+        waiters--;
+        if (ready or pred()) return true;
+        if (std::chrono::high_resolution_clock::now() >= exitTime) return false;
+    }
+}
+
+/***********************************************************************
+ * Map a ring twice back to back so every range is contiguous
+ **********************************************************************/
+static char *mapRing(const int fd, const size_t offset, const size_t size)
+{
+    void *base = ::mmap(nullptr, 2*size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return nullptr;
+    char *p = reinterpret_cast<char *>(base);
+    if (::mmap(p, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, off_t(offset)) == MAP_FAILED or
+        ::mmap(p+size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, off_t(offset)) == MAP_FAILED)
+    {
+        ::munmap(base, 2*size);
+        return nullptr;
+    }
+    return p;
+}
+
+/***********************************************************************
+ * Segment setup and teardown
+ **********************************************************************/
+std::shared_ptr<SharedMemoryRing> SharedMemoryRing::make(const std::string &name, const size_t size, const bool server)
+{
+    return std::shared_ptr<SharedMemoryRing>(new SharedMemoryRing(name, size, server));
+}
+
+SharedMemoryRing::SharedMemoryRing(const std::string &name, const size_t size, const bool server):
+    _name(name),
+    _server(server),
+    _size(0),
+    _fd(-1),
+    _headerBytes(0),
+    _header(nullptr),
+    _txBase(nullptr),
+    _rxBase(nullptr),
+    _tx(nullptr),
+    _rx(nullptr),
+    _readCursor(0)
+{
+    const std::string what("SharedMemoryRing("+name+")");
+    const std::string shmName("/"+name);
+    const size_t pageSize = size_t(::sysconf(_SC_PAGESIZE));
+    _headerBytes = ((sizeof(SharedMemorySegmentHeader) + pageSize - 1)/pageSize)*pageSize;
+
+    //the server creates and sizes the segment, the client finds the size in the header
+    if (server)
+    {
+        _size = std::max<size_t>(((size + pageSize - 1)/pageSize)*pageSize, pageSize);
+        //never unlink an existing segment, it may belong to a live server
+        _fd = ::shm_open(shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (_fd < 0 and errno == EEXIST) throw Pothos::RuntimeException(what,
+            "segment already exists: another server is bound, or remove a stale /dev/shm/"+name);
+        if (_fd < 0) throw Pothos::RuntimeException(what, "shm_open() failed: " + std::string(strerror(errno)));
+        if (::ftruncate(_fd, off_t(_headerBytes + 2*_size)) != 0)
+        {
+            const std::string err(strerror(errno));
+            ::close(_fd);
+            ::shm_unlink(shmName.c_str());
+            throw Pothos::RuntimeException(what, "ftruncate() failed: " + err);
+        }
+    }
+    else
+    {
+        _fd = ::shm_open(shmName.c_str(), O_RDWR, 0600);
+        if (_fd < 0) throw Pothos::RuntimeException(what, "shm_open() failed: " + std::string(strerror(errno)));
+    }
+
+    _header = ::mmap(nullptr, _headerBytes, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    if (_header == MAP_FAILED)
+    {
+        const std::string err(strerror(errno));
+        ::close(_fd);
+        if (server) ::shm_unlink(shmName.c_str());
+        throw Pothos::RuntimeException(what, "mmap() failed: " + err);
+    }
+    auto header = reinterpret_cast<SharedMemorySegmentHeader *>(_header);
+
+    if (server)
+    {
+        //the new segment is zero filled, construct the controls in place
+        header->ringSize = _size;
+        for (auto &ring : header->rings) new (&ring) SharedMemoryRingControl();
+        header->magic.store(SharedMemoryRingMagic);
+    }
+    else if (header->magic.load() != SharedMemoryRingMagic)
+    {
+        ::munmap(_header, _headerBytes);
+        ::close(_fd);
+        throw Pothos::RuntimeException(what, "segment is not initialized");
+    }
+    else _size = size_t(header->ringSize);
+
+    //ring 0 is client to server, ring 1 is server to client
+    _tx = &header->rings[server?1:0];
+    _rx = &header->rings[server?0:1];
+    _txBase = mapRing(_fd, _headerBytes + (server?_size:0), _size);
+    _rxBase = mapRing(_fd, _headerBytes + (server?0:_size), _size);
+    if (_txBase == nullptr or _rxBase == nullptr)
+    {
+        const std::string err(strerror(errno));
+        if (_txBase != nullptr) ::munmap(_txBase, 2*_size);
+        if (_rxBase != nullptr) ::munmap(_rxBase, 2*_size);
+        ::munmap(_header, _headerBytes);
+        ::close(_fd);
+        if (server) ::shm_unlink(shmName.c_str());
+        throw Pothos::RuntimeException(what, "ring mmap() failed: " + err);
+    }
+
+    //a client attaches to the current position in the server's ring
+    _readCursor = _rx->tail.load();
+    _tx->closed.store(0);
+}
+
+SharedMemoryRing::~SharedMemoryRing(void)
+{
+    this->close();
+    ::munmap(_txBase, 2*_size);
+    ::munmap(_rxBase, 2*_size);
+    ::munmap(_header, _headerBytes);
+    ::close(_fd);
+}
+
+void SharedMemoryRing::close(void)
+{
+    if (_tx->closed.exchange(1) != 0) return;
+
+    //let the peer know that no more data is coming
+    _tx->dataSeq++;
+    futexWake(_tx->dataSeq);
+
+    //the server created the name exclusively, so it only removes its own segment
+    if (_server) ::shm_unlink(("/"+_name).c_str());
+}
+
+/***********************************************************************
+ * Writer side
+ **********************************************************************/
+size_t SharedMemoryRing::write(const void *buff, const size_t length)
+{
+    const uint64_t head = _tx->head.load(std::memory_order_relaxed);
+    const size_t space = _size - size_t(head - _tx->tail.load(std::memory_order_acquire));
+    const size_t numBytes = std::min(space, length);
+    if (numBytes == 0) return 0;
+
+    std::memcpy(_txBase + size_t(head % _size), buff, numBytes);
+    _tx->head.store(head + numBytes);
+    _tx->dataSeq++;
+    if (_tx->dataWaiters.load() != 0) futexWake(_tx->dataSeq);
+    return numBytes;
+}
+
+bool SharedMemoryRing::waitWritable(const std::chrono::high_resolution_clock::duration &timeout)
+{
+    return futexWaitFor(_tx->spaceSeq, _tx->spaceWaiters, timeout, [this]{
+        return _tx->head.load() - _tx->tail.load() < _size;
+    });
+}
+
+/***********************************************************************
+ * Reader side
+ **********************************************************************/
+size_t SharedMemoryRing::readable(void) const
+{
+    return size_t(_rx->head.load(std::memory_order_acquire) - _readCursor);
+}
+
+bool SharedMemoryRing::peerClosed(void) const
+{
+    return _rx->closed.load() != 0;
+}
+
+bool SharedMemoryRing::waitReadable(const size_t numBytes, const std::chrono::high_resolution_clock::duration &timeout)
+{
+    futexWaitFor(_rx->dataSeq, _rx->dataWaiters, timeout, [this, numBytes]{
+        return this->readable() >= numBytes or this->peerClosed();
+    });
+    return this->readable() >= numBytes;
+}
+
+size_t SharedMemoryRing::read(void *buff, const size_t length)
+{
+    const size_t numBytes = std::min(this->readable(), length);
+    std::memcpy(buff, _rxBase + size_t(_readCursor % _size), numBytes);
+    std::lock_guard<std::mutex> lock(_releaseMutex);
+    _readCursor += numBytes;
+    this->updateTail();
+    return numBytes;
+}
+
+Pothos::BufferChunk SharedMemoryRing::readChunk(const size_t length)
+{
+    if (this->readable() < length) return Pothos::BufferChunk();
+
+    //the container releases the ring space when the last reference is dropped
+    const uint64_t start = _readCursor;
+    auto self = this->shared_from_this();
+    char *addr = _rxBase + size_t(start % _size);
+    std::shared_ptr<void> container(addr, [self, start](void *){self->release(start);});
+    {
+        std::lock_guard<std::mutex> lock(_releaseMutex);
+        _held[start] = length;
+        _readCursor += length;
+    }
+    return Pothos::BufferChunk(Pothos::SharedBuffer(size_t(addr), length, container));
+}
+
+void SharedMemoryRing::release(const uint64_t start)
+{
+    std::lock_guard<std::mutex> lock(_releaseMutex);
+    _held.erase(start);
+    this->updateTail();
+}
+
+void SharedMemoryRing::updateTail(void)
+{
+    //space is only released up to the oldest chunk still in use
+    const uint64_t tail = _held.empty()? _readCursor : _held.begin()->first;
+    if (tail == _rx->tail.load(std::memory_order_relaxed)) return;
+    _rx->tail.store(tail);
+    _rx->spaceSeq++;
+    if (_rx->spaceWaiters.load() != 0) futexWake(_rx->spaceSeq);
+}
+
+#endif //__linux__
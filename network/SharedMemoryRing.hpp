@@ -0,0 +1,107 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <Pothos/Framework/BufferChunk.hpp>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <mutex>
+#include <map>
+#include <cstdint>
+#include <cstddef>
+
+struct SharedMemoryRingControl;
+
+/*!
+ * A pair of byte rings in a named shared memory segment.
+ * The server creates the segment and the client opens it by name.
+ * The server fails when the name already exists, so that it never
+ * removes a segment that belongs to another server.
+ * Each side writes into one ring and reads from the other.
+ *
+ * The rings are mapped twice back to back in virtual memory,
+ * so that any range of bytes is contiguous regardless of wrap-around.
+ * Waiting uses a futex in the segment and the writer or reader
+ * only makes a system call to wake the other side when it is blocked.
+ *
+ * Received bytes can be read into a buffer, or exposed as a BufferChunk
+ * that references the ring memory. Ring space is released back to the
+ * writer in order, once every chunk before it has been released.
+ *
+ * This implementation is only available on Linux.
+ */
+class SharedMemoryRing : public std::enable_shared_from_this<SharedMemoryRing>
+{
+public:
+    /*!
+     * Create or open a named shared memory segment.
+     * \param name the segment name (without a leading slash)
+     * \param size the size of each ring in bytes (server only)
+     * \param server true to create the segment, false to open it
+     */
+    static std::shared_ptr<SharedMemoryRing> make(const std::string &name, const size_t size, const bool server);
+
+    ~SharedMemoryRing(void);
+
+    const std::string &name(void) const
+    {
+        return _name;
+    }
+
+    //! The size of each ring in bytes
+    size_t capacity(void) const
+    {
+        return _size;
+    }
+
+    //! Write up to length bytes, return the number of bytes written
+    size_t write(const void *buff, const size_t length);
+
+    //! Wait for space in the write ring, false on timeout
+    bool waitWritable(const std::chrono::high_resolution_clock::duration &timeout);
+
+    //! The number of bytes available to read
+    size_t readable(void) const;
+
+    //! Wait for numBytes to read, false on timeout or when the peer closed
+    bool waitReadable(const size_t numBytes, const std::chrono::high_resolution_clock::duration &timeout);
+
+    //! Copy up to length bytes out of the ring, return the number of bytes read
+    size_t read(void *buff, const size_t length);
+
+    //! Read length bytes as a chunk that references the ring memory
+    Pothos::BufferChunk readChunk(const size_t length);
+
+    //! True when the remote side closed its end
+    bool peerClosed(void) const;
+
+    /*!
+     * Close the local end: the peer reads the remaining bytes and then sees the close.
+     * The server also removes the segment name; the memory stays mapped
+     * until the last chunk that references the ring is released.
+     */
+    void close(void);
+
+private:
+    SharedMemoryRing(const std::string &name, const size_t size, const bool server);
+    void release(const uint64_t start);
+    void updateTail(void);
+
+    const std::string _name;
+    const bool _server;
+    size_t _size;
+    int _fd;
+    size_t _headerBytes;
+    void *_header;
+    char *_txBase;
+    char *_rxBase;
+    SharedMemoryRingControl *_tx;
+    SharedMemoryRingControl *_rx;
+
+    //reader state: chunks that still reference the ring
+    uint64_t _readCursor;
+    std::mutex _releaseMutex;
+    std::map<uint64_t, size_t> _held;
+};
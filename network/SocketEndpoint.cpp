@@ -8,18 +8,123 @@
 #include <Poco/Format.h>
 #include <Poco/Net/StreamSocket.h>
 #include <Poco/Net/ServerSocket.h>
+#include <Poco/Net/DatagramSocket.h>
 #include <Poco/ByteOrder.h>
+#include <Poco/NumberParser.h>
 #include <Poco/SingletonHolder.h>
+#include <Poco/Logger.h>
 #include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <array>
+#include <vector>
+#include <map>
+#include <thread>
+#include <atomic>
 #include <cassert>
+#include <cerrno>
+#include <cstring> //strerror
+#include <climits> //IOV_MAX
 #include <iostream>
 #include <algorithm> //min/max
 
 /***********************************************************************
- * The maximum number of bytes passed to a single send() call.
- * Larger buffers will be split into multiple calls to send().
+ * Scatter-gather support:
+ * Use sendmsg() with an iovec list to write a header and payload
+ * in a single call. Otherwise fallback to one send() per iovec.
  **********************************************************************/
-#define SEND_MTU 4096
+#ifdef _MSC_VER
+struct iovec
+{
+    void *iov_base;
+    size_t iov_len;
+};
+#else
+#include <sys/socket.h>
+#include <sys/uio.h>
+#define HAS_SENDMSG
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/***********************************************************************
+ * Zero-copy support:
+ * MSG_ZEROCOPY pins the payload pages until the kernel reports completion
+ * on the socket error queue. Only worthwhile for larger payloads.
+ **********************************************************************/
+#ifdef __linux__
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#define HAS_MSG_ZEROCOPY
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#endif
+
+#define ZERO_COPY_MIN_BYTES (16*1024)
+
+/***********************************************************************
+ * Receive readiness and read-ahead:
+ * Use epoll for readiness on the connected TCP socket when available.
+ * Small reads (headers, labels, small messages) are served from a
+ * read-ahead buffer so several frames are parsed from one recv() call.
+ * Large reads bypass the buffer and go straight to the caller's memory.
+ **********************************************************************/
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <unistd.h>
+#define HAS_EPOLL
+#endif
+
+#define READ_AHEAD_BYTES (16*1024)
+
+/***********************************************************************
+ * Unix domain socket support:
+ * unix:///path/to/socket binds or connects a filesystem socket,
+ * unix://@name uses the Linux abstract socket namespace.
+ **********************************************************************/
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cstddef> //offsetof
+#define HAS_AF_UNIX
+#endif
+
+/***********************************************************************
+ * Shared memory support:
+ * shm://name moves the byte stream through a pair of shared memory rings.
+ * The optional ?size=bytes query sets the size of each ring.
+ **********************************************************************/
+#ifdef __linux__
+#include "SharedMemoryRing.hpp"
+#define HAS_SHM_RING
+#define SHM_RING_DEFAULT_SIZE (8*1024*1024)
+#endif
+
+/***********************************************************************
+ * Flow control window limits:
+ * The default window is used when the remote endpoint does not
+ * negotiate a window (prior versions used a fixed 256 KiB window).
+ * The automatic mode grows the window up to the maximum size.
+ **********************************************************************/
+#define FLOW_WINDOW_DEFAULT (256*1024)
+#define FLOW_WINDOW_MAXIMUM (64*1024*1024)
+#define FLOW_RTT_MAX_SAMPLES 64
+
+/***********************************************************************
+ * Pending subscriber connections held by a publishing endpoint
+ **********************************************************************/
+#define PUBLISH_BACKLOG 64
 
 /***********************************************************************
  * Ensure that the MSG_MORE flag exists:
@@ -47,6 +152,49 @@ struct PothosPacketSocketEndpointInterface
     virtual int send(const void *buff, const size_t length, const int flags = 0) = 0;
 
     virtual int recv(void *buff, const size_t length, const int flags = 0) = 0;
+
+    //! Send a list of buffers in one call, the default sends each buffer in turn
+    virtual int sendv(const struct iovec *iov, const size_t iovcnt, const int flags = 0)
+    {
+        int total = 0;
+        for (size_t i = 0; i < iovcnt; i++)
+        {
+            const bool last = (i+1 == iovcnt);
+            const int ret = this->send(iov[i].iov_base, iov[i].iov_len, last?flags:(flags | MSG_MORE));
+            if (ret <= 0) return (total == 0)?ret:total;
+            total += ret;
+            if (size_t(ret) != iov[i].iov_len) break;
+        }
+        return total;
+    }
+
+    //! Send without copying, payload holds the memory until the transfer completes
+    virtual int sendvZeroCopy(const struct iovec *iov, const size_t iovcnt, const Pothos::BufferChunk &, const int flags = 0)
+    {
+        return this->sendv(iov, iovcnt, flags);
+    }
+
+    virtual bool zeroCopyEnabled(void) const
+    {
+        return false;
+    }
+
+    //! Receive bytes as a chunk that references transport memory, or a null chunk when not supported
+    virtual Pothos::BufferChunk recvChunk(const size_t)
+    {
+        return Pothos::BufferChunk();
+    }
+
+    virtual void setBufferSizes(const size_t)
+    {
+        return;
+    }
+
+    virtual void setZeroCopy(const bool enable)
+    {
+        if (enable) poco_warning(Poco::Logger::get("PothosPacketSocketEndpoint"),
+            "Zero-copy transmission not supported by this transport");
+    }
 };
 
 /***********************************************************************
@@ -56,7 +204,13 @@ struct PothosPacketSocketEndpointInterfaceTcp : PothosPacketSocketEndpointInterf
 {
     PothosPacketSocketEndpointInterfaceTcp(const Poco::Net::SocketAddress &addr, const bool server):
         server(server),
-        connected(false)
+        connected(false),
+        epollFd(-1),
+        readAhead(READ_AHEAD_BYTES),
+        readAheadOffset(0),
+        readAheadLength(0),
+        zeroCopy(false),
+        zeroCopyNextId(0)
     {
         if (server)
         {
@@ -65,53 +219,922 @@ struct PothosPacketSocketEndpointInterfaceTcp : PothosPacketSocketEndpointInterf
         else
         {
             this->clientSock = Poco::Net::StreamSocket(addr);
-            this->clientSock.setNoDelay(true);
-            this->connected = true;
+            this->setupConnected();
         }
     }
 
+    //a connection accepted by a publishing endpoint
+    PothosPacketSocketEndpointInterfaceTcp(const Poco::Net::StreamSocket &sock):
+        server(false),
+        connected(false),
+        clientSock(sock),
+        epollFd(-1),
+        readAhead(READ_AHEAD_BYTES),
+        readAheadOffset(0),
+        readAheadLength(0),
+        zeroCopy(false),
+        zeroCopyNextId(0)
+    {
+        this->setupConnected();
+    }
+
     ~PothosPacketSocketEndpointInterfaceTcp(void)
     {
+        #ifdef HAS_EPOLL
+        if (epollFd >= 0) ::close(epollFd);
+        #endif //HAS_EPOLL
         this->clientSock.close();
         if (server) this->serverSock.close();
     }
 
+    void setupConnected(void)
+    {
+        this->clientSock.setNoDelay(true);
+        connected = true;
+
+        #ifdef HAS_EPOLL
+        epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        struct epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        if (epollFd >= 0 and ::epoll_ctl(epollFd, EPOLL_CTL_ADD, clientSock.impl()->sockfd(), &ev) != 0)
+        {
+            ::close(epollFd);
+            epollFd = -1;
+        }
+        #endif //HAS_EPOLL
+    }
+
+    //wait for the connected socket to become readable with the caller's timeout
+    bool waitReadable(const std::chrono::high_resolution_clock::duration &timeout)
+    {
+        #ifdef HAS_EPOLL
+        if (epollFd >= 0)
+        {
+            //round up so short timeouts still block rather than spin
+            const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(timeout).count();
+            struct epoll_event ev;
+            int ret = 0;
+            do ret = ::epoll_wait(epollFd, &ev, 1, int((std::max<long long>(micros, 0) + 999)/1000));
+            while (ret < 0 and errno == EINTR);
+            return ret > 0 and (ev.events & (EPOLLIN | EPOLLHUP | EPOLLRDHUP)) != 0;
+        }
+        #endif //HAS_EPOLL
+        const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(timeout).count();
+        return clientSock.poll(Poco::Timespan(Poco::Timespan::TimeDiff(micros)), Poco::Net::Socket::SELECT_READ);
+    }
+
+    std::string getPort(void) const
+    {
+        if (server) return std::to_string(serverSock.address().port());
+        return std::to_string(clientSock.address().port());
+    }
+
+    bool isRecvReady(const std::chrono::high_resolution_clock::duration &timeout)
+    {
+        if (not connected)
+        {
+            const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(timeout).count();
+            const auto tspan = Poco::Timespan(Poco::Timespan::TimeDiff(micros));
+            if (not this->serverSock.poll(tspan, Poco::Net::Socket::SELECT_READ)) return false;
+            this->clientSock = this->serverSock.acceptConnection();
+            this->setupConnected();
+            if (zeroCopy) this->setZeroCopy(true);
+            return false;
+        }
+
+        //frames already read ahead are ready without a system call
+        if (readAheadOffset != readAheadLength) return true;
+        if (not zeroCopy) return this->waitReadable(timeout);
+
+        //completions on the error queue also wake poll(), only report actual data
+        this->reapZeroCopy();
+        if (not this->waitReadable(timeout)) return false;
+        if (clientSock.available() != 0) return true;
+        this->reapZeroCopy();
+        return false;
+    }
+
+    int send(const void *buff, const size_t length, const int flags)
+    {
+        return clientSock.sendBytes(buff, int(length), flags);
+    }
+
+    int recv(void *buff, const size_t length, const int flags)
+    {
+        char *out = reinterpret_cast<char *>(buff);
+        size_t total = 0;
+
+        //serve from the read-ahead buffer first
+        if (readAheadOffset != readAheadLength)
+        {
+            total = std::min(length, readAheadLength - readAheadOffset);
+            std::memcpy(out, readAhead.data() + readAheadOffset, total);
+            readAheadOffset += total;
+            if (total == length or (flags & MSG_WAITALL) == 0) return int(total);
+        }
+
+        //large reads go straight to the caller's buffer
+        if (length - total >= READ_AHEAD_BYTES)
+        {
+            const int ret = clientSock.receiveBytes(out + total, int(length - total), flags);
+            if (ret <= 0) return (total == 0)?ret:int(total);
+            return int(total + size_t(ret));
+        }
+
+        //small reads take everything that is available into the read-ahead buffer
+        while (true)
+        {
+            const int ret = clientSock.receiveBytes(readAhead.data(), int(readAhead.size()));
+            if (ret <= 0) return (total == 0)?ret:int(total);
+            readAheadLength = size_t(ret);
+            readAheadOffset = std::min(length - total, readAheadLength);
+            std::memcpy(out + total, readAhead.data(), readAheadOffset);
+            total += readAheadOffset;
+            if (total == length or (flags & MSG_WAITALL) == 0) return int(total);
+        }
+    }
+
+    void setBufferSizes(const size_t numBytes)
+    {
+        clientSock.setSendBufferSize(int(numBytes));
+        clientSock.setReceiveBufferSize(int(numBytes));
+    }
+
+    #ifdef HAS_SENDMSG
+    int sendv(const struct iovec *iov, const size_t iovcnt, const int flags)
+    {
+        struct msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = const_cast<struct iovec *>(iov);
+        msg.msg_iovlen = iovcnt;
+        int ret = 0;
+        do ret = int(::sendmsg(clientSock.impl()->sockfd(), &msg, flags | MSG_NOSIGNAL));
+        while (ret < 0 and errno == EINTR);
+        return ret;
+    }
+    #endif //HAS_SENDMSG
+
+    #ifdef HAS_MSG_ZEROCOPY
+    int sendvZeroCopy(const struct iovec *iov, const size_t iovcnt, const Pothos::BufferChunk &payload, const int flags)
+    {
+        if (not zeroCopy) return this->sendv(iov, iovcnt, flags);
+        this->reapZeroCopy();
+
+        //each successful zero-copy call is assigned the next completion id
+        std::lock_guard<std::mutex> lock(zeroCopyMutex);
+        int ret = this->sendv(iov, iovcnt, flags | MSG_ZEROCOPY);
+        if (ret >= 0) zeroCopyPending.emplace_back(zeroCopyNextId++, payload);
+
+        //out of option memory for pinned pages, copy this one instead
+        else if (errno == ENOBUFS) ret = this->sendv(iov, iovcnt, flags);
+        return ret;
+    }
+
+    bool zeroCopyEnabled(void) const
+    {
+        return zeroCopy;
+    }
+
+    void setZeroCopy(const bool enable)
+    {
+        zeroCopy = enable;
+        if (not enable or not connected) return;
+        int one = 1;
+        if (::setsockopt(clientSock.impl()->sockfd(), SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0) return;
+        poco_warning_f1(Poco::Logger::get("PothosPacketSocketEndpoint"),
+            "setsockopt(SO_ZEROCOPY) failed, using copies: %s", std::string(strerror(errno)));
+        zeroCopy = false;
+    }
+
+    //release buffers for completions reported on the socket error queue
+    void reapZeroCopy(void)
+    {
+        std::lock_guard<std::mutex> lock(zeroCopyMutex);
+        if (zeroCopyPending.empty()) return;
+
+        char control[128];
+        struct msghdr msg;
+        while (true)
+        {
+            std::memset(&msg, 0, sizeof(msg));
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            if (::recvmsg(clientSock.impl()->sockfd(), &msg, MSG_ERRQUEUE) < 0) break;
+
+            for (auto cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm))
+            {
+                if (not ((cm->cmsg_level == SOL_IP and cm->cmsg_type == IP_RECVERR) or
+                    (cm->cmsg_level == SOL_IPV6 and cm->cmsg_type == IPV6_RECVERR))) continue;
+                const auto serr = reinterpret_cast<const struct sock_extended_err *>(CMSG_DATA(cm));
+                if (serr->ee_errno != 0 or serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY) continue;
+
+                //completed ids are the inclusive range [ee_info, ee_data]
+                for (auto &pending : zeroCopyPending)
+                {
+                    if (uint32_t(pending.first - serr->ee_info) > uint32_t(serr->ee_data - serr->ee_info)) continue;
+                    pending.second = Pothos::BufferChunk();
+                }
+            }
+        }
+
+        while (not zeroCopyPending.empty() and zeroCopyPending.front().second.address == 0)
+        {
+            zeroCopyPending.pop_front();
+        }
+    }
+    #endif //HAS_MSG_ZEROCOPY
+
+    bool server;
+    bool connected;
+    Poco::Net::ServerSocket serverSock;
+    Poco::Net::StreamSocket clientSock;
+    int epollFd;
+
+    //received bytes not yet consumed by recv()
+    std::vector<char> readAhead;
+    size_t readAheadOffset;
+    size_t readAheadLength;
+
+    //zero-copy buffers waiting on completion
+    bool zeroCopy;
+    uint32_t zeroCopyNextId;
+    std::deque<std::pair<uint32_t, Pothos::BufferChunk>> zeroCopyPending;
+    std::mutex zeroCopyMutex;
+};
+
+/***********************************************************************
+ * Striped TCP implementation of interface:
+ * The byte stream is cut into segments that are sent round-robin
+ * over several connections. Each segment starts with its sequence
+ * number and length, and the receiver reads the segments back in order,
+ * so the framing and the ordering of the byte stream are unchanged.
+ * Every connection has its own send and receive thread so that the
+ * stripes move data in parallel: a send hands each thread its share of
+ * the segments and waits for all of them, and the receive threads read
+ * ahead into bounded per-stripe queues that recv drains in sequence.
+ **********************************************************************/
+#define STRIPE_SEGMENT_MAX (64*1024)
+#define STRIPE_QUEUE_MAX 4 //segments read ahead per connection
+#define STRIPE_HELLO_TIMEOUT_US 1000000 //time for an accepted connection to introduce itself
+static const uint32_t PothosPacketStripeHello = 0x50545353; //"PTSS"
+
+struct PothosPacketSocketEndpointInterfaceTcpStriped : PothosPacketSocketEndpointInterface
+{
+    struct Stripe
+    {
+        Stripe(void): connected(false), txPending(false), rxClosed(false){}
+        Poco::Net::StreamSocket sock;
+        bool connected;
+        std::thread txThread;
+        std::thread rxThread;
+
+        //the segments of the current send for this connection
+        std::vector<struct iovec> txIov;
+        bool txPending;
+        std::string txError;
+
+        //segments read ahead, with their sequence numbers
+        std::deque<std::pair<uint32_t, std::vector<char>>> rxQueue;
+        bool rxClosed;
+    };
+
+    PothosPacketSocketEndpointInterfaceTcpStriped(const Poco::Net::SocketAddress &addr, const bool server, const size_t numStreams):
+        server(server),
+        numConnected(0),
+        stripes(numStreams),
+        bufferSizes(0),
+        started(false),
+        done(false),
+        sendSeq(0),
+        recvSeq(0),
+        rxSegmentOffset(0)
+    {
+        if (server)
+        {
+            this->serverSock = Poco::Net::ServerSocket(addr, int(numStreams));
+            return;
+        }
+
+        //each connection introduces itself with its index in the stripe
+        for (size_t i = 0; i < numStreams; i++)
+        {
+            auto &sock = stripes[i].sock;
+            sock = Poco::Net::StreamSocket(addr);
+            sock.setNoDelay(true);
+            const uint32_t hello[3] = {
+                Poco::ByteOrder::toNetwork(Poco::UInt32(PothosPacketStripeHello)),
+                Poco::ByteOrder::toNetwork(Poco::UInt32(i)),
+                Poco::ByteOrder::toNetwork(Poco::UInt32(numStreams))};
+            this->sendAll(sock, hello, sizeof(hello));
+            stripes[i].connected = true;
+        }
+        numConnected = numStreams;
+        this->startThreads();
+    }
+
+    ~PothosPacketSocketEndpointInterfaceTcpStriped(void)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        txCond.notify_all();
+        rxCond.notify_all();
+
+        //shutdown wakes threads that are blocked on the sockets
+        for (auto &stripe : stripes)
+        {
+            if (not started) break;
+            try {stripe.sock.shutdown();}
+            catch (const Poco::Exception &){}
+        }
+        for (auto &stripe : stripes)
+        {
+            if (stripe.txThread.joinable()) stripe.txThread.join();
+            if (stripe.rxThread.joinable()) stripe.rxThread.join();
+            stripe.sock.close();
+        }
+        if (server) this->serverSock.close();
+    }
+
     std::string getPort(void) const
     {
-        if (server) return std::to_string(serverSock.address().port());
-        return std::to_string(clientSock.address().port());
+        if (server) return std::to_string(serverSock.address().port());
+        return std::to_string(stripes.front().sock.address().port());
+    }
+
+    bool isRecvReady(const std::chrono::high_resolution_clock::duration &timeout)
+    {
+        if (numConnected < stripes.size())
+        {
+            const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(timeout).count();
+            const auto tspan = Poco::Timespan(Poco::Timespan::TimeDiff(micros));
+            if (not this->serverSock.poll(tspan, Poco::Net::Socket::SELECT_READ)) return false;
+            auto sock = this->serverSock.acceptConnection();
+            sock.setNoDelay(true);
+
+            //a stray connection that does not introduce itself in time is ignored
+            uint32_t hello[3] = {0, 0, 0};
+            bool helloOk = false;
+            std::string peer;
+            try
+            {
+                peer = sock.peerAddress().toString();
+                sock.setReceiveTimeout(Poco::Timespan(Poco::Timespan::TimeDiff(STRIPE_HELLO_TIMEOUT_US)));
+                helloOk = this->recvAll(sock, hello, sizeof(hello));
+                sock.setReceiveTimeout(Poco::Timespan());
+            }
+            catch (const Poco::Exception &){}
+            const size_t index = Poco::ByteOrder::fromNetwork(Poco::UInt32(hello[1]));
+            const size_t count = Poco::ByteOrder::fromNetwork(Poco::UInt32(hello[2]));
+            if (not helloOk or Poco::ByteOrder::fromNetwork(Poco::UInt32(hello[0])) != PothosPacketStripeHello or
+                count != stripes.size() or index >= count or stripes[index].connected)
+            {
+                poco_warning_f2(Poco::Logger::get("PothosPacketSocketEndpoint"),
+                    "Ignored connection from %s: bad or duplicate stripe hello, expected %d streams",
+                    peer, int(stripes.size()));
+                sock.close();
+                return false;
+            }
+            stripes[index].sock = sock;
+            stripes[index].connected = true;
+            numConnected++;
+            if (numConnected == stripes.size())
+            {
+                if (bufferSizes != 0) this->setBufferSizes(bufferSizes);
+                this->startThreads();
+            }
+            return false;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        return rxCond.wait_for(lock, timeout, [this]{return this->recvAvailable();});
+    }
+
+    int send(const void *buff, const size_t length, const int flags)
+    {
+        struct iovec iov;
+        iov.iov_base = const_cast<void *>(buff);
+        iov.iov_len = length;
+        return this->sendv(&iov, 1, flags);
+    }
+
+    //segments are sent whole, so the entire list is sent before returning
+    int sendv(const struct iovec *iov, const size_t iovcnt, const int)
+    {
+        if (not started) throw Pothos::Exception("PothosPacketSocketEndpointInterfaceTcpStriped::send()", "not connected");
+
+        //deal the segments out to the connections, the headers need stable storage
+        txHeaders.clear();
+        for (auto &stripe : stripes) stripe.txIov.clear();
+        size_t total = 0;
+        size_t iovIndex = 0, iovOffset = 0;
+        while (iovIndex < iovcnt)
+        {
+            auto &segIov = stripes[sendSeq % stripes.size()].txIov;
+            txHeaders.emplace_back();
+            auto &segHdr = txHeaders.back();
+            struct iovec hdrIov;
+            hdrIov.iov_base = segHdr.data();
+            hdrIov.iov_len = sizeof(uint32_t)*segHdr.size();
+            segIov.push_back(hdrIov);
+
+            //gather up to one segment worth of the iovec list
+            size_t segBytes = 0;
+            while (iovIndex < iovcnt and segBytes < STRIPE_SEGMENT_MAX)
+            {
+                const size_t num = std::min(iov[iovIndex].iov_len - iovOffset, size_t(STRIPE_SEGMENT_MAX) - segBytes);
+                struct iovec dataIov;
+                dataIov.iov_base = reinterpret_cast<char *>(iov[iovIndex].iov_base) + iovOffset;
+                dataIov.iov_len = num;
+                if (num != 0) segIov.push_back(dataIov);
+                segBytes += num;
+                iovOffset += num;
+                if (iovOffset == iov[iovIndex].iov_len)
+                {
+                    iovIndex++;
+                    iovOffset = 0;
+                }
+            }
+            if (segBytes == 0)
+            {
+                segIov.pop_back();
+                txHeaders.pop_back();
+                break;
+            }
+
+            segHdr[0] = Poco::ByteOrder::toNetwork(Poco::UInt32(sendSeq));
+            segHdr[1] = Poco::ByteOrder::toNetwork(Poco::UInt32(segBytes));
+            sendSeq++;
+            total += segBytes;
+        }
+
+        //a single segment goes out directly, otherwise all connections send at once
+        if (txHeaders.size() == 1)
+        {
+            auto &stripe = stripes[(sendSeq-1) % stripes.size()];
+            this->sendAllv(stripe.sock, stripe.txIov.data(), stripe.txIov.size());
+            return int(total);
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        for (auto &stripe : stripes) stripe.txPending = not stripe.txIov.empty();
+        txCond.notify_all();
+        txCond.wait(lock, [this]
+        {
+            for (const auto &stripe : stripes) if (stripe.txPending) return false;
+            return true;
+        });
+        for (auto &stripe : stripes)
+        {
+            if (stripe.txError.empty()) continue;
+            const auto error = stripe.txError;
+            stripe.txError.clear();
+            throw Pothos::Exception("PothosPacketSocketEndpointInterfaceTcpStriped::send()", error);
+        }
+        return int(total);
+    }
+
+    int recv(void *buff, const size_t length, const int flags)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        size_t total = 0;
+        while (total < length)
+        {
+            //start the next segment in sequence
+            if (rxSegmentOffset == rxSegment.size())
+            {
+                if (total != 0 and (flags & MSG_WAITALL) == 0) break;
+                auto &stripe = stripes[recvSeq % stripes.size()];
+                rxCond.wait(lock, [&stripe]{return not stripe.rxQueue.empty() or stripe.rxClosed;});
+                if (stripe.rxQueue.empty()) return int(total);
+                const uint32_t seq = stripe.rxQueue.front().first;
+                if (seq != recvSeq) throw Pothos::Exception("PothosPacketSocketEndpointInterfaceTcpStriped::recv()",
+                    "expected segment "+std::to_string(recvSeq)+", got "+std::to_string(seq));
+                this->recycleSegment(std::move(rxSegment));
+                rxSegment = std::move(stripe.rxQueue.front().second);
+                rxSegmentOffset = 0;
+                stripe.rxQueue.pop_front();
+                recvSeq++;
+                rxCond.notify_all(); //queue space for the receive thread
+                continue;
+            }
+
+            const size_t num = std::min(length - total, rxSegment.size() - rxSegmentOffset);
+            std::memcpy(reinterpret_cast<char *>(buff) + total, rxSegment.data() + rxSegmentOffset, num);
+            total += num;
+            rxSegmentOffset += num;
+        }
+        return int(total);
+    }
+
+    void setBufferSizes(const size_t numBytes)
+    {
+        //the window is spread across the connections
+        bufferSizes = numBytes;
+        const int size = int(std::max<size_t>(numBytes/stripes.size(), STRIPE_SEGMENT_MAX*2));
+        for (size_t i = 0; i < stripes.size(); i++)
+        {
+            if (not stripes[i].connected) continue;
+            stripes[i].sock.setSendBufferSize(size);
+            stripes[i].sock.setReceiveBufferSize(size);
+        }
+    }
+
+    void startThreads(void)
+    {
+        for (size_t i = 0; i < stripes.size(); i++)
+        {
+            stripes[i].txThread = std::thread(&PothosPacketSocketEndpointInterfaceTcpStriped::txLoop, this, i);
+            stripes[i].rxThread = std::thread(&PothosPacketSocketEndpointInterfaceTcpStriped::rxLoop, this, i);
+        }
+        started = true;
+    }
+
+    void txLoop(const size_t index)
+    {
+        auto &stripe = stripes[index];
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true)
+        {
+            txCond.wait(lock, [this, &stripe]{return done or stripe.txPending;});
+            if (done) return;
+            lock.unlock();
+            std::string error;
+            try
+            {
+                this->sendAllv(stripe.sock, stripe.txIov.data(), stripe.txIov.size());
+            }
+            catch (const Pothos::Exception &ex){error = ex.message();}
+            catch (const Poco::Exception &ex){error = ex.displayText();}
+            lock.lock();
+            stripe.txError = error;
+            stripe.txPending = false;
+            txCond.notify_all();
+        }
+    }
+
+    void rxLoop(const size_t index)
+    {
+        auto &stripe = stripes[index];
+        try
+        {
+            while (true)
+            {
+                std::vector<char> segment;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    rxCond.wait(lock, [this, &stripe]{return done or stripe.rxQueue.size() < STRIPE_QUEUE_MAX;});
+                    if (done) break;
+                    if (not segmentPool.empty())
+                    {
+                        segment = std::move(segmentPool.back());
+                        segmentPool.pop_back();
+                    }
+                }
+
+                uint32_t segHdr[2];
+                if (not this->recvAll(stripe.sock, segHdr, sizeof(segHdr))) break;
+                const uint32_t seq = Poco::ByteOrder::fromNetwork(Poco::UInt32(segHdr[0]));
+                const size_t length = Poco::ByteOrder::fromNetwork(Poco::UInt32(segHdr[1]));
+                if (length > STRIPE_SEGMENT_MAX) break; //corrupt framing ends the stream like a close
+                segment.resize(length);
+                if (not this->recvAll(stripe.sock, segment.data(), segment.size())) break;
+
+                std::lock_guard<std::mutex> lock(mutex);
+                stripe.rxQueue.emplace_back(seq, std::move(segment));
+                rxCond.notify_all();
+            }
+        }
+        catch (const Poco::Exception &)
+        {
+            //a reset connection ends the stream like a close
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        stripe.rxClosed = true;
+        rxCond.notify_all();
+    }
+
+    //call with the mutex held
+    bool recvAvailable(void) const
+    {
+        if (rxSegmentOffset != rxSegment.size()) return true;
+        const auto &stripe = stripes[recvSeq % stripes.size()];
+        return not stripe.rxQueue.empty() or stripe.rxClosed;
+    }
+
+    //call with the mutex held
+    void recycleSegment(std::vector<char> &&segment)
+    {
+        if (segment.capacity() != 0 and segmentPool.size() < stripes.size()*STRIPE_QUEUE_MAX)
+        {
+            segmentPool.push_back(std::move(segment));
+        }
+    }
+
+    bool recvAll(Poco::Net::StreamSocket &sock, void *buff, const size_t length)
+    {
+        size_t total = 0;
+        while (total < length)
+        {
+            const int ret = sock.receiveBytes(reinterpret_cast<char *>(buff) + total, int(length - total));
+            if (ret <= 0) return false;
+            total += size_t(ret);
+        }
+        return true;
+    }
+
+    void sendAll(Poco::Net::StreamSocket &sock, const void *buff, const size_t length)
+    {
+        struct iovec iov;
+        iov.iov_base = const_cast<void *>(buff);
+        iov.iov_len = length;
+        this->sendAllv(sock, &iov, 1);
+    }
+
+    void sendAllv(Poco::Net::StreamSocket &sock, struct iovec *iov, size_t iovcnt)
+    {
+        while (iovcnt != 0)
+        {
+            #ifdef HAS_SENDMSG
+            struct msghdr msg;
+            std::memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iov;
+            msg.msg_iovlen = std::min<size_t>(iovcnt, IOV_MAX);
+            int ret = 0;
+            do ret = int(::sendmsg(sock.impl()->sockfd(), &msg, MSG_NOSIGNAL));
+            while (ret < 0 and errno == EINTR);
+            #else
+            const int ret = sock.sendBytes(iov[0].iov_base, int(iov[0].iov_len));
+            #endif
+            if (ret <= 0) throw Pothos::Exception("PothosPacketSocketEndpointInterfaceTcpStriped::send()", std::to_string(ret));
+
+            //advance the iovec list past the sent bytes
+            size_t bytesSent = size_t(ret);
+            while (iovcnt != 0 and bytesSent >= iov[0].iov_len)
+            {
+                bytesSent -= iov[0].iov_len;
+                iov++; iovcnt--;
+            }
+            if (iovcnt != 0)
+            {
+                iov[0].iov_base = reinterpret_cast<char *>(iov[0].iov_base) + bytesSent;
+                iov[0].iov_len -= bytesSent;
+            }
+        }
+    }
+
+    bool server;
+    size_t numConnected;
+    Poco::Net::ServerSocket serverSock;
+    std::vector<Stripe> stripes;
+    size_t bufferSizes;
+    bool started;
+
+    std::mutex mutex; //protects the stripe queues and flags
+    std::condition_variable txCond;
+    std::condition_variable rxCond;
+    bool done;
+
+    //send state, used by one sending thread at a time
+    uint32_t sendSeq;
+    std::deque<std::array<uint32_t, 2>> txHeaders;
+
+    //receive state, the segment being read out and its position
+    uint32_t recvSeq;
+    std::vector<char> rxSegment;
+    size_t rxSegmentOffset;
+    std::vector<std::vector<char>> segmentPool;
+};
+
+/***********************************************************************
+ * Unix domain socket implementation of interface
+ **********************************************************************/
+#ifdef HAS_AF_UNIX
+struct PothosPacketSocketEndpointInterfaceUnix : PothosPacketSocketEndpointInterface
+{
+    PothosPacketSocketEndpointInterfaceUnix(const std::string &path, const bool server):
+        path(path),
+        server(server),
+        listenFd(-1),
+        sockFd(-1),
+        bufferSizes(0)
+    {
+        //fill in the address, a leading @ selects the abstract namespace
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.empty() or path.size() >= sizeof(addr.sun_path))
+        {
+            throw Pothos::InvalidArgumentException("PothosPacketSocketEndpointInterfaceUnix("+path+")", "invalid socket path");
+        }
+        std::memcpy(addr.sun_path, path.data(), path.size());
+        if (path[0] == '@') addr.sun_path[0] = '\0';
+        addrLen = socklen_t(offsetof(struct sockaddr_un, sun_path) + path.size());
+
+        try
+        {
+            this->open();
+        }
+        catch (...)
+        {
+            if (sockFd >= 0) ::close(sockFd);
+            if (listenFd >= 0) ::close(listenFd);
+            throw;
+        }
+    }
+
+    void open(void)
+    {
+        if (server)
+        {
+            //remove a stale socket file left behind by a previous bind
+            struct stat st;
+            if (path[0] != '@' and ::stat(path.c_str(), &st) == 0 and S_ISSOCK(st.st_mode)) ::unlink(path.c_str());
+
+            listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (listenFd < 0) this->throwErrno("socket()");
+            if (::bind(listenFd, reinterpret_cast<const struct sockaddr *>(&addr), addrLen) != 0) this->throwErrno("bind()");
+            if (::listen(listenFd, 1/*only one client expected*/) != 0) this->throwErrno("listen()");
+        }
+        else
+        {
+            sockFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+            if (sockFd < 0) this->throwErrno("socket()");
+            if (::connect(sockFd, reinterpret_cast<const struct sockaddr *>(&addr), addrLen) != 0) this->throwErrno("connect()");
+        }
+    }
+
+    ~PothosPacketSocketEndpointInterfaceUnix(void)
+    {
+        if (sockFd >= 0) ::close(sockFd);
+        if (listenFd >= 0) ::close(listenFd);
+        if (server and path[0] != '@') ::unlink(path.c_str());
+    }
+
+    void throwErrno(const std::string &what) const
+    {
+        throw Pothos::RuntimeException("PothosPacketSocketEndpointInterfaceUnix("+path+")", what + " failed: " + std::string(strerror(errno)));
+    }
+
+    std::string getPort(void) const
+    {
+        return path;
+    }
+
+    static bool pollIn(const int fd, const std::chrono::high_resolution_clock::duration &timeout)
+    {
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        const auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(timeout).count();
+        return ::poll(&pfd, 1, int(millis)) > 0;
+    }
+
+    bool isRecvReady(const std::chrono::high_resolution_clock::duration &timeout)
+    {
+        if (sockFd < 0)
+        {
+            if (not pollIn(listenFd, timeout)) return false;
+            sockFd = ::accept(listenFd, nullptr, nullptr);
+            if (sockFd >= 0 and bufferSizes != 0) this->setBufferSizes(bufferSizes);
+            return false;
+        }
+        return pollIn(sockFd, timeout);
+    }
+
+    int send(const void *buff, const size_t length, const int flags)
+    {
+        int ret = 0;
+        do ret = int(::send(sockFd, buff, length, flags | MSG_NOSIGNAL));
+        while (ret < 0 and errno == EINTR);
+        if (ret < 0) this->throwErrno("send()");
+        return ret;
+    }
+
+    int recv(void *buff, const size_t length, const int flags)
+    {
+        int ret = 0;
+        do ret = int(::recv(sockFd, buff, length, flags));
+        while (ret < 0 and errno == EINTR);
+        if (ret < 0) this->throwErrno("recv()");
+        return ret;
+    }
+
+    int sendv(const struct iovec *iov, const size_t iovcnt, const int flags)
+    {
+        struct msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = const_cast<struct iovec *>(iov);
+        msg.msg_iovlen = iovcnt;
+        int ret = 0;
+        do ret = int(::sendmsg(sockFd, &msg, flags | MSG_NOSIGNAL));
+        while (ret < 0 and errno == EINTR);
+        if (ret < 0) this->throwErrno("sendmsg()");
+        return ret;
+    }
+
+    void setBufferSizes(const size_t numBytes)
+    {
+        bufferSizes = numBytes;
+        if (sockFd < 0) return;
+        const int size = int(numBytes);
+        ::setsockopt(sockFd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+        ::setsockopt(sockFd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    }
+
+    const std::string path;
+    const bool server;
+    struct sockaddr_un addr;
+    socklen_t addrLen;
+    int listenFd;
+    int sockFd;
+    size_t bufferSizes;
+};
+#endif //HAS_AF_UNIX
+
+/***********************************************************************
+ * Shared memory implementation of interface
+ **********************************************************************/
+#ifdef HAS_SHM_RING
+struct PothosPacketSocketEndpointInterfaceShm : PothosPacketSocketEndpointInterface
+{
+    PothosPacketSocketEndpointInterfaceShm(const std::string &name, const size_t size, const bool server):
+        ring(SharedMemoryRing::make(name, size, server))
+    {
+        return;
+    }
+
+    ~PothosPacketSocketEndpointInterfaceShm(void)
+    {
+        //chunks may still reference the ring, but the peer sees the close now
+        ring->close();
+    }
+
+    std::string getPort(void) const
+    {
+        return ring->name();
+    }
+
+    bool isRecvReady(const std::chrono::high_resolution_clock::duration &timeout)
+    {
+        return ring->waitReadable(1, timeout);
+    }
+
+    int send(const void *buff, const size_t length, const int flags)
+    {
+        struct iovec iov;
+        iov.iov_base = const_cast<void *>(buff);
+        iov.iov_len = length;
+        return this->sendv(&iov, 1, flags);
     }
 
-    bool isRecvReady(const std::chrono::high_resolution_clock::duration &timeout)
+    int recv(void *buff, const size_t length, const int flags)
     {
-        if (not connected)
+        const size_t numBytes = ((flags & MSG_WAITALL) != 0)?length:1;
+        while (not ring->waitReadable(numBytes, std::chrono::milliseconds(100)))
         {
-            const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(timeout).count();
-            const auto tspan = Poco::Timespan(Poco::Timespan::TimeDiff(micros));
-            if (not this->serverSock.poll(tspan, Poco::Net::Socket::SELECT_READ)) return false;
-            this->clientSock = this->serverSock.acceptConnection();
-            this->clientSock.setNoDelay(true);
-            connected = true;
-            return false;
+            if (ring->peerClosed()) return 0;
         }
-        return clientSock.poll(Poco::Timespan(Poco::Timespan::TimeDiff(1e6*0.05)), Poco::Net::Socket::SELECT_READ);
+        return int(ring->read(buff, length));
     }
 
-    int send(const void *buff, const size_t length, const int flags)
+    //block until some space is available, like a blocking socket
+    int sendv(const struct iovec *iov, const size_t iovcnt, const int)
     {
-        return clientSock.sendBytes(buff, int(length), flags);
+        size_t total = 0;
+        while (total == 0)
+        {
+            for (size_t i = 0; i < iovcnt; i++)
+            {
+                const size_t ret = ring->write(iov[i].iov_base, iov[i].iov_len);
+                total += ret;
+                if (ret != iov[i].iov_len) break;
+            }
+            if (total != 0) break;
+            if (ring->peerClosed()) return -1;
+            ring->waitWritable(std::chrono::milliseconds(100));
+        }
+        return int(total);
     }
 
-    int recv(void *buff, const size_t length, const int flags)
+    //payloads up to a quarter of the ring are exposed in place,
+    //larger payloads are copied so they cannot wait on a full ring
+    Pothos::BufferChunk recvChunk(const size_t length)
     {
-        return clientSock.receiveBytes(buff, int(length), flags);
+        if (length > ring->capacity()/4) return Pothos::BufferChunk();
+        while (not ring->waitReadable(length, std::chrono::milliseconds(100)))
+        {
+            if (ring->peerClosed()) return Pothos::BufferChunk();
+        }
+        return ring->readChunk(length);
     }
 
-    bool server;
-    bool connected;
-    Poco::Net::ServerSocket serverSock;
-    Poco::Net::StreamSocket clientSock;
+    std::shared_ptr<SharedMemoryRing> ring;
 };
+#endif //HAS_SHM_RING
 
 /***********************************************************************
  * Protocol header format
@@ -140,6 +1163,486 @@ struct PothosPacketHeader
     uint32_t packetCount;
 };
 
+/***********************************************************************
+ * Reliable UDP implementation of interface:
+ * The byte stream is carried in datagrams with a small sequence header.
+ * The stream itself already holds the PTH2 framed packets of the
+ * endpoint, so the datagram header only carries what the transport needs.
+ * The receiver acknowledges in order delivery and selectively requests
+ * missing datagrams with NAK messages; the sender keeps a bounded buffer
+ * of unacknowledged datagrams for retransmission, and paces its output
+ * with a rate that backs off on loss. Windowing is left to the FLO
+ * messages of the endpoint as with the other transports.
+ * A background thread reads the socket and runs the timers,
+ * readers and writers block on condition variables.
+ * The server serves one client at a time: another address takes over
+ * when it starts a new session (sequence 0), or when the current client
+ * has been silent for the idle timeout, and the transport state is reset.
+ **********************************************************************/
+#define PothosPacketFlagNak (1 << 6)
+
+struct PothosUdpDatagramHeader
+{
+    uint16_t headerWord;
+    uint16_t flags;
+    uint32_t seq;
+};
+
+static const uint16_t PothosUdpDatagramWord = uint16_t(('P' << 8) | 'U');
+
+#define UDP_DATAGRAM_PAYLOAD 1400 //bytes of stream per datagram
+#define UDP_RETRANSMIT_MAX 8192 //unacknowledged datagrams held by the sender
+#define UDP_REORDER_MAX 8192 //out of order datagrams held by the receiver
+#define UDP_NAK_MAX 128 //missing sequences reported per NAK
+#define UDP_ACK_INTERVAL 32 //acknowledge every N datagrams in order
+#define UDP_PACING_BURST (64*1024) //bytes that can be sent back to back
+#define UDP_RATE_MIN 1e6 //bytes per second
+#define UDP_RATE_START 12.5e6 //bytes per second
+#define UDP_RATE_DEFAULT_MAX 125e6 //bytes per second
+#define UDP_TIMER_INTERVAL_MS 5 //resolution of the acknowledgement timers
+#define UDP_STREAM_COMPACT (64*1024) //consumed stream bytes before compaction
+#define UDP_IDLE_TIMEOUT_S 5 //give up on a silent peer
+
+struct PothosPacketSocketEndpointInterfaceUdp : PothosPacketSocketEndpointInterface
+{
+    typedef std::chrono::high_resolution_clock::time_point TimePoint;
+
+    PothosPacketSocketEndpointInterfaceUdp(const Poco::Net::SocketAddress &addr, const bool server, const double maxRate):
+        server(server),
+        peer(addr),
+        peerKnown(not server),
+        maxRate(std::max(maxRate, UDP_RATE_MIN)),
+        done(false),
+        txSeq(0),
+        rate(std::min(UDP_RATE_START, this->maxRate)),
+        tokens(UDP_PACING_BURST),
+        rxNextSeq(0),
+        rxAckedSeq(0),
+        rxStreamOffset(0)
+    {
+        if (server) this->sock = Poco::Net::DatagramSocket(addr, true);
+        else
+        {
+            this->sock = Poco::Net::DatagramSocket(addr.family());
+            this->sock.connect(addr);
+        }
+        const auto now = std::chrono::high_resolution_clock::now();
+        lastRefill = lastRateCut = lastAckProgress = lastAckTime = lastNakTime = lastPeerRx = now;
+        rxThread = std::thread(&PothosPacketSocketEndpointInterfaceUdp::rxLoop, this);
+    }
+
+    ~PothosPacketSocketEndpointInterfaceUdp(void)
+    {
+        done = true;
+        rxThread.join();
+        this->sock.close();
+    }
+
+    std::string getPort(void) const
+    {
+        return std::to_string(sock.address().port());
+    }
+
+    bool isRecvReady(const std::chrono::high_resolution_clock::duration &timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return rxCond.wait_for(lock, timeout, [this]{return rxStream.size() != rxStreamOffset;});
+    }
+
+    int send(const void *buff, const size_t length, const int flags)
+    {
+        struct iovec iov;
+        iov.iov_base = const_cast<void *>(buff);
+        iov.iov_len = length;
+        return this->sendv(&iov, 1, flags);
+    }
+
+    int recv(void *buff, const size_t length, const int flags)
+    {
+        //like a socket, block until data arrives, but give up on a silent peer
+        const size_t numBytes = ((flags & MSG_WAITALL) != 0)?length:1;
+        std::unique_lock<std::mutex> lock(mutex);
+        if (not rxCond.wait_for(lock, std::chrono::seconds(UDP_IDLE_TIMEOUT_S),
+            [this, numBytes]{return rxStream.size() - rxStreamOffset >= numBytes;})) return 0;
+
+        const size_t available = rxStream.size() - rxStreamOffset;
+        const size_t num = std::min(available, length);
+        std::memcpy(buff, rxStream.data() + rxStreamOffset, num);
+        rxStreamOffset += num;
+
+        //release the consumed bytes once they are at least half of the stream,
+        //so a reader that never fully catches up does not grow the stream forever
+        if (rxStreamOffset == rxStream.size())
+        {
+            rxStream.clear();
+            rxStreamOffset = 0;
+        }
+        else if (rxStreamOffset >= UDP_STREAM_COMPACT and rxStreamOffset >= rxStream.size() - rxStreamOffset)
+        {
+            rxStream.erase(rxStream.begin(), rxStream.begin() + rxStreamOffset);
+            rxStreamOffset = 0;
+        }
+        return int(num);
+    }
+
+    int sendv(const struct iovec *iov, const size_t iovcnt, const int)
+    {
+        if (not peerKnown) throw Pothos::Exception("PothosPacketSocketEndpointInterfaceUdp::send()", "remote address unknown");
+
+        size_t total = 0;
+        size_t iovIndex = 0, iovOffset = 0;
+        while (iovIndex < iovcnt)
+        {
+            //gather up to one datagram worth of the iovec list
+            std::vector<char> datagram = this->takeDatagram();
+            datagram.resize(sizeof(PothosUdpDatagramHeader));
+            while (iovIndex < iovcnt and datagram.size() < sizeof(PothosUdpDatagramHeader)+UDP_DATAGRAM_PAYLOAD)
+            {
+                const size_t num = std::min(iov[iovIndex].iov_len - iovOffset, sizeof(PothosUdpDatagramHeader)+UDP_DATAGRAM_PAYLOAD - datagram.size());
+                const char *p = reinterpret_cast<const char *>(iov[iovIndex].iov_base) + iovOffset;
+                datagram.insert(datagram.end(), p, p+num);
+                iovOffset += num;
+                if (iovOffset == iov[iovIndex].iov_len)
+                {
+                    iovIndex++;
+                    iovOffset = 0;
+                }
+            }
+            const size_t payloadBytes = datagram.size() - sizeof(PothosUdpDatagramHeader);
+            if (payloadBytes == 0)
+            {
+                this->recycleDatagram(std::move(datagram));
+                break;
+            }
+
+            //wait for space in the retransmit buffer and for the pacing tokens
+            std::unique_lock<std::mutex> lock(mutex);
+            this->waitToSend(lock, datagram.size());
+
+            //a lost datagram is recovered by retransmission like any other loss
+            this->packHeader(datagram.data(), PothosPacketFlagPsh, uint32_t(txSeq));
+            try {this->sendRaw(datagram);}
+            catch (const Poco::Exception &){}
+            unacked.emplace_back(txSeq++, std::move(datagram));
+            total += payloadBytes;
+        }
+        return int(total);
+    }
+
+    void setBufferSizes(const size_t numBytes)
+    {
+        //headroom for bursts and retransmissions
+        sock.setSendBufferSize(int(numBytes*2));
+        sock.setReceiveBufferSize(int(numBytes*2));
+    }
+
+    //datagram storage is recycled between the retransmit and reorder buffers
+    std::vector<char> takeDatagram(void)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (datagramPool.empty()) return std::vector<char>();
+        std::vector<char> datagram(std::move(datagramPool.back()));
+        datagramPool.pop_back();
+        datagram.clear();
+        return datagram;
+    }
+
+    //call with the mutex held
+    void recycleDatagram(std::vector<char> &&datagram)
+    {
+        if (datagramPool.size() < UDP_RETRANSMIT_MAX) datagramPool.push_back(std::move(datagram));
+    }
+
+    void packHeader(char *buff, const uint16_t flags, const uint32_t seq)
+    {
+        PothosUdpDatagramHeader header;
+        header.headerWord = Poco::ByteOrder::toNetwork(PothosUdpDatagramWord);
+        header.flags = Poco::ByteOrder::toNetwork(uint16_t(flags));
+        header.seq = Poco::ByteOrder::toNetwork(seq);
+        std::memcpy(buff, &header, sizeof(header));
+    }
+
+    void sendRaw(const std::vector<char> &datagram)
+    {
+        sock.sendTo(datagram.data(), int(datagram.size()), peer);
+    }
+
+    //call with the mutex held, the lock is released while waiting
+    void waitToSend(std::unique_lock<std::mutex> &lock, const size_t numBytes)
+    {
+        const auto exitTime = std::chrono::high_resolution_clock::now() + std::chrono::seconds(UDP_IDLE_TIMEOUT_S);
+        while (true)
+        {
+            const auto now = std::chrono::high_resolution_clock::now();
+            const double elapsed = std::chrono::duration<double>(now - lastRefill).count();
+            tokens = std::min<double>(UDP_PACING_BURST, tokens + elapsed*rate);
+            lastRefill = now;
+            if (unacked.size() < UDP_RETRANSMIT_MAX and tokens >= numBytes)
+            {
+                tokens -= numBytes;
+                return;
+            }
+            if (now > exitTime) throw Pothos::Exception("PothosPacketSocketEndpointInterfaceUdp::send()", "no acknowledgements from remote");
+
+            //wait for acknowledgements to free the buffer, or sleep off a short pacing deficit
+            if (unacked.size() >= UDP_RETRANSMIT_MAX) txCond.wait_until(lock, exitTime);
+            else
+            {
+                const auto deficit = std::chrono::duration<double>((numBytes - tokens)/rate);
+                lock.unlock();
+                std::this_thread::sleep_for(deficit);
+                lock.lock();
+            }
+        }
+    }
+
+    //receive and handle datagrams, and run the timers in between
+    void rxLoop(void)
+    {
+        char buff[sizeof(PothosUdpDatagramHeader)+UDP_DATAGRAM_PAYLOAD+UDP_NAK_MAX*sizeof(uint32_t)];
+        const Poco::Timespan timerInterval(Poco::Timespan::TimeDiff(UDP_TIMER_INTERVAL_MS*1000));
+        while (not done)
+        {
+            auto tspan = timerInterval;
+            for (size_t i = 0; i < 64 and sock.poll(tspan, Poco::Net::Socket::SELECT_READ); i++)
+            {
+                tspan = Poco::Timespan(0);
+                try
+                {
+                    Poco::Net::SocketAddress from;
+                    const int ret = sock.receiveFrom(buff, sizeof(buff), from);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (ret > 0) this->handleDatagram(buff, size_t(ret), from);
+                }
+                catch (const Poco::Exception &)
+                {
+                    //ICMP errors are reported on receive, the peer may not be up yet
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            this->service();
+        }
+    }
+
+    void handleDatagram(const char *buff, const size_t length, const Poco::Net::SocketAddress &from)
+    {
+        if (length < sizeof(PothosUdpDatagramHeader)) return;
+        PothosUdpDatagramHeader header;
+        std::memcpy(&header, buff, sizeof(header));
+        if (Poco::ByteOrder::fromNetwork(header.headerWord) != PothosUdpDatagramWord) return;
+        const uint16_t flags = Poco::ByteOrder::fromNetwork(header.flags);
+        const size_t payloadBytes = length - sizeof(PothosUdpDatagramHeader);
+        const char *payload = buff + sizeof(PothosUdpDatagramHeader);
+
+        //the server learns its peer from the first datagram,
+        //and follows a restarted client that starts a new session from another address
+        const auto now = std::chrono::high_resolution_clock::now();
+        if (server and peerKnown and from != peer)
+        {
+            const bool newSession = (flags & PothosPacketFlagPsh) != 0 and Poco::ByteOrder::fromNetwork(header.seq) == 0;
+            const bool peerIdle = now - lastPeerRx > std::chrono::seconds(UDP_IDLE_TIMEOUT_S);
+            if (not newSession and not peerIdle) return;
+            this->resetSession();
+        }
+        if (not peerKnown)
+        {
+            peer = from;
+            peerKnown = true;
+        }
+        lastPeerRx = now;
+
+        if ((flags & PothosPacketFlagNak) != 0) return this->handleNak(payload, payloadBytes);
+
+        //extend the 32-bit sequence relative to the next expected sequence
+        const uint64_t seq = rxNextSeq + int32_t(Poco::ByteOrder::fromNetwork(header.seq) - uint32_t(rxNextSeq));
+
+        //a duplicate means that our acknowledgement was lost, repeat it soon
+        if (seq < rxNextSeq)
+        {
+            rxAckedSeq = std::min(rxAckedSeq, rxNextSeq-1);
+            return;
+        }
+
+        //hold out of order datagrams and request the missing ones
+        if (seq != rxNextSeq)
+        {
+            if (seq - rxNextSeq >= UDP_REORDER_MAX) return;
+            const bool newGap = reorder.empty() or seq > reorder.rbegin()->first+1;
+            auto &held = reorder[seq];
+            if (held.capacity() == 0 and not datagramPool.empty())
+            {
+                held = std::move(datagramPool.back());
+                datagramPool.pop_back();
+            }
+            held.assign(payload, payload+payloadBytes);
+            if (newGap) this->sendNak();
+            return;
+        }
+
+        //deliver in order, and everything that was waiting on it
+        rxStream.insert(rxStream.end(), payload, payload+payloadBytes);
+        rxNextSeq++;
+        while (not reorder.empty() and reorder.begin()->first == rxNextSeq)
+        {
+            auto &data = reorder.begin()->second;
+            rxStream.insert(rxStream.end(), data.begin(), data.end());
+            this->recycleDatagram(std::move(data));
+            reorder.erase(reorder.begin());
+            rxNextSeq++;
+        }
+        rxCond.notify_all();
+        if (rxNextSeq - rxAckedSeq >= UDP_ACK_INTERVAL) this->sendNak();
+    }
+
+    //call with the mutex held, forget the peer and the transport state of its session
+    void resetSession(void)
+    {
+        peerKnown = false;
+        txSeq = 0;
+        while (not unacked.empty())
+        {
+            this->recycleDatagram(std::move(unacked.front().second));
+            unacked.pop_front();
+        }
+        rate = std::min(UDP_RATE_START, maxRate);
+        tokens = UDP_PACING_BURST;
+        rxNextSeq = rxAckedSeq = 0;
+        for (auto &entry : reorder) this->recycleDatagram(std::move(entry.second));
+        reorder.clear();
+        rxStream.clear();
+        rxStreamOffset = 0;
+        const auto now = std::chrono::high_resolution_clock::now();
+        lastRefill = lastRateCut = lastAckProgress = lastAckTime = lastNakTime = now;
+        txCond.notify_all();
+    }
+
+    //the NAK carries the cumulative acknowledgement and the missing sequences
+    void sendNak(void)
+    {
+        nakDatagram.resize(sizeof(PothosUdpDatagramHeader));
+        auto put32 = [this](const uint32_t value)
+        {
+            const uint32_t valueN = Poco::ByteOrder::toNetwork(value);
+            const char *p = reinterpret_cast<const char *>(&valueN);
+            nakDatagram.insert(nakDatagram.end(), p, p+sizeof(valueN));
+        };
+        size_t numMissing = 0;
+        uint64_t seq = rxNextSeq;
+        put32(uint32_t(rxNextSeq));
+        put32(0); //filled in below
+        for (const auto &entry : reorder)
+        {
+            for (; seq < entry.first and numMissing < UDP_NAK_MAX; seq++, numMissing++) put32(uint32_t(seq));
+            seq = entry.first+1;
+        }
+        const uint32_t numMissingN = Poco::ByteOrder::toNetwork(uint32_t(numMissing));
+        std::memcpy(nakDatagram.data()+sizeof(PothosUdpDatagramHeader)+sizeof(uint32_t), &numMissingN, sizeof(numMissingN));
+        this->packHeader(nakDatagram.data(), PothosPacketFlagNak, 0);
+        try {this->sendRaw(nakDatagram);}
+        catch (const Poco::Exception &){}
+
+        const auto now = std::chrono::high_resolution_clock::now();
+        rxAckedSeq = rxNextSeq;
+        lastAckTime = now;
+        if (numMissing != 0) lastNakTime = now;
+    }
+
+    void handleNak(const char *payload, const size_t length)
+    {
+        if (length < 2*sizeof(uint32_t)) return;
+        auto get32 = [payload](const size_t i)
+        {
+            uint32_t valueN; std::memcpy(&valueN, payload+i*sizeof(valueN), sizeof(valueN));
+            return Poco::ByteOrder::fromNetwork(valueN);
+        };
+        const size_t numMissing = std::min<size_t>(get32(1), length/sizeof(uint32_t)-2);
+
+        //release the acknowledged datagrams
+        const uint32_t ackSeq = get32(0);
+        bool progress = false;
+        while (not unacked.empty() and int32_t(ackSeq - uint32_t(unacked.front().first)) > 0)
+        {
+            this->recycleDatagram(std::move(unacked.front().second));
+            unacked.pop_front();
+            progress = true;
+        }
+        const auto now = std::chrono::high_resolution_clock::now();
+        if (progress)
+        {
+            lastAckProgress = now;
+            txCond.notify_all();
+        }
+
+        //retransmit the missing datagrams
+        for (size_t i = 0; i < numMissing and not unacked.empty(); i++)
+        {
+            const uint64_t index = uint32_t(get32(i+2) - uint32_t(unacked.front().first));
+            if (index < unacked.size()) this->sendRaw(unacked[size_t(index)].second);
+        }
+
+        //loss cuts the rate once per interval, otherwise probe for more bandwidth
+        if (numMissing != 0)
+        {
+            if (now - lastRateCut < std::chrono::milliseconds(50)) return;
+            rate = std::max(rate*0.8, UDP_RATE_MIN);
+            lastRateCut = now;
+        }
+        else if (progress) rate = std::min(rate*1.02, maxRate);
+    }
+
+    void service(void)
+    {
+        const auto now = std::chrono::high_resolution_clock::now();
+
+        //receiver: repeat requests for missing datagrams, acknowledge idle progress
+        if (not reorder.empty() and now - lastNakTime > std::chrono::milliseconds(20)) this->sendNak();
+        else if (rxAckedSeq != rxNextSeq and now - lastAckTime > std::chrono::milliseconds(UDP_TIMER_INTERVAL_MS)) this->sendNak();
+
+        //sender: retransmit the oldest datagram when acknowledgements stop (tail loss)
+        if (not unacked.empty() and now - lastAckProgress > std::chrono::milliseconds(50))
+        {
+            try {this->sendRaw(unacked.front().second);}
+            catch (const Poco::Exception &){}
+            lastAckProgress = now;
+            rate = std::max(rate*0.8, UDP_RATE_MIN);
+            lastRateCut = now;
+        }
+    }
+
+    bool server;
+    Poco::Net::DatagramSocket sock;
+    Poco::Net::SocketAddress peer;
+    bool peerKnown;
+    const double maxRate;
+    std::atomic<bool> done;
+    std::thread rxThread;
+    std::mutex mutex; //protects the state below
+    std::condition_variable rxCond; //stream bytes were delivered
+    std::condition_variable txCond; //datagrams were acknowledged
+    std::vector<std::vector<char>> datagramPool;
+
+    //sender state
+    uint64_t txSeq;
+    std::deque<std::pair<uint64_t, std::vector<char>>> unacked;
+    double rate; //bytes per second
+    double tokens;
+    TimePoint lastRefill;
+    TimePoint lastRateCut;
+    TimePoint lastAckProgress;
+
+    //receiver state
+    uint64_t rxNextSeq;
+    uint64_t rxAckedSeq;
+    std::map<uint64_t, std::vector<char>> reorder;
+    std::vector<char> rxStream;
+    size_t rxStreamOffset;
+    std::vector<char> nakDatagram;
+    TimePoint lastAckTime;
+    TimePoint lastNakTime;
+    TimePoint lastPeerRx;
+};
+
 /***********************************************************************
  * States for connection establishment and termination
  **********************************************************************/
@@ -168,6 +1671,17 @@ struct PothosPacketSocketEndpoint::Impl
         lastSentPacketCount(0),
         nextRecvPacketCount(0),
         bytesLeftInStream(0),
+        localFeatures(PothosPacketFeatureCompactCodec | PothosPacketFeatureChannels),
+        features(0),
+        configWindowBytes(FLOW_WINDOW_DEFAULT),
+        flowWindowBytes(FLOW_WINDOW_DEFAULT),
+        flowAckBytes(FLOW_WINDOW_DEFAULT/8),
+        autoWindow(false),
+        smoothedRtt(0.0),
+        stalled(false),
+        stallCount(0),
+        stallTimeNs(0),
+        publishing(false),
         iface(nullptr)
     {
         return;
@@ -185,6 +1699,30 @@ struct PothosPacketSocketEndpoint::Impl
     uint64_t lastFlowMsgRecv;
     uint64_t lastFlowMsgSent;
 
+    //negotiated features
+    uint32_t localFeatures;
+    uint32_t features;
+
+    //flow control window
+    uint64_t configWindowBytes; //0 for automatic
+    std::atomic<uint64_t> flowWindowBytes; //current window, read by the sender
+    uint64_t flowAckBytes; //negotiated acknowledgement interval
+    bool autoWindow;
+    double smoothedRtt; //seconds
+    std::chrono::high_resolution_clock::time_point synSentTime;
+    std::chrono::high_resolution_clock::time_point lastFlowTime;
+    std::deque<std::pair<uint64_t, std::chrono::high_resolution_clock::time_point>> rttSamples;
+
+    //stall statistics from isReady(), the stall start is guarded by the flow mutex
+    bool stalled;
+    std::chrono::high_resolution_clock::time_point stallStart;
+    std::atomic<unsigned long long> stallCount;
+    std::atomic<long long> stallTimeNs;
+
+    //listening socket of a publishing endpoint
+    bool publishing;
+    Poco::Net::ServerSocket publishSock;
+
     PothosPacketSocketEndpointInterface *iface;
 
     void unpackHeader(const PothosPacketHeader &header, const size_t recvBytes, uint16_t &flags, uint16_t &type, size_t &payloadBytes);
@@ -193,15 +1731,45 @@ struct PothosPacketSocketEndpoint::Impl
     {
         return this->send(flags, 0, nullptr, 0);
     }
-    void send(const uint16_t flags, const uint16_t type, const void *buff, const size_t numBytes, const bool more = false);
+    void send(const uint16_t flags, const uint16_t type, const void *buff, const size_t numBytes, const bool more = false, const Pothos::BufferChunk &ref = Pothos::BufferChunk());
     void recv(uint16_t &flags, uint16_t &type, Pothos::BufferChunk &buffer, const std::chrono::high_resolution_clock::duration &timeout);
 
     uint64_t flowControlWindowBytes(void) const
     {
-        return 256*1024;
+        return this->flowWindowBytes;
+    }
+
+    //the syn payload contains the local window and features
+    void sendSyn(const uint16_t flags)
+    {
+        char payload[sizeof(uint64_t)+sizeof(uint32_t)];
+        const uint64_t windowN = Poco::ByteOrder::toNetwork(Poco::UInt64(this->configWindowBytes));
+        const uint32_t featuresN = Poco::ByteOrder::toNetwork(Poco::UInt32(this->localFeatures));
+        std::memcpy(payload, &windowN, sizeof(windowN));
+        std::memcpy(payload+sizeof(windowN), &featuresN, sizeof(featuresN));
+        this->synSentTime = std::chrono::high_resolution_clock::now();
+        return this->send(flags, 0, payload, sizeof(payload));
+    }
+
+    void negotiateWindow(const uint64_t remoteWindowBytes);
+    void updateRtt(const std::chrono::high_resolution_clock::time_point &sentTime);
+    void tuneWindow(const uint64_t numBytes, const std::chrono::high_resolution_clock::time_point &now);
+
+    void packHeader(PothosPacketHeader &header, const uint16_t flags, const uint16_t type, const size_t numBytes)
+    {
+        header.headerWord = Poco::ByteOrder::toNetwork(PothosPacketHeaderWord);
+        header.flags = Poco::ByteOrder::toNetwork(flags);
+        header.payloadBytes = Poco::ByteOrder::toNetwork(uint32_t(numBytes));
+        header.packetCount = Poco::ByteOrder::toNetwork(uint32_t(this->lastSentPacketCount++));
+        header.type = Poco::ByteOrder::toNetwork(type);
     }
 
     std::mutex sendMutex;
+    std::vector<char> coalesced; //queued frames sent in front of the next frame
+
+    //signaled when window credit arrives
+    std::mutex flowMutex;
+    std::condition_variable flowCond;
 };
 
 /***********************************************************************
@@ -213,11 +1781,78 @@ PothosPacketSocketEndpoint::PothosPacketSocketEndpoint(const std::string &uri, c
     if (opt == "DISCONNECT") return;
     if (opt == "BIND") _impl->state = EP_STATE_LISTEN;
     if (opt == "CONNECT") _impl->state = EP_STATE_CLOSED;
+    #ifdef HAS_AF_UNIX
+    static const std::string unixPrefix("unix://");
+    if (uri.compare(0, unixPrefix.size(), unixPrefix) == 0)
+    {
+        if (opt != "BIND" and opt != "CONNECT") throw Pothos::InvalidArgumentException(
+            "PothosPacketSocketEndpoint("+uri+" -> "+opt+")", "unknown opt, expects CONNECT/BIND");
+        _impl->iface = new PothosPacketSocketEndpointInterfaceUnix(uri.substr(unixPrefix.size()), opt == "BIND");
+        return;
+    }
+    #endif //HAS_AF_UNIX
+
+    #ifdef HAS_SHM_RING
+    static const std::string shmPrefix("shm://");
+    if (uri.compare(0, shmPrefix.size(), shmPrefix) == 0)
+    {
+        if (opt != "BIND" and opt != "CONNECT") throw Pothos::InvalidArgumentException(
+            "PothosPacketSocketEndpoint("+uri+" -> "+opt+")", "unknown opt, expects CONNECT/BIND");
+        std::string name = uri.substr(shmPrefix.size());
+        size_t size = SHM_RING_DEFAULT_SIZE;
+        const auto query = name.find("?size=");
+        if (query != std::string::npos)
+        {
+            Poco::UInt64 sizeArg = 0;
+            if (not Poco::NumberParser::tryParseUnsigned64(name.substr(query+6), sizeArg) or sizeArg == 0)
+            {
+                throw Pothos::InvalidArgumentException("PothosPacketSocketEndpoint("+uri+")", "invalid size="+name.substr(query+6));
+            }
+            size = size_t(sizeArg);
+            name = name.substr(0, query);
+        }
+        _impl->iface = new PothosPacketSocketEndpointInterfaceShm(name, size, opt == "BIND");
+        return;
+    }
+    #endif //HAS_SHM_RING
+
     try
     {
         Poco::URI uriObj(uri);
         const Poco::Net::SocketAddress addr(uriObj.getHost(), uriObj.getPort());
-        if (uriObj.getScheme() == "tcp" and opt == "BIND")
+
+        //the streams query parameter stripes the link over several connections
+        //the rate query parameter limits the udp transmit rate in bytes per second
+        size_t numStreams = 1;
+        double maxRate = UDP_RATE_DEFAULT_MAX;
+        for (const auto &param : uriObj.getQueryParameters())
+        {
+            Poco::UInt64 streams = 0;
+            if (param.first == "streams" and (not Poco::NumberParser::tryParseUnsigned64(param.second, streams) or streams == 0 or streams > 1024))
+            {
+                throw Pothos::InvalidArgumentException("PothosPacketSocketEndpoint("+uri+")", "invalid streams="+param.second);
+            }
+            if (param.first == "streams") numStreams = size_t(streams);
+            if (param.first == "rate" and (not Poco::NumberParser::tryParseFloat(param.second, maxRate) or not (maxRate > 0.0)))
+            {
+                throw Pothos::InvalidArgumentException("PothosPacketSocketEndpoint("+uri+")", "invalid rate="+param.second);
+            }
+        }
+
+        if (uriObj.getScheme() == "tcp" and opt == "PUBLISH")
+        {
+            _impl->publishSock = Poco::Net::ServerSocket(addr, PUBLISH_BACKLOG);
+            _impl->publishing = true;
+        }
+        else if (uriObj.getScheme() == "udp" and (opt == "BIND" or opt == "CONNECT"))
+        {
+            _impl->iface = new PothosPacketSocketEndpointInterfaceUdp(addr, opt == "BIND", maxRate);
+        }
+        else if (uriObj.getScheme() == "tcp" and numStreams > 1 and (opt == "BIND" or opt == "CONNECT"))
+        {
+            _impl->iface = new PothosPacketSocketEndpointInterfaceTcpStriped(addr, opt == "BIND", numStreams);
+        }
+        else if (uriObj.getScheme() == "tcp" and opt == "BIND")
         {
             _impl->iface = new PothosPacketSocketEndpointInterfaceTcp(addr, true);
         }
@@ -228,7 +1863,7 @@ PothosPacketSocketEndpoint::PothosPacketSocketEndpoint(const std::string &uri, c
         else
         {
             throw Pothos::InvalidArgumentException("PothosPacketSocketEndpoint("+uri+" -> "+opt+")",
-                "unknown URI scheme + opt combo, expects tcp/udp, CONNECT/BIND");
+                "unknown URI scheme + opt combo, expects tcp/udp/unix/shm, CONNECT/BIND, or tcp PUBLISH");
         }
     }
     catch (const Poco::Exception &ex)
@@ -248,18 +1883,91 @@ PothosPacketSocketEndpoint::~PothosPacketSocketEndpoint(void)
         //failure OK, other endpoint may be destructed
     }
     delete _impl->iface;
+    if (_impl->publishing) _impl->publishSock.close();
     delete _impl;
 }
 
 std::string PothosPacketSocketEndpoint::getActualPort(void) const
 {
+    if (_impl->publishing) return std::to_string(_impl->publishSock.address().port());
     return _impl->iface->getPort();
 }
 
+std::shared_ptr<PothosPacketSocketEndpoint> PothosPacketSocketEndpoint::accept(const std::chrono::high_resolution_clock::duration &timeout)
+{
+    if (not _impl->publishing) throw Pothos::InvalidArgumentException(
+        "PothosPacketSocketEndpoint::accept()", "not a publishing endpoint");
+
+    const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(timeout).count();
+    const auto tspan = Poco::Timespan(Poco::Timespan::TimeDiff(micros));
+    if (not _impl->publishSock.poll(tspan, Poco::Net::Socket::SELECT_READ)) return nullptr;
+
+    //the subscriber endpoint answers the handshake as a bound endpoint would
+    std::shared_ptr<PothosPacketSocketEndpoint> ep(new PothosPacketSocketEndpoint("", "DISCONNECT"));
+    ep->_impl->iface = new PothosPacketSocketEndpointInterfaceTcp(_impl->publishSock.acceptConnection());
+    ep->_impl->state = EP_STATE_LISTEN;
+    ep->_impl->configWindowBytes = _impl->configWindowBytes;
+    return ep;
+}
+
 bool PothosPacketSocketEndpoint::isReady(void)
 {
-    return (_impl->state == EP_STATE_ESTABLISHED) and
-        (_impl->lastFlowMsgRecv + _impl->flowControlWindowBytes() > _impl->totalBytesSent);
+    if (_impl->state != EP_STATE_ESTABLISHED) return false;
+    const bool windowOpen = (_impl->lastFlowMsgRecv + _impl->flowControlWindowBytes() > _impl->totalBytesSent);
+
+    //track the number and the duration of stalls on a closed window
+    if (windowOpen == _impl->stalled)
+    {
+        std::lock_guard<std::mutex> lock(_impl->flowMutex);
+        const auto now = std::chrono::high_resolution_clock::now();
+        if (_impl->stalled) _impl->stallTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(now - _impl->stallStart).count();
+        else _impl->stallCount++;
+        _impl->stallStart = now;
+        _impl->stalled = not windowOpen;
+    }
+    return windowOpen;
+}
+
+bool PothosPacketSocketEndpoint::waitReady(const std::chrono::high_resolution_clock::duration &timeout)
+{
+    if (this->isReady()) return true;
+    {
+        std::unique_lock<std::mutex> lock(_impl->flowMutex);
+        _impl->flowCond.wait_for(lock, timeout, [this]{
+            return _impl->state == EP_STATE_ESTABLISHED and
+                _impl->lastFlowMsgRecv + _impl->flowControlWindowBytes() > _impl->totalBytesSent;
+        });
+    }
+    return this->isReady();
+}
+
+uint32_t PothosPacketSocketEndpoint::getFeatures(void) const
+{
+    return _impl->features;
+}
+
+void PothosPacketSocketEndpoint::setFlowControlWindow(const size_t numBytes)
+{
+    _impl->configWindowBytes = numBytes;
+}
+
+size_t PothosPacketSocketEndpoint::getFlowControlWindow(void) const
+{
+    return size_t(_impl->flowWindowBytes);
+}
+
+unsigned long long PothosPacketSocketEndpoint::getStallCount(void) const
+{
+    return _impl->stallCount;
+}
+
+double PothosPacketSocketEndpoint::getStallTime(void) const
+{
+    std::lock_guard<std::mutex> lock(_impl->flowMutex);
+    auto stallTimeNs = _impl->stallTimeNs.load();
+    if (_impl->stalled) stallTimeNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::high_resolution_clock::now() - _impl->stallStart).count();
+    return stallTimeNs/1e9;
 }
 
 /***********************************************************************
@@ -276,11 +1984,16 @@ void PothosPacketSocketEndpoint::openComms(const std::chrono::high_resolution_cl
     _impl->totalBytesSent = 0;
     _impl->lastFlowMsgRecv = 0;
     _impl->lastFlowMsgSent = 0;
+    _impl->rttSamples.clear();
+    _impl->coalesced.clear();
+    _impl->smoothedRtt = 0.0;
+    _impl->features = 0;
+    _impl->stalled = false;
 
     //initiate connect operation
     if (_impl->state == EP_STATE_CLOSED)
     {
-        _impl->send(PothosPacketFlagSyn);
+        _impl->sendSyn(PothosPacketFlagSyn);
         _impl->state = EP_STATE_SYN_SENT;
     }
 
@@ -355,7 +2068,7 @@ void PothosPacketSocketEndpoint::Impl::handleState(const uint16_t &flags)
     case EP_STATE_LISTEN:
         if ((flags & PothosPacketFlagSyn) != 0)
         {
-            this->send(PothosPacketFlagSyn | PothosPacketFlagAck);
+            this->sendSyn(PothosPacketFlagSyn | PothosPacketFlagAck);
             this->state = EP_STATE_SYN_RECEIVED;
         }
         break;
@@ -363,12 +2076,13 @@ void PothosPacketSocketEndpoint::Impl::handleState(const uint16_t &flags)
     case EP_STATE_SYN_SENT:
         if ((flags & (PothosPacketFlagSyn | PothosPacketFlagAck)) != 0)
         {
+            this->updateRtt(this->synSentTime);
             this->send(PothosPacketFlagAck);
             this->state = EP_STATE_ESTABLISHED;
         }
         else if ((flags & PothosPacketFlagSyn) != 0)
         {
-            this->send(PothosPacketFlagSyn | PothosPacketFlagAck);
+            this->sendSyn(PothosPacketFlagSyn | PothosPacketFlagAck);
             this->state = EP_STATE_SYN_RECEIVED;
         }
         break;
@@ -376,6 +2090,7 @@ void PothosPacketSocketEndpoint::Impl::handleState(const uint16_t &flags)
     case EP_STATE_SYN_RECEIVED:
         if ((flags & PothosPacketFlagAck) != 0)
         {
+            this->updateRtt(this->synSentTime);
             this->state = EP_STATE_ESTABLISHED;
         }
         break;
@@ -436,6 +2151,53 @@ void PothosPacketSocketEndpoint::Impl::handleState(const uint16_t &flags)
     }
 }
 
+/***********************************************************************
+ * flow control window negotiation and tuning
+ **********************************************************************/
+void PothosPacketSocketEndpoint::Impl::negotiateWindow(const uint64_t remoteWindowBytes)
+{
+    //a fixed window on either side takes precedence over automatic,
+    //and both endpoints agree on the smaller of two fixed windows
+    const uint64_t localWindowBytes = this->configWindowBytes;
+    this->autoWindow = (localWindowBytes == 0) and (remoteWindowBytes == 0);
+    if (this->autoWindow) this->flowWindowBytes = FLOW_WINDOW_DEFAULT;
+    else if (localWindowBytes == 0) this->flowWindowBytes = remoteWindowBytes;
+    else if (remoteWindowBytes == 0) this->flowWindowBytes = localWindowBytes;
+    else this->flowWindowBytes = std::min(localWindowBytes, remoteWindowBytes);
+
+    //the acknowledgement interval is fixed for the duration of the connection,
+    //so the receiver always acknowledges within the sender's (growing) window
+    this->flowAckBytes = std::max<uint64_t>(this->flowWindowBytes/8, 1);
+    this->lastFlowTime = std::chrono::high_resolution_clock::now();
+
+    //only an explicitly configured window sizes the socket buffers,
+    //fixed buffer sizes would disable the kernel's buffer autotuning
+    if (this->configWindowBytes != 0 and this->configWindowBytes != FLOW_WINDOW_DEFAULT)
+    {
+        this->iface->setBufferSizes(size_t(this->flowWindowBytes));
+    }
+}
+
+void PothosPacketSocketEndpoint::Impl::updateRtt(const std::chrono::high_resolution_clock::time_point &sentTime)
+{
+    const auto rtt = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - sentTime).count();
+    if (this->smoothedRtt == 0.0) this->smoothedRtt = rtt;
+    else this->smoothedRtt = (7*this->smoothedRtt + rtt)/8;
+}
+
+void PothosPacketSocketEndpoint::Impl::tuneWindow(const uint64_t numBytes, const std::chrono::high_resolution_clock::time_point &now)
+{
+    const auto elapsed = std::chrono::duration<double>(now - this->lastFlowTime).count();
+    this->lastFlowTime = now;
+    if (not this->autoWindow or elapsed <= 0.0 or this->smoothedRtt == 0.0) return;
+
+    //size the window to twice the bandwidth-delay product, only grow with some hysteresis
+    const double rate = numBytes/elapsed;
+    const auto target = std::min<uint64_t>(uint64_t(2*rate*this->smoothedRtt), FLOW_WINDOW_MAXIMUM);
+    if (target <= this->flowWindowBytes + this->flowWindowBytes/4) return;
+    this->flowWindowBytes = target; //the kernel autotunes the socket buffers
+}
+
 /***********************************************************************
  * handler/parser for received buffers
  **********************************************************************/
@@ -511,7 +2273,8 @@ void PothosPacketSocketEndpoint::Impl::recv(uint16_t &flags, uint16_t &type, Pot
 
         //create a new buffer of the required length if need be
         //partial receives are always ok with packet buffer type
-        if (type != PothosPacketTypeBuffer and buffer.length < this->bytesLeftInStream)
+        //(the upper byte of the type holds the channel number)
+        if ((type & 0xff) != PothosPacketTypeBuffer and buffer.length < this->bytesLeftInStream)
         {
             buffer = Pothos::BufferChunk(this->bytesLeftInStream);
         }
@@ -524,8 +2287,20 @@ void PothosPacketSocketEndpoint::Impl::recv(uint16_t &flags, uint16_t &type, Pot
         type = lastType;
     }
 
-    //receive the payload into the available buffer
+    //stream data can be received in place when the transport supports it
     size_t bytesRecvd = 0;
+    if (this->bytesLeftInStream != 0 and ((type & 0xff) == PothosPacketTypeBuffer or (type & 0xff) == PothosPacketTypePayload))
+    {
+        auto chunk = this->iface->recvChunk(this->bytesLeftInStream);
+        if (chunk.address != 0)
+        {
+            buffer = chunk;
+            bytesRecvd = buffer.length;
+            this->totalBytesRecv += buffer.length;
+        }
+    }
+
+    //receive the payload into the available buffer
     buffer.length = std::min(buffer.length, this->bytesLeftInStream);
     while (buffer.length > bytesRecvd)
     {
@@ -540,16 +2315,56 @@ void PothosPacketSocketEndpoint::Impl::recv(uint16_t &flags, uint16_t &type, Pot
 
     this->bytesLeftInStream -= buffer.length;
 
+    //the remote window and features are negotiated during the handshake
+    //prior versions send an empty payload or a payload without features
+    if ((flags & PothosPacketFlagSyn) != 0)
+    {
+        uint64_t remoteWindowBytes = FLOW_WINDOW_DEFAULT;
+        uint32_t remoteFeatures = 0;
+        if (buffer.length >= sizeof(uint64_t))
+        {
+            uint64_t windowN; std::memcpy(&windowN, buffer.as<const char *>(), sizeof(windowN));
+            remoteWindowBytes = Poco::ByteOrder::fromNetwork(Poco::UInt64(windowN));
+        }
+        if (buffer.length >= sizeof(uint64_t)+sizeof(uint32_t))
+        {
+            uint32_t featuresN; std::memcpy(&featuresN, buffer.as<const char *>()+sizeof(uint64_t), sizeof(featuresN));
+            remoteFeatures = Poco::ByteOrder::fromNetwork(Poco::UInt32(featuresN));
+        }
+        this->negotiateWindow(remoteWindowBytes);
+        this->features = this->localFeatures & remoteFeatures;
+    }
+
     //deal with flow control (incoming)
     if ((flags & PothosPacketFlagFlo) != 0 and buffer.length >= sizeof(uint64_t))
     {
         const uint64_t totalN = buffer.as<const uint64_t *>()[0];
-        this->lastFlowMsgRecv = Poco::ByteOrder::fromNetwork(Poco::UInt64(totalN));
+        const uint64_t totalAcked = Poco::ByteOrder::fromNetwork(Poco::UInt64(totalN));
+        const auto now = std::chrono::high_resolution_clock::now();
+        if (this->autoWindow)
+        {
+            //the round trip time of the newest sent offset covered by this acknowledgement
+            std::unique_lock<std::mutex> lock(this->sendMutex);
+            auto sentTime = now;
+            while (not this->rttSamples.empty() and this->rttSamples.front().first <= totalAcked)
+            {
+                sentTime = this->rttSamples.front().second;
+                this->rttSamples.pop_front();
+            }
+            lock.unlock();
+            if (sentTime != now) this->updateRtt(sentTime);
+            this->tuneWindow(totalAcked - this->lastFlowMsgRecv, now);
+        }
+        std::unique_lock<std::mutex> flowLock(this->flowMutex);
+        this->lastFlowMsgRecv = totalAcked;
+        flowLock.unlock();
+        this->flowCond.notify_all();
     }
 
     //deal with flow control (outgoing)
-    if (this->totalBytesRecv > this->lastFlowMsgSent + this->flowControlWindowBytes()/8)
+    if (this->totalBytesRecv > this->lastFlowMsgSent + this->flowAckBytes)
     {
+        this->tuneWindow(this->totalBytesRecv - this->lastFlowMsgSent, std::chrono::high_resolution_clock::now());
         const uint64_t totalN = Poco::ByteOrder::toNetwork(Poco::UInt64(this->totalBytesRecv));
         this->send(PothosPacketFlagFlo, 0, &totalN, sizeof(totalN));
         this->lastFlowMsgSent = this->totalBytesRecv;
@@ -564,40 +2379,107 @@ void PothosPacketSocketEndpoint::send(const uint16_t type, const void *buff, con
     _impl->send(PothosPacketFlagPsh, type, buff, numBytes, more);
 }
 
-void PothosPacketSocketEndpoint::Impl::send(const uint16_t flags, const uint16_t type, const void *buff, const size_t numBytes, const bool more)
+void PothosPacketSocketEndpoint::send(const uint16_t type, const Pothos::BufferChunk &buffer, const bool more)
 {
-    std::unique_lock<std::mutex> lock(this->sendMutex);
+    _impl->send(PothosPacketFlagPsh, type, buffer.as<const void *>(), buffer.length, more, buffer);
+}
 
-    int ret;
-    bool hasMore;
+void PothosPacketSocketEndpoint::queue(const uint16_t type, const void *buff, const size_t numBytes)
+{
+    std::unique_lock<std::mutex> lock(_impl->sendMutex);
     PothosPacketHeader header;
-    header.headerWord = Poco::ByteOrder::toNetwork(PothosPacketHeaderWord);
-    header.flags = Poco::ByteOrder::toNetwork(flags);
-    header.payloadBytes = Poco::ByteOrder::toNetwork(uint32_t(numBytes));
-    header.packetCount = Poco::ByteOrder::toNetwork(uint32_t(this->lastSentPacketCount++));
-    header.type = Poco::ByteOrder::toNetwork(type);
+    _impl->packHeader(header, PothosPacketFlagPsh, type, numBytes);
+    auto &coalesced = _impl->coalesced;
+    coalesced.insert(coalesced.end(), reinterpret_cast<const char *>(&header), reinterpret_cast<const char *>(&header)+sizeof(header));
+    coalesced.insert(coalesced.end(), reinterpret_cast<const char *>(buff), reinterpret_cast<const char *>(buff)+numBytes);
+}
 
-    //send the header
-    hasMore = (numBytes != 0) or more;
-    ret = this->iface->send(&header, sizeof(header), hasMore?MSG_MORE:0);
-    if (ret != int(sizeof(header)))
+void PothosPacketSocketEndpoint::flush(void)
+{
+    std::unique_lock<std::mutex> lock(_impl->sendMutex);
+    auto &coalesced = _impl->coalesced;
+    size_t offset = 0;
+    while (offset < coalesced.size())
     {
-        throw Pothos::Exception("PothosPacketSocketEndpoint::send(header)", std::to_string(ret));
+        const int ret = _impl->iface->send(coalesced.data()+offset, coalesced.size()-offset);
+        if (ret <= 0) throw Pothos::Exception("PothosPacketSocketEndpoint::flush()", std::to_string(ret));
+        _impl->totalBytesSent += ret;
+        offset += size_t(ret);
     }
-    this->totalBytesSent += ret;
+    coalesced.clear();
+}
+
+size_t PothosPacketSocketEndpoint::queuedBytes(void) const
+{
+    std::unique_lock<std::mutex> lock(_impl->sendMutex);
+    return _impl->coalesced.size();
+}
+
+void PothosPacketSocketEndpoint::setZeroCopy(const bool enable)
+{
+    if (_impl->iface == nullptr) return; //applied to each subscriber by the caller
+    _impl->iface->setZeroCopy(enable);
+}
+
+void PothosPacketSocketEndpoint::Impl::send(const uint16_t flags, const uint16_t type, const void *buff, const size_t numBytes, const bool more, const Pothos::BufferChunk &ref)
+{
+    std::unique_lock<std::mutex> lock(this->sendMutex);
 
-    //send all of the available buffer
-    size_t bytesLeft = numBytes;
-    while (bytesLeft != 0)
+    int ret;
+    PothosPacketHeader header;
+    this->packHeader(header, flags, type, numBytes);
+
+    //the queued frames, header, and payload are sent together with a single vectored call,
+    //except for zero-copy payloads, where the frames and header are copied out first
+    //because the header stack memory cannot be pinned until the transfer completes
+    struct iovec iov[3];
+    iov[0].iov_base = this->coalesced.data();
+    iov[0].iov_len = this->coalesced.size();
+    iov[1].iov_base = &header;
+    iov[1].iov_len = sizeof(header);
+    iov[2].iov_base = const_cast<void *>(buff);
+    iov[2].iov_len = numBytes;
+    const bool zeroCopy = (ref.length != 0) and (numBytes >= ZERO_COPY_MIN_BYTES) and this->iface->zeroCopyEnabled();
+
+    //send all of the frames and buffer, resume after partial sends
+    size_t iovIndex = 0;
+    while (iovIndex < 3)
     {
-        const size_t bytesToSend = std::min<size_t>(bytesLeft, SEND_MTU);
-        hasMore = (bytesToSend != bytesLeft) or more;
-        ret = this->iface->send((const void *)(size_t(buff)+numBytes-bytesLeft), bytesToSend, hasMore?MSG_MORE:0);
+        if (iov[iovIndex].iov_len == 0)
+        {
+            iovIndex++;
+            continue;
+        }
+        const int sendFlags = more?MSG_MORE:0;
+        if (zeroCopy and iovIndex == 2) ret = this->iface->sendvZeroCopy(iov+iovIndex, 1, ref, sendFlags);
+        else if (zeroCopy) ret = this->iface->sendv(iov+iovIndex, 2-iovIndex, MSG_MORE);
+        else ret = this->iface->sendv(iov+iovIndex, 3-iovIndex, sendFlags);
         if (ret <= 0)
         {
             throw Pothos::Exception("PothosPacketSocketEndpoint::send(payload)", std::to_string(ret));
         }
         this->totalBytesSent += ret;
-        bytesLeft -= size_t(ret);
+
+        //advance the iovec list past the sent bytes
+        size_t bytesSent = size_t(ret);
+        while (iovIndex < 3 and bytesSent >= iov[iovIndex].iov_len)
+        {
+            bytesSent -= iov[iovIndex].iov_len;
+            iov[iovIndex++].iov_len = 0;
+        }
+        if (iovIndex < 3)
+        {
+            iov[iovIndex].iov_base = reinterpret_cast<char *>(iov[iovIndex].iov_base) + bytesSent;
+            iov[iovIndex].iov_len -= bytesSent;
+        }
+    }
+    this->coalesced.clear();
+
+    //sample send times once per acknowledgement interval to measure round trips
+    if (this->autoWindow and (this->rttSamples.empty() or
+        this->totalBytesSent >= this->rttSamples.back().first + this->flowAckBytes))
+    {
+        if (this->rttSamples.size() >= FLOW_RTT_MAX_SAMPLES) this->rttSamples.pop_front();
+        this->rttSamples.emplace_back(this->totalBytesSent, std::chrono::high_resolution_clock::now());
     }
 }
@@ -7,7 +7,10 @@
 #include <Pothos/Config.hpp>
 #include <Pothos/Framework/BufferChunk.hpp>
 #include <chrono>
+#include <memory>
+#include <string>
 #include <cstdint>
+#include <cstddef>
 
 static const uint16_t PothosPacketTypeMessage = uint16_t('M');
 static const uint16_t PothosPacketTypeLabel = uint16_t('L');
@@ -16,6 +19,31 @@ static const uint16_t PothosPacketTypeDType = uint16_t('D');
 static const uint16_t PothosPacketTypeHeader = uint16_t('H');
 static const uint16_t PothosPacketTypePayload = uint16_t('P');
 
+//compact encodings of the message, label, dtype, and header types
+static const uint16_t PothosPacketTypeMessageCompact = uint16_t('m');
+static const uint16_t PothosPacketTypeLabelCompact = uint16_t('l');
+static const uint16_t PothosPacketTypeDTypeCompact = uint16_t('d');
+static const uint16_t PothosPacketTypeHeaderCompact = uint16_t('h');
+
+//per-channel credit returned by a multiplexed network source
+static const uint16_t PothosPacketTypeCredit = uint16_t('C');
+
+//feature flags exchanged during the handshake
+static const uint32_t PothosPacketFeatureCompactCodec = (1 << 0);
+static const uint32_t PothosPacketFeatureChannels = (1 << 1);
+
+/*!
+ * Multiplexed channels share one connection:
+ * the upper byte of the type field holds the channel number,
+ * so that channel 0 is identical to the single channel protocol.
+ */
+static const size_t PothosPacketMaxChannels = 256;
+
+static inline uint16_t PothosPacketChannelType(const uint16_t type, const size_t channel)
+{
+    return uint16_t(type | (channel << 8));
+}
+
 class PothosPacketSocketEndpoint
 {
 public:
@@ -25,7 +53,7 @@ public:
      * For the URI scheme, the protocol can be udp or tcp.
      * Do not specify the port for automatic port selection on BIND.
      * \param uri the socket parameters proto://host:port
-     * \param opt the socket mode BIND or CONNECT
+     * \param opt the socket mode BIND, CONNECT, or PUBLISH (tcp only)
      */
     PothosPacketSocketEndpoint(const std::string &uri, const std::string &opt);
 
@@ -41,6 +69,16 @@ public:
      */
     std::string getActualPort(void) const;
 
+    /*!
+     * Accept a new subscriber on a PUBLISH endpoint.
+     * The publishing endpoint listens for any number of connections,
+     * and each subscriber gets its own endpoint with its own
+     * handshake and flow control, starting with openComms().
+     * \param timeout the maximum time to wait for a connection
+     * \return the subscriber's endpoint, or null on timeout
+     */
+    std::shared_ptr<PothosPacketSocketEndpoint> accept(const std::chrono::high_resolution_clock::duration &timeout);
+
     /*!
      * Perform the communication initialization handshake.
      */
@@ -51,11 +89,52 @@ public:
      */
     void closeComms(const std::chrono::high_resolution_clock::duration &timeout = std::chrono::milliseconds(100));
 
+    /*!
+     * Get the features supported by both endpoints.
+     * The features are negotiated in openComms().
+     * \return a bit mask of PothosPacketFeature flags
+     */
+    uint32_t getFeatures(void) const;
+
     /*!
      * Is the endpoint ready for communication?
+     * The endpoint is not ready when the flow control window is closed.
      */
     bool isReady(void);
 
+    /*!
+     * Wait for the endpoint to become ready for communication.
+     * The wait returns as soon as a flow control message
+     * from the remote endpoint opens the window.
+     * \param timeout the maximum time to wait
+     * \return true when the endpoint is ready
+     */
+    bool waitReady(const std::chrono::high_resolution_clock::duration &timeout);
+
+    /*!
+     * Set the flow control window size in bytes.
+     * The window is negotiated with the remote endpoint in openComms():
+     * the smaller fixed window is used, or an automatic window when
+     * both endpoints specify 0. The automatic window starts at 256 KiB
+     * and grows with the measured round trip time and throughput.
+     */
+    void setFlowControlWindow(const size_t numBytes);
+
+    /*!
+     * Get the current flow control window size in bytes.
+     */
+    size_t getFlowControlWindow(void) const;
+
+    /*!
+     * Get the number of times that isReady() stalled on a closed window.
+     */
+    unsigned long long getStallCount(void) const;
+
+    /*!
+     * Get the total time in seconds that isReady() stalled on a closed window.
+     */
+    double getStallTime(void) const;
+
     /*!
      * Receive data from the remote endpoint.
      */
@@ -66,6 +145,38 @@ public:
      */
     void send(const uint16_t type, const void *buff, const size_t numBytes, const bool more = false);
 
+    /*!
+     * Send a buffer to the remote endpoint.
+     * When zero-copy is enabled, large buffers are transmitted
+     * directly from their memory, and the endpoint holds a reference
+     * to the buffer until the kernel reports that the transfer completed.
+     */
+    void send(const uint16_t type, const Pothos::BufferChunk &buffer, const bool more = false);
+
+    /*!
+     * Queue a frame to be sent in front of the next frame.
+     * Queued frames keep their order, and are transmitted together
+     * with the next call to send() or flush() in one contiguous send.
+     */
+    void queue(const uint16_t type, const void *buff, const size_t numBytes);
+
+    /*!
+     * Send the queued frames now.
+     */
+    void flush(void);
+
+    /*!
+     * Get the number of bytes in queued frames.
+     */
+    size_t queuedBytes(void) const;
+
+    /*!
+     * Enable zero-copy transmission of large buffers.
+     * This option requires MSG_ZEROCOPY support (Linux 4.14 and up),
+     * otherwise the endpoint logs a warning and copies as usual.
+     */
+    void setZeroCopy(const bool enable);
+
 private:
     struct Impl; Impl *_impl;
 };
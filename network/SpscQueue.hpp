@@ -0,0 +1,129 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+#include <Pothos/Config.hpp>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <cstddef>
+
+/*!
+ * A bounded single producer, single consumer queue.
+ * Push and pop are lock-free; the mutex and condition variable
+ * are only touched when the other side is blocked in a wait call.
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+    SpscQueue(const size_t capacity = 1):
+        _slots(capacity+1),
+        _head(0),
+        _tail(0),
+        _waitingPop(false),
+        _waitingPush(false),
+        _interrupted(false)
+    {
+        return;
+    }
+
+    //! The maximum number of elements held by the queue
+    size_t capacity(void) const
+    {
+        return _slots.size()-1;
+    }
+
+    //! The number of elements currently held by the queue
+    size_t size(void) const
+    {
+        const size_t head = _head.load();
+        const size_t tail = _tail.load();
+        return (tail >= head)? (tail - head) : (tail + _slots.size() - head);
+    }
+
+    bool empty(void) const
+    {
+        return _head.load() == _tail.load();
+    }
+
+    //! Producer: push an element, false when the queue is full
+    bool push(T &&elem)
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        const size_t next = this->increment(tail);
+        if (next == _head.load(std::memory_order_acquire)) return false;
+        _slots[tail] = std::move(elem);
+        _tail.store(next);
+        if (_waitingPop.load()) this->notify();
+        return true;
+    }
+
+    //! Consumer: access the oldest element (queue must not be empty)
+    T &front(void)
+    {
+        return _slots[_head.load(std::memory_order_relaxed)];
+    }
+
+    //! Consumer: release the oldest element (queue must not be empty)
+    void pop(void)
+    {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        _slots[head] = T();
+        _head.store(this->increment(head));
+        if (_waitingPush.load()) this->notify();
+    }
+
+    //! Consumer: wait for an element to become available
+    bool waitPop(const std::chrono::high_resolution_clock::duration &timeout)
+    {
+        return this->wait(_waitingPop, timeout, [this]{return not this->empty();});
+    }
+
+    //! Producer: wait for space for the specified number of elements
+    bool waitPush(const std::chrono::high_resolution_clock::duration &timeout, const size_t num = 1)
+    {
+        return this->wait(_waitingPush, timeout, [this, num]{return this->capacity() - this->size() >= num;});
+    }
+
+    //! Return from all current and future waits, used when shutting down
+    void interrupt(void)
+    {
+        _interrupted.store(true);
+        this->notify();
+    }
+
+private:
+    void notify(void)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _cond.notify_all();
+    }
+
+    size_t increment(const size_t index) const
+    {
+        return (index+1 == _slots.size())? 0 : index+1;
+    }
+
+    template <typename Pred>
+    bool wait(std::atomic<bool> &waiting, const std::chrono::high_resolution_clock::duration &timeout, Pred pred)
+    {
+        if (pred()) return true;
+        std::unique_lock<std::mutex> lock(_mutex);
+        waiting.store(true);
+        _cond.wait_for(lock, timeout, [this, &pred]{return _interrupted.load() or pred();});
+        waiting.store(false);
+        return pred();
+    }
+
+    std::vector<T> _slots;
+    std::atomic<size_t> _head;
+    std::atomic<size_t> _tail;
+    std::atomic<bool> _waitingPop;
+    std::atomic<bool> _waitingPush;
+    std::atomic<bool> _interrupted;
+    std::mutex _mutex;
+    std::condition_variable _cond;
+};
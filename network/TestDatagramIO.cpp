@@ -0,0 +1,318 @@
+// Copyright (c) 2014-2017 Josh Blum
+// SPDX-License-Identifier: BSL-1.0
+
+#include "IoUring.hpp"
+#include <Pothos/Testing.hpp>
+#include <Pothos/Framework.hpp>
+#include <Pothos/Proxy.hpp>
+#include <Poco/Net/DatagramSocket.h>
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <algorithm> //min
+
+#ifdef __linux__
+#include <sys/socket.h>
+#include <netinet/in.h>
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#endif //__linux__
+
+/***********************************************************************
+ * Send raw datagrams with a 4 byte big endian sequence number
+ * followed by a payload of 4 bytes that repeat the low byte of the sequence
+ **********************************************************************/
+static void sendSequenced(Poco::Net::DatagramSocket &sock, const std::vector<uint32_t> &seqs)
+{
+    for (const auto seq : seqs)
+    {
+        const uint8_t low(seq & 0xff);
+        const uint8_t datagram[8] = {
+            uint8_t(seq >> 24), uint8_t(seq >> 16), uint8_t(seq >> 8), low,
+            low, low, low, low};
+        sock.sendBytes(datagram, sizeof(datagram));
+    }
+}
+
+POTHOS_TEST_BLOCK("/blocks/tests", test_datagram_sequence)
+{
+    auto receiver = Pothos::BlockRegistry::make("/blocks/datagram_io", "uint8");
+    receiver.call("setupSocket", "udp://127.0.0.1:0", "BIND");
+    receiver.call("setSequenceField", size_t(0), size_t(4));
+    receiver.call("setHeaderSize", size_t(4));
+    receiver.call("setGapMode", "ZEROS");
+    auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", "uint8");
+
+    Poco::Net::DatagramSocket sender;
+    sender.connect(Poco::Net::SocketAddress("127.0.0.1:" + receiver.call<std::string>("getActualPort")));
+
+    Pothos::Topology topology;
+    topology.connect(receiver, 0, collector, 0);
+    topology.commit();
+
+    //1003 is reordered, 1002 is duplicated, 1004 is missing,
+    //and the sender restarts from 0 after 1007
+    sendSequenced(sender, {1000, 1001, 1003, 1002, 1002, 1005, 1006, 1007, 0, 1, 2});
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    POTHOS_TEST_TRUE(topology.waitInactive());
+
+    std::vector<uint8_t> expected;
+    for (const uint32_t seq : {1000, 1001, 1002, 1003, 1004, 1005, 1006, 1007, 0, 1, 2})
+    {
+        //the missing datagram is filled with zeros of the last datagram size
+        const uint8_t low((seq == 1004)? 0 : (seq & 0xff));
+        expected.insert(expected.end(), 4, low);
+    }
+
+    const auto buff = collector.call<Pothos::BufferChunk>("getBuffer");
+    POTHOS_TEST_EQUAL(buff.length, expected.size());
+    POTHOS_TEST_EQUALA(buff.as<const uint8_t *>(), expected.data(), expected.size());
+    POTHOS_TEST_EQUAL(receiver.call<unsigned long long>("reordered"), 1);
+    POTHOS_TEST_EQUAL(receiver.call<unsigned long long>("duplicates"), 1);
+    POTHOS_TEST_EQUAL(receiver.call<unsigned long long>("dropped"), 1);
+    POTHOS_TEST_EQUAL(receiver.call<unsigned long long>("restarts"), 1);
+}
+
+POTHOS_TEST_BLOCK("/blocks/tests", test_datagram_timestamps)
+{
+    //only timestamps are enabled, so the receive uses the default batch size
+    auto receiver = Pothos::BlockRegistry::make("/blocks/datagram_io", "uint8");
+    receiver.call("setupSocket", "udp://127.0.0.1:0", "BIND");
+    receiver.call("setMode", "PACKET");
+    receiver.call("setTimestamps", true);
+    auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", "uint8");
+
+    Poco::Net::DatagramSocket sender;
+    sender.connect(Poco::Net::SocketAddress("127.0.0.1:" + receiver.call<std::string>("getActualPort")));
+
+    Pothos::Topology topology;
+    topology.connect(receiver, 0, collector, 0);
+    topology.commit();
+
+    const uint8_t datagram[4] = {1, 2, 3, 4};
+    sender.sendBytes(datagram, sizeof(datagram));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    POTHOS_TEST_TRUE(topology.waitInactive());
+
+    const auto packets = collector.call<std::vector<Pothos::Packet>>("getPackets");
+    POTHOS_TEST_EQUAL(packets.size(), 1);
+    const auto &pkt = packets.front();
+    POTHOS_TEST_EQUAL(pkt.payload.length, sizeof(datagram));
+    POTHOS_TEST_EQUALA(pkt.payload.as<const uint8_t *>(), datagram, sizeof(datagram));
+
+    //the timestamp is only missing when the platform does not support it
+    if (pkt.metadata.count("rxTime") == 0)
+    {
+        std::cout << "Skipping receive timestamp check: timestamps not available" << std::endl;
+        return;
+    }
+    POTHOS_TEST_TRUE(pkt.metadata.at("rxTime").convert<long long>() > 0);
+}
+
+POTHOS_TEST_BLOCK("/blocks/tests", test_datagram_rx_group)
+{
+    const size_t numSenders = 8;
+    const uint32_t numDatagrams = 100;
+
+    auto receiver = Pothos::BlockRegistry::make("/blocks/datagram_rx_group", "uint8", size_t(4), "MERGE");
+    receiver.call("setupSocket", "udp://127.0.0.1:0");
+    receiver.call("setMode", "PACKET");
+    receiver.call("setBatchSize", size_t(4));
+    auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", "uint8");
+
+    //each sender has its own source port, so the kernel spreads them across the sockets
+    std::vector<Poco::Net::DatagramSocket> senders(numSenders);
+    for (auto &sender : senders)
+    {
+        sender.connect(Poco::Net::SocketAddress("127.0.0.1:" + receiver.call<std::string>("getActualPort")));
+    }
+
+    Pothos::Topology topology;
+    topology.connect(receiver, 0, collector, 0);
+    topology.commit();
+
+    //the datagram is the sender index followed by the big endian sequence
+    for (uint32_t seq = 0; seq < numDatagrams; seq++)
+    {
+        for (size_t i = 0; i < numSenders; i++)
+        {
+            const uint8_t datagram[5] = {uint8_t(i),
+                uint8_t(seq >> 24), uint8_t(seq >> 16), uint8_t(seq >> 8), uint8_t(seq)};
+            senders[i].sendBytes(datagram, sizeof(datagram));
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    POTHOS_TEST_TRUE(topology.waitInactive());
+
+    //every datagram arrives once, and in order per sender
+    const auto packets = collector.call<std::vector<Pothos::Packet>>("getPackets");
+    POTHOS_TEST_EQUAL(packets.size(), numSenders*numDatagrams);
+    std::vector<uint32_t> nextSeq(numSenders, 0);
+    for (const auto &pkt : packets)
+    {
+        POTHOS_TEST_EQUAL(pkt.payload.length, 5);
+        const auto p = pkt.payload.as<const uint8_t *>();
+        POTHOS_TEST_TRUE(p[0] < numSenders);
+        const uint32_t seq = (uint32_t(p[1]) << 24) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 8) | p[4];
+        POTHOS_TEST_EQUAL(seq, nextSeq[p[0]]);
+        nextSeq[p[0]]++;
+    }
+    POTHOS_TEST_EQUAL(receiver.call<unsigned long long>("dropped"), 0);
+}
+
+POTHOS_TEST_BLOCK("/blocks/tests", test_datagram_batched)
+{
+    //both ends use the batched socket calls
+    auto receiver = Pothos::BlockRegistry::make("/blocks/datagram_io", "uint8");
+    receiver.call("setupSocket", "udp://127.0.0.1:0", "BIND");
+    receiver.call("setMode", "PACKET");
+    receiver.call("setBatchSize", size_t(8));
+    auto sender = Pothos::BlockRegistry::make("/blocks/datagram_io", "uint8");
+    sender.call("setupSocket", "udp://127.0.0.1:" + receiver.call<std::string>("getActualPort"), "CONNECT");
+    sender.call("setBatchSize", size_t(8));
+    auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", "uint8");
+    auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", "uint8");
+
+    //datagrams of different lengths, so that a merged or split datagram changes the lengths
+    std::vector<Pothos::BufferChunk> datagrams;
+    for (size_t i = 0; i < 50; i++)
+    {
+        Pothos::Packet pkt;
+        pkt.payload = Pothos::BufferChunk("uint8", 1 + (i*37)%200);
+        for (size_t j = 0; j < pkt.payload.length; j++) pkt.payload.as<uint8_t *>()[j] = uint8_t(i + j);
+        datagrams.push_back(pkt.payload);
+        feeder.call("feedPacket", pkt);
+    }
+
+    Pothos::Topology topology;
+    topology.connect(feeder, 0, sender, 0);
+    topology.connect(receiver, 0, collector, 0);
+    topology.commit();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    POTHOS_TEST_TRUE(topology.waitInactive());
+
+    //each datagram arrives as its own packet, in the order sent
+    const auto packets = collector.call<std::vector<Pothos::Packet>>("getPackets");
+    POTHOS_TEST_EQUAL(packets.size(), datagrams.size());
+    for (size_t i = 0; i < packets.size(); i++)
+    {
+        const auto &pkt = packets[i];
+        POTHOS_TEST_EQUAL(pkt.payload.length, datagrams[i].length);
+        POTHOS_TEST_EQUALA(pkt.payload.as<const uint8_t *>(), datagrams[i].as<const uint8_t *>(), datagrams[i].length);
+    }
+}
+
+/***********************************************************************
+ * Segmentation offload is only tested when the kernel supports it
+ **********************************************************************/
+static bool udpOffloadSupported(void)
+{
+    #ifdef __linux__
+    Poco::Net::DatagramSocket sock(Poco::Net::SocketAddress("127.0.0.1:0"));
+    const int fd = sock.impl()->sockfd();
+    const int segmentSize = 1000, groEnable = 1;
+    return ::setsockopt(fd, SOL_UDP, UDP_SEGMENT, &segmentSize, sizeof(segmentSize)) == 0 and
+        ::setsockopt(fd, SOL_UDP, UDP_GRO, &groEnable, sizeof(groEnable)) == 0;
+    #else
+    return false;
+    #endif
+}
+
+POTHOS_TEST_BLOCK("/blocks/tests", test_datagram_offload)
+{
+    if (not udpOffloadSupported())
+    {
+        std::cout << "Skipping segmentation offload test: UDP_SEGMENT/UDP_GRO not available" << std::endl;
+        return;
+    }
+
+    const size_t mtu = 1000;
+    auto receiver = Pothos::BlockRegistry::make("/blocks/datagram_io", "uint8");
+    receiver.call("setupSocket", "udp://127.0.0.1:0", "BIND");
+    receiver.call("setMode", "PACKET");
+    receiver.call("setMTU", mtu);
+    receiver.call("setOffload", false, true);
+    auto sender = Pothos::BlockRegistry::make("/blocks/datagram_io", "uint8");
+    sender.call("setupSocket", "udp://127.0.0.1:" + receiver.call<std::string>("getActualPort"), "CONNECT");
+    sender.call("setMTU", mtu);
+    sender.call("setOffload", true, false);
+    auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", "uint8");
+    auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", "uint8");
+
+    //the stream is sent as super-buffers, the last segment is shorter than the MTU
+    Pothos::BufferChunk stream("uint8", 20*mtu + 300);
+    for (size_t i = 0; i < stream.length; i++) stream.as<uint8_t *>()[i] = uint8_t(i*7 + i/mtu);
+    feeder.call("feedBuffer", stream);
+
+    Pothos::Topology topology;
+    topology.connect(feeder, 0, sender, 0);
+    topology.connect(receiver, 0, collector, 0);
+    topology.commit();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    POTHOS_TEST_TRUE(topology.waitInactive());
+
+    //the coalesced receives are split back into the MTU-sized datagrams
+    const auto packets = collector.call<std::vector<Pothos::Packet>>("getPackets");
+    POTHOS_TEST_EQUAL(packets.size(), 21);
+    size_t offset = 0;
+    for (const auto &pkt : packets)
+    {
+        const size_t expectedLength = std::min(mtu, stream.length-offset);
+        POTHOS_TEST_EQUAL(pkt.payload.length, expectedLength);
+        POTHOS_TEST_EQUALA(pkt.payload.as<const uint8_t *>(), stream.as<const uint8_t *>()+offset, expectedLength);
+        offset += pkt.payload.length;
+    }
+    POTHOS_TEST_EQUAL(offset, stream.length);
+}
+
+POTHOS_TEST_BLOCK("/blocks/tests", test_datagram_io_uring)
+{
+    if (not IoUring::available())
+    {
+        std::cout << "Skipping IO_URING engine test: io_uring not available" << std::endl;
+        return;
+    }
+
+    auto receiver = Pothos::BlockRegistry::make("/blocks/datagram_io", "uint8");
+    receiver.call("setupSocket", "udp://127.0.0.1:0", "BIND");
+    receiver.call("setMode", "PACKET");
+    receiver.call("setIoEngine", "IO_URING");
+    auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", "uint8");
+
+    Poco::Net::DatagramSocket sender;
+    sender.connect(Poco::Net::SocketAddress("127.0.0.1:" + receiver.call<std::string>("getActualPort")));
+
+    Pothos::Topology topology;
+    topology.connect(receiver, 0, collector, 0);
+    topology.commit();
+
+    //more datagrams than receive slots, so that the slots are re-armed
+    std::vector<std::vector<uint8_t>> datagrams;
+    for (size_t i = 0; i < 100; i++)
+    {
+        datagrams.emplace_back(1 + (i*53)%300);
+        for (size_t j = 0; j < datagrams.back().size(); j++) datagrams.back()[j] = uint8_t(i*3 + j);
+        sender.sendBytes(datagrams.back().data(), int(datagrams.back().size()));
+        if ((i % 16) == 15) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    POTHOS_TEST_TRUE(topology.waitInactive());
+
+    const auto packets = collector.call<std::vector<Pothos::Packet>>("getPackets");
+    POTHOS_TEST_EQUAL(packets.size(), datagrams.size());
+    for (size_t i = 0; i < packets.size(); i++)
+    {
+        const auto &pkt = packets[i];
+        POTHOS_TEST_EQUAL(pkt.payload.length, datagrams[i].size());
+        POTHOS_TEST_EQUALA(pkt.payload.as<const uint8_t *>(), datagrams[i].data(), datagrams[i].size());
+    }
+}
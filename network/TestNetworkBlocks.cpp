@@ -1,30 +1,40 @@
 // Copyright (c) 2014-2017 Josh Blum
 // SPDX-License-Identifier: BSL-1.0
 
+#include "NetworkCodec.hpp"
 #include <Pothos/Testing.hpp>
 #include <Pothos/Framework.hpp>
 #include <Pothos/Proxy.hpp>
 #include <Poco/Format.h>
 #include <Pothos/Util/Network.hpp>
+#include <Poco/Net/DatagramSocket.h>
 #include <iostream>
+#include <algorithm> //max
+#include <complex>
+#include <chrono>
+#include <thread>
+#include <vector>
 #include <json.hpp>
 
 using json = nlohmann::json;
 
-static void network_test_harness(const std::string &scheme, const bool serverIsSource)
+static void network_test_harness(const std::string &scheme, const bool serverIsSource, const size_t window = 256*1024, const bool asyncSend = false, const std::string &query = "", const size_t coalesceBytes = 0)
 {
-    std::cout << Poco::format("network_test_harness: %s:// (serverIsSource? %s)",
-        scheme, std::string(serverIsSource?"true":"false")) << std::endl;
+    std::cout << Poco::format("network_test_harness: %s://%s (serverIsSource? %s, window %z, asyncSend? %s)",
+        scheme, query, std::string(serverIsSource?"true":"false"), window, std::string(asyncSend?"true":"false")) << std::endl;
 
-    //create server
-    auto server_uri = Poco::format("%s://%s", scheme, Pothos::Util::getWildcardAddr());
+    //create server (unix sockets and shared memory use a unique name)
+    auto server_uri = Poco::format("%s://%s%s", scheme, Pothos::Util::getWildcardAddr(), query);
+    if (scheme == "unix" or scheme == "shm") server_uri = scheme + "://" + std::string((scheme == "unix")?"@":"") +
+        "pothos-network-test-" + std::to_string(std::chrono::high_resolution_clock::now().time_since_epoch().count());
     std::cout << "make server " << server_uri << std::endl;
     auto server = Pothos::BlockRegistry::make(
         (serverIsSource)?"/blocks/network_source":"/blocks/network_sink",
         server_uri, "BIND");
 
     //create client
-    std::string client_uri = Poco::format("%s://%s", scheme, Pothos::Util::getLoopbackAddr(server.call("getActualPort")));
+    std::string client_uri = Poco::format("%s://%s%s", scheme, Pothos::Util::getLoopbackAddr(server.call("getActualPort")), query);
+    if (scheme == "unix" or scheme == "shm") client_uri = server_uri;
     std::cout << "make client " << client_uri << std::endl;
     auto client = Pothos::BlockRegistry::make(
         (serverIsSource)?"/blocks/network_sink":"/blocks/network_source",
@@ -33,6 +43,10 @@ static void network_test_harness(const std::string &scheme, const bool serverIsS
     //who is the source/sink?
     auto source = (serverIsSource)? server : client;
     auto sink = (serverIsSource)? client : server;
+    source.call("setFlowControlWindow", window);
+    sink.call("setFlowControlWindow", window);
+    sink.call("setAsyncSend", asyncSend);
+    sink.call("setCoalesce", coalesceBytes, 0);
 
     //tester blocks
     auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", "int");
@@ -80,6 +94,9 @@ static void network_test_harness(const std::string &scheme, const bool serverIsS
     POTHOS_TEST_TRUE(topology.waitInactive());
     collector.call("verifyTestPlan", expected);
 
+    //the window was negotiated (and possibly grown) by the handshake
+    POTHOS_TEST_TRUE(sink.call<size_t>("flowControlWindow") >= std::max<size_t>(window, 1));
+
     std::cout << "Done!\n" << std::endl;
 }
 
@@ -87,4 +104,308 @@ POTHOS_TEST_BLOCK("/blocks/tests", test_network_blocks)
 {
     network_test_harness("tcp", true);
     network_test_harness("tcp", false);
+    network_test_harness("tcp", true, 0/*automatic*/);
+    network_test_harness("tcp", false, 256*1024, true/*asyncSend*/);
+    network_test_harness("tcp", true, 256*1024, false, "?streams=3");
+    network_test_harness("tcp", false, 256*1024, false, "?streams=3");
+    POTHOS_TEST_THROWS(Pothos::BlockRegistry::make("/blocks/network_source",
+        Poco::format("tcp://%s?streams=abc", Pothos::Util::getWildcardAddr()), "BIND"), Pothos::Exception);
+    network_test_harness("tcp", true, 256*1024, false, "", 4096/*coalesce*/);
+    network_test_harness("udp", true);
+    network_test_harness("udp", false);
+    #ifndef _MSC_VER
+    network_test_harness("unix", true);
+    network_test_harness("unix", false);
+    #endif
+    #ifdef __linux__
+    network_test_harness("shm", true);
+    network_test_harness("shm", false);
+    POTHOS_TEST_THROWS(Pothos::BlockRegistry::make("/blocks/network_source",
+        "shm://pothos_test_bad_size?size=abc", "BIND"), Pothos::Exception);
+    #endif
+}
+
+POTHOS_TEST_BLOCK("/blocks/tests", test_network_codec)
+{
+    PothosPacketEncoder encoder;
+
+    //labels with compact values round trip
+    const Pothos::Label label("lbl0", std::complex<float>(1.5f, -2.0f), 1234, 2);
+    POTHOS_TEST_TRUE(encoder.encode(label));
+    const auto outLabel = PothosPacketDecoder(encoder.data(), encoder.size()).label();
+    POTHOS_TEST_EQUAL(outLabel.id, label.id);
+    POTHOS_TEST_EQUAL(outLabel.index, label.index);
+    POTHOS_TEST_EQUAL(outLabel.width, label.width);
+    POTHOS_TEST_TRUE(outLabel.data.extract<std::complex<float>>() == std::complex<float>(1.5f, -2.0f));
+
+    //data types round trip
+    encoder.clear();
+    POTHOS_TEST_TRUE(encoder.encode(Pothos::DType("int16", 2)));
+    POTHOS_TEST_TRUE(PothosPacketDecoder(encoder.data(), encoder.size()).dtype() == Pothos::DType("int16", 2));
+
+    //packet headers round trip
+    Pothos::Packet packet;
+    packet.metadata["str"] = Pothos::Object(std::string("hello"));
+    packet.metadata["num"] = Pothos::Object(long(-42));
+    packet.labels.push_back(Pothos::Label("x", 3.0, 7));
+    encoder.clear();
+    POTHOS_TEST_TRUE(encoder.encode(packet));
+    const auto outPacket = PothosPacketDecoder(encoder.data(), encoder.size()).packet();
+    POTHOS_TEST_EQUAL(outPacket.metadata.at("str").extract<std::string>(), "hello");
+    POTHOS_TEST_EQUAL(outPacket.metadata.at("num").extract<long>(), -42);
+    POTHOS_TEST_EQUAL(outPacket.labels.size(), 1);
+    POTHOS_TEST_EQUAL(outPacket.labels[0].data.extract<double>(), 3.0);
+
+    //unsupported values fallback to serialization
+    encoder.clear();
+    POTHOS_TEST_TRUE(not encoder.encode(Pothos::Object(std::vector<int>(3, 1))));
+    encoder.clear();
+    encoder.serialize(Pothos::Object(std::vector<int>(3, 1)));
+    const auto outVec = PothosPacketDecoder(encoder.data(), encoder.size()).deserialize();
+    POTHOS_TEST_EQUAL(outVec.extract<std::vector<int>>().size(), 3);
+
+    //truncated frames throw
+    encoder.clear();
+    encoder.encode(label);
+    POTHOS_TEST_THROWS(PothosPacketDecoder(encoder.data(), encoder.size()-1).label(), Pothos::RangeException);
+}
+
+POTHOS_TEST_BLOCK("/blocks/tests", test_network_mux)
+{
+    const size_t numChannels = 3;
+
+    //the channels share one connection
+    auto server = Pothos::BlockRegistry::make("/blocks/network_mux_source",
+        Poco::format("tcp://%s", Pothos::Util::getWildcardAddr()), "BIND", numChannels);
+    auto client = Pothos::BlockRegistry::make("/blocks/network_mux_sink",
+        Poco::format("tcp://%s", Pothos::Util::getLoopbackAddr(server.call("getActualPort"))), "CONNECT", numChannels);
+    client.call("setChannelWindow", size_t(64*1024)); //smaller than the test data
+
+    json testPlan;
+    testPlan["enableLabels"] = true;
+    testPlan["enableMessages"] = true;
+    testPlan["enableBuffers"] = true;
+    testPlan["enablePackets"] = true;
+    testPlan["minTrials"] = 50;
+    testPlan["maxTrials"] = 100;
+    testPlan["minSize"] = 512;
+    testPlan["maxSize"] = 1048*8;
+
+    //each channel carries its own test plan to its own collector
+    Pothos::Topology topology;
+    std::vector<Pothos::Proxy> collectors;
+    std::vector<Pothos::Proxy> expected;
+    for (size_t i = 0; i < numChannels; i++)
+    {
+        auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", "int");
+        auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", "int");
+        topology.connect(feeder, 0, client, i);
+        topology.connect(server, i, collector, 0);
+        expected.push_back(feeder.call("feedTestPlan", testPlan.dump()));
+        collectors.push_back(collector);
+    }
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive());
+    for (size_t i = 0; i < numChannels; i++) collectors[i].call("verifyTestPlan", expected[i]);
+}
+
+POTHOS_TEST_BLOCK("/blocks/tests", test_network_publish)
+{
+    //the publisher listens for subscribers on its own port
+    auto publisher = Pothos::BlockRegistry::make("/blocks/network_sink",
+        Poco::format("tcp://%s", Pothos::Util::getWildcardAddr()), "PUBLISH");
+    POTHOS_TEST_TRUE(not publisher.call<std::string>("getActualPort").empty());
+    POTHOS_TEST_EQUAL(publisher.call<size_t>("subscriberCount"), 0);
+    POTHOS_TEST_EQUAL(publisher.call<unsigned long long>("dropCount"), 0);
+
+    //overflow policies
+    publisher.call("setSubscriberPolicy", "DROP_OLDEST");
+    publisher.call("setSubscriberPolicy", "DISCONNECT");
+    POTHOS_TEST_THROWS(publisher.call("setSubscriberPolicy", "FOO"), Pothos::ProxyExceptionMessage);
+
+    //publishing is only supported over tcp
+    POTHOS_TEST_THROWS(Pothos::BlockRegistry::make("/blocks/network_sink",
+        Poco::format("udp://%s", Pothos::Util::getWildcardAddr()), "PUBLISH"), Pothos::Exception);
+}
+
+/***********************************************************************
+ * Publisher tests with subscribers that join late and fall behind
+ **********************************************************************/
+static Pothos::Proxy makeSubscriber(const Pothos::Proxy &publisher)
+{
+    return Pothos::BlockRegistry::make("/blocks/network_source",
+        Poco::format("tcp://%s", Pothos::Util::getLoopbackAddr(publisher.call("getActualPort"))), "CONNECT");
+}
+
+//subscribers are accepted by a background thread
+static void waitSubscribers(const Pothos::Proxy &publisher, const size_t num)
+{
+    for (size_t i = 0; i < 100 and publisher.call<size_t>("subscriberCount") != num; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    POTHOS_TEST_EQUAL(publisher.call<size_t>("subscriberCount"), num);
+}
+
+static Pothos::BufferChunk makeRamp(const size_t offset, const size_t num)
+{
+    Pothos::BufferChunk buffer("int", num);
+    for (size_t i = 0; i < num; i++) buffer.as<int *>()[i] = int(offset + i);
+    return buffer;
+}
+
+static void checkRamp(const Pothos::BufferChunk &buffer, const size_t offset, const size_t num)
+{
+    POTHOS_TEST_TRUE(buffer.dtype == Pothos::DType("int"));
+    POTHOS_TEST_EQUAL(buffer.elements(), num);
+    const auto expected = makeRamp(offset, num);
+    POTHOS_TEST_EQUALA(buffer.as<const int *>(), expected.as<const int *>(), num);
+}
+
+POTHOS_TEST_BLOCK("/blocks/tests", test_network_publish_subscribers)
+{
+    auto publisher = Pothos::BlockRegistry::make("/blocks/network_sink",
+        Poco::format("tcp://%s", Pothos::Util::getWildcardAddr()), "PUBLISH");
+    auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", "int");
+    auto sub0 = makeSubscriber(publisher);
+    auto sub1 = makeSubscriber(publisher);
+    auto collector0 = Pothos::BlockRegistry::make("/blocks/collector_sink", "int");
+    auto collector1 = Pothos::BlockRegistry::make("/blocks/collector_sink", "int");
+
+    //both subscribers receive every frame
+    Pothos::Topology topology;
+    topology.connect(feeder, 0, publisher, 0);
+    topology.connect(sub0, 0, collector0, 0);
+    topology.connect(sub1, 0, collector1, 0);
+    topology.commit();
+    waitSubscribers(publisher, 2);
+    feeder.call("feedBuffer", makeRamp(0, 1000));
+    POTHOS_TEST_TRUE(topology.waitInactive());
+    checkRamp(collector0.call("getBuffer"), 0, 1000);
+    checkRamp(collector1.call("getBuffer"), 0, 1000);
+
+    //the late subscriber starts with the current data type,
+    //which the publisher does not send again with the next buffer
+    auto sub2 = makeSubscriber(publisher);
+    auto collector2 = Pothos::BlockRegistry::make("/blocks/collector_sink", "int");
+    topology.connect(sub2, 0, collector2, 0);
+    topology.commit();
+    waitSubscribers(publisher, 3);
+    feeder.call("feedBuffer", makeRamp(1000, 1000));
+    POTHOS_TEST_TRUE(topology.waitInactive());
+    checkRamp(collector0.call("getBuffer"), 0, 2000);
+    checkRamp(collector1.call("getBuffer"), 0, 2000);
+    checkRamp(collector2.call("getBuffer"), 1000, 1000);
+    POTHOS_TEST_EQUAL(publisher.call<unsigned long long>("dropCount"), 0);
+}
+
+/***********************************************************************
+ * The slow subscriber stops reading once its finite release is reached,
+ * and its small window stalls the publisher's sender for that subscriber.
+ **********************************************************************/
+static void network_publish_slow_harness(const std::string &policy)
+{
+    std::cout << "network_publish_slow_harness: " << policy << std::endl;
+    static const size_t numBuffers = 256;
+    static const size_t bufferSize = 4096;
+
+    auto publisher = Pothos::BlockRegistry::make("/blocks/network_sink",
+        Poco::format("tcp://%s", Pothos::Util::getWildcardAddr()), "PUBLISH");
+    publisher.call("setSubscriberPolicy", policy);
+    publisher.call("setQueueDepth", size_t(16));
+    auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", "int");
+    auto fastSub = makeSubscriber(publisher);
+    auto slowSub = makeSubscriber(publisher);
+    slowSub.call("setFlowControlWindow", size_t(64*1024));
+    auto release = Pothos::BlockRegistry::make("/blocks/finite_release");
+    release.call("setTotalElements", size_t(0));
+    auto fastCollector = Pothos::BlockRegistry::make("/blocks/collector_sink", "int");
+    auto slowCollector = Pothos::BlockRegistry::make("/blocks/collector_sink", "int");
+
+    Pothos::Topology topology;
+    topology.connect(feeder, 0, publisher, 0);
+    topology.connect(fastSub, 0, fastCollector, 0);
+    topology.connect(slowSub, 0, release, 0);
+    topology.connect(release, 0, slowCollector, 0);
+    topology.commit();
+    waitSubscribers(publisher, 2);
+    for (size_t i = 0; i < numBuffers; i++) feeder.call("feedBuffer", makeRamp(i*bufferSize, bufferSize));
+    POTHOS_TEST_TRUE(topology.waitInactive(0.1, 30.0));
+
+    if (policy == "BLOCK")
+    {
+        //nothing is lost once the slow subscriber catches up
+        POTHOS_TEST_TRUE(fastCollector.call<Pothos::BufferChunk>("getBuffer").elements() < numBuffers*bufferSize);
+        release.call("setTotalElements", size_t(~size_t(0)));
+        POTHOS_TEST_TRUE(topology.waitInactive(0.1, 30.0));
+        checkRamp(fastCollector.call("getBuffer"), 0, numBuffers*bufferSize);
+        checkRamp(slowCollector.call("getBuffer"), 0, numBuffers*bufferSize);
+        POTHOS_TEST_EQUAL(publisher.call<unsigned long long>("dropCount"), 0);
+    }
+
+    //the publisher did not wait for the slow subscriber
+    if (policy == "DROP_OLDEST")
+    {
+        POTHOS_TEST_TRUE(publisher.call<unsigned long long>("dropCount") > 0);
+        POTHOS_TEST_TRUE(fastCollector.call<Pothos::BufferChunk>("getBuffer").elements() != 0);
+    }
+
+    //the slow subscriber is removed on the next work call
+    if (policy == "DISCONNECT")
+    {
+        feeder.call("feedBuffer", makeRamp(numBuffers*bufferSize, bufferSize));
+        POTHOS_TEST_TRUE(topology.waitInactive(0.1, 30.0));
+        POTHOS_TEST_TRUE(publisher.call<size_t>("subscriberCount") < 2);
+        POTHOS_TEST_TRUE(fastCollector.call<Pothos::BufferChunk>("getBuffer").elements() != 0);
+    }
+}
+
+POTHOS_TEST_BLOCK("/blocks/tests", test_network_publish_slow)
+{
+    network_publish_slow_harness("BLOCK");
+    network_publish_slow_harness("DROP_OLDEST");
+    network_publish_slow_harness("DISCONNECT");
+}
+
+#ifdef __linux__
+POTHOS_TEST_BLOCK("/blocks/tests", test_packet_capture)
+{
+    //a bound socket receives the datagrams, so that the sender does not see port unreachable
+    Poco::Net::DatagramSocket receiver(Poco::Net::SocketAddress("127.0.0.1", 0));
+    const auto port = receiver.address().port();
+
+    //the capture requires CAP_NET_RAW
+    auto capture = Pothos::BlockRegistry::make("/blocks/packet_capture", "int");
+    try
+    {
+        capture.call("setupCapture", "lo", port, size_t(256*1024), size_t(64));
+    }
+    catch (const Pothos::Exception &ex)
+    {
+        std::cout << "Skipping packet capture test: " << ex.message() << std::endl;
+        return;
+    }
+
+    auto sender = Pothos::BlockRegistry::make("/blocks/datagram_io", "int");
+    sender.call("setupSocket", "udp://127.0.0.1:" + std::to_string(port), "CONNECT");
+    auto feeder = Pothos::BlockRegistry::make("/blocks/feeder_source", "int");
+    auto collector = Pothos::BlockRegistry::make("/blocks/collector_sink", "int");
+
+    //streams over loopback are captured in order
+    json testPlan;
+    testPlan["enableBuffers"] = true;
+    testPlan["minTrials"] = 10;
+    testPlan["maxTrials"] = 20;
+    testPlan["minSize"] = 512;
+    testPlan["maxSize"] = 1024;
+    auto expected = feeder.call("feedTestPlan", testPlan.dump());
+
+    Pothos::Topology topology;
+    topology.connect(feeder, 0, sender, 0);
+    topology.connect(capture, 0, collector, 0);
+    topology.commit();
+    POTHOS_TEST_TRUE(topology.waitInactive());
+    collector.call("verifyTestPlan", expected);
+    POTHOS_TEST_EQUAL(capture.call<unsigned long long>("dropped"), 0);
 }
+#endif //__linux__
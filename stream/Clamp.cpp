@@ -5,10 +5,13 @@
 #include <Pothos/Exception.hpp>
 #include <Pothos/Framework.hpp>
 
+#include "StreamKernels.hpp"
+
 #include <Poco/Format.h>
 #include <Poco/NumberFormatter.h>
 
 #include <algorithm>
+#include <cstring>
 #include <limits>
 
 /***********************************************************************
@@ -17,6 +20,11 @@
  * Constrains input values between user-given minimum and maximum values
  * and outputs the result.
  *
+ * The block can also count how many input values were clipped at each
+ * bound. The running totals are available through the "clippedLow" and
+ * "clippedHigh" probes, and can be posted downstream as a periodic
+ * "clips" label, whose data is a dictionary with the "low" and "high" totals.
+ *
  * |category /Stream
  * |keywords min max
  *
@@ -45,11 +53,26 @@
  * |default true
  * |preview enable
  *
+ * |param countClips[Count Clips?] Whether or not to count the clipped values.
+ * |widget ToggleSwitch(on="True",off="False")
+ * |default false
+ * |preview disable
+ * |tab Clipping
+ *
+ * |param clipLabelInterval[Clip Label Interval] How many elements between "clips" labels.
+ * A value of 0 disables the labels. Labels imply counting.
+ * |widget SpinBox(minimum=0)
+ * |default 0
+ * |preview disable
+ * |tab Clipping
+ *
  * |factory /blocks/clamp(dtype)
  * |setter setMin(min)
  * |setter setMax(max)
  * |setter setClampMin(clampMin)
  * |setter setClampMax(clampMax)
+ * |setter setCountClips(countClips)
+ * |setter setClipLabelInterval(clipLabelInterval)
  **********************************************************************/
 
 template <typename T>
@@ -63,7 +86,13 @@ public:
         _min(0),
         _max(0),
         _clampMin(true),
-        _clampMax(true)
+        _clampMax(true),
+        _countClips(false),
+        _clipLabelInterval(0),
+        _elemsSinceLabel(0),
+        _clippedLow(0),
+        _clippedHigh(0),
+        _kernels(getStreamKernels<T>())
     {
         const Pothos::DType dtype(typeid(T), dimension);
 
@@ -91,6 +120,22 @@ public:
         this->registerSignal("clampMaxChanged");
 
         this->registerCall(this, POTHOS_FCN_TUPLE(Class, setMinAndMax));
+
+        this->registerCall(this, POTHOS_FCN_TUPLE(Class, countClips));
+        this->registerCall(this, POTHOS_FCN_TUPLE(Class, setCountClips));
+        this->registerProbe("countClips");
+        this->registerSignal("countClipsChanged");
+
+        this->registerCall(this, POTHOS_FCN_TUPLE(Class, clipLabelInterval));
+        this->registerCall(this, POTHOS_FCN_TUPLE(Class, setClipLabelInterval));
+        this->registerProbe("clipLabelInterval");
+        this->registerSignal("clipLabelIntervalChanged");
+
+        this->registerCall(this, POTHOS_FCN_TUPLE(Class, clippedLow));
+        this->registerProbe("clippedLow");
+        this->registerCall(this, POTHOS_FCN_TUPLE(Class, clippedHigh));
+        this->registerProbe("clippedHigh");
+        this->registerCall(this, POTHOS_FCN_TUPLE(Class, resetClipCounts));
     }
 
     T min() const
@@ -153,6 +198,45 @@ public:
         this->emitSignal("clampMaxChanged", _clampMax);
     }
 
+    bool countClips() const
+    {
+        return _countClips;
+    }
+
+    void setCountClips(bool newCountClips)
+    {
+        _countClips = newCountClips;
+        this->emitSignal("countClipsChanged", _countClips);
+    }
+
+    size_t clipLabelInterval() const
+    {
+        return _clipLabelInterval;
+    }
+
+    void setClipLabelInterval(size_t newClipLabelInterval)
+    {
+        _clipLabelInterval = newClipLabelInterval;
+        _elemsSinceLabel = 0;
+        this->emitSignal("clipLabelIntervalChanged", _clipLabelInterval);
+    }
+
+    unsigned long long clippedLow() const
+    {
+        return _clippedLow;
+    }
+
+    unsigned long long clippedHigh() const
+    {
+        return _clippedHigh;
+    }
+
+    void resetClipCounts()
+    {
+        _clippedLow = 0;
+        _clippedHigh = 0;
+    }
+
     void work() override
     {
         auto elems = this->workInfo().minElements;
@@ -166,17 +250,27 @@ public:
 
         const T* buffIn = input->buffer();
         T* buffOut = output->buffer();
-        for(size_t elem = 0; elem < elems; ++elem)
+        const size_t dimension = input->dtype().dimension();
+
+        if(_countClips || (_clipLabelInterval > 0))
+        {
+            this->clampAndCount(buffIn, buffOut, elems, dimension);
+        }
+        else if(_clampMin && _clampMax)
         {
-            const T lo = _clampMin ? _min : std::numeric_limits<T>::min();
-            const T hi = _clampMax ? _max : std::numeric_limits<T>::max();
-
-#if __cplusplus >= 201703L
-            buffOut[elem] = std::clamp(buffIn[elem], lo, hi);
-#else
-            // See: https://en.cppreference.com/w/cpp/algorithm/clamp
-            buffOut[elem] = (buffIn[elem] < lo) ? lo : (hi < buffIn[elem]) ? hi : buffIn[elem];
-#endif
+            _kernels.clamp(buffIn, buffOut, elems * dimension, _min, _max);
+        }
+        else if(_clampMin)
+        {
+            _kernels.clampLow(buffIn, buffOut, elems * dimension, _min);
+        }
+        else if(_clampMax)
+        {
+            _kernels.clampHigh(buffIn, buffOut, elems * dimension, _max);
+        }
+        else
+        {
+            std::memcpy(buffOut, buffIn, elems * dimension * sizeof(T));
         }
 
         input->consume(elems);
@@ -190,6 +284,59 @@ private:
     bool _clampMin;
     bool _clampMax;
 
+    bool _countClips;
+    size_t _clipLabelInterval;
+    size_t _elemsSinceLabel;
+    unsigned long long _clippedLow;
+    unsigned long long _clippedHigh;
+
+    const StreamKernels<T>& _kernels;
+
+    // Split the buffer at each label position so the label carries the
+    // totals up to and including its element.
+    void clampAndCount(const T* buffIn, T* buffOut, size_t elems, size_t dimension)
+    {
+        // An unenforced bound is the extreme of the type, which never clips.
+        const T lo = _clampMin ? _min : std::numeric_limits<T>::lowest();
+        const T hi = _clampMax ? _max : std::numeric_limits<T>::max();
+
+        size_t elemOffset = 0;
+        while(elemOffset < elems)
+        {
+            size_t chunkElems = elems - elemOffset;
+            if(_clipLabelInterval > 0)
+            {
+                chunkElems = std::min(chunkElems, _clipLabelInterval - _elemsSinceLabel);
+            }
+
+            size_t numLow = 0;
+            size_t numHigh = 0;
+            _kernels.clampCount(
+                buffIn + (elemOffset * dimension),
+                buffOut + (elemOffset * dimension),
+                chunkElems * dimension,
+                lo,
+                hi,
+                &numLow,
+                &numHigh);
+            _clippedLow += numLow;
+            _clippedHigh += numHigh;
+
+            elemOffset += chunkElems;
+            _elemsSinceLabel += chunkElems;
+
+            if((_clipLabelInterval > 0) && (_elemsSinceLabel == _clipLabelInterval))
+            {
+                Pothos::ObjectKwargs clips;
+                clips["low"] = Pothos::Object(_clippedLow);
+                clips["high"] = Pothos::Object(_clippedHigh);
+                this->output(0)->postLabel(Pothos::Label("clips", clips, elemOffset - 1));
+
+                _elemsSinceLabel = 0;
+            }
+        }
+    }
+
     static void validateMinMax(const T& minVal, const T& maxVal)
     {
         if(minVal > maxVal)
@@ -4,9 +4,9 @@
 #include <Pothos/Exception.hpp>
 #include <Pothos/Framework.hpp>
 
+#include "StreamKernels.hpp"
+
 #include <algorithm>
-#include <cstring>
-#include <iostream>
 #include <vector>
 
 /***********************************************************************
@@ -48,7 +48,8 @@ public:
         const Pothos::DType& outputDType,
         size_t numOutputs
     ): _outputDType(outputDType),
-       _numOutputs(numOutputs)
+       _numOutputs(numOutputs),
+       _kernels(getStreamCopyKernels())
     {
         // Don't specify a specific DType for the input.
         this->setupInput(0);
@@ -111,31 +112,23 @@ public:
             return;
         }
 
-        std::vector<std::uint8_t*> buffsOut;
+        std::vector<void*> buffsOut;
         std::transform(
             outputs.begin(),
             outputs.end(),
             std::back_inserter(buffsOut),
             [](const Pothos::OutputPort* port)
             {
-                return port->buffer().as<std::uint8_t*>();
+                return port->buffer().as<void*>();
             });
 
-        for(size_t chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
-        {
-            for(size_t outputIndex = 0; outputIndex < _numOutputs; ++outputIndex)
-            {
-                std::memcpy(
-                    buffsOut[outputIndex],
-                    buffIn,
-                    _chunkSizeBytes);
-
-                buffIn += _chunkSizeBytes;
-                buffsOut[outputIndex] += _chunkSizeBytes;
-
-                outputs[outputIndex]->produce(_chunkSize);
-            }
-        }
+        _kernels.deinterleave(
+            buffIn,
+            buffsOut.data(),
+            _numOutputs,
+            numChunks,
+            _chunkSizeBytes);
+        for(auto* output: outputs) output->produce(numChunks * _chunkSize);
 
         // As the input port is of an unspecified type, consume the number
         // of bytes.
@@ -147,6 +140,8 @@ private:
     size_t _numOutputs;
     size_t _chunkSize;
     size_t _chunkSizeBytes;
+
+    const StreamCopyKernels& _kernels;
 };
 
 static Pothos::BlockRegistry registerDeinterleaver(
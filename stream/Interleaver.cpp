@@ -4,8 +4,10 @@
 #include <Pothos/Exception.hpp>
 #include <Pothos/Framework.hpp>
 
+#include "StreamKernels.hpp"
+
 #include <algorithm>
-#include <cstring>
+#include <cstdint>
 #include <vector>
 
 /***********************************************************************
@@ -47,7 +49,9 @@ public:
         const Pothos::DType& outputDType,
         size_t numInputs
     ): _outputDType(outputDType),
-       _numInputs(numInputs)
+       _numInputs(numInputs),
+       _kernels(getStreamCopyKernels()),
+       _buffsIn(numInputs)
     {
         for(size_t chan = 0; chan < _numInputs; ++chan)
         {
@@ -76,79 +80,95 @@ public:
 
         _chunkSize = chunkSize;
         _chunkSizeBytes = _chunkSize * _outputDType.size();
-    }
 
-    void work() override
-    {
-        const auto elems = this->workInfo().minElements;
-        if(0 == elems)
+        // Size the conversion tiles to roughly 16 KiB per input.
+        _tileChunks = std::max<size_t>(1, 16384 / _chunkSizeBytes);
+        _convertBuffs.clear();
+        for(size_t chan = 0; chan < _numInputs; ++chan)
         {
-            return;
+            _convertBuffs.emplace_back(_outputDType, _tileChunks * _chunkSize);
         }
+    }
 
+    void work() override
+    {
         auto inputs = this->inputs();
         auto output = this->output(0);
 
-        std::vector<Pothos::BufferChunk> convertedInputs;
-        std::transform(
-            inputs.begin(),
-            inputs.end(),
-            std::back_inserter(convertedInputs),
-            [this](Pothos::InputPort* inputPort)
-            {
-                return inputPort->buffer().convert(_outputDType);
-            });
-
-        auto minElemIter = std::min_element(
-                               convertedInputs.begin(),
-                               convertedInputs.end(),
-                               [](const Pothos::BufferChunk& chunk1, const Pothos::BufferChunk& chunk2)
-                               {
-                                   return (chunk1.elements() < chunk2.elements());
-                               });
-        const auto elemsIn = minElemIter->elements();
-        const auto elemsOut = output->elements();
-
-        const auto numChunks = std::min<size_t>(
-                                   (elemsIn / _chunkSize),
-                                   (elemsOut / _chunkSize / _numInputs));
+        // As the input ports are of an unspecified type, each buffer
+        // carries the upstream type.
+        size_t numChunks = output->elements() / _chunkSize / _numInputs;
+        bool convert = false;
+        for(auto* input: inputs)
+        {
+            const auto& buffer = input->buffer();
+            numChunks = std::min<size_t>(numChunks, buffer.elements() / _chunkSize);
+            convert = convert || !(buffer.dtype == _outputDType);
+        }
         if(0 == numChunks)
         {
             return;
         }
 
-        for(auto& convertedInput: convertedInputs) convertedInput.setElements(elemsIn);
+        auto* buffOut = output->buffer().as<std::uint8_t*>();
 
-        std::vector<const std::uint8_t*> buffsIn;
-        std::transform(
-            convertedInputs.begin(),
-            convertedInputs.end(),
-            std::back_inserter(buffsIn),
-            [](const Pothos::BufferChunk& bufferChunk)
+        if(!convert)
+        {
+            for(size_t chan = 0; chan < _numInputs; ++chan)
             {
-                return bufferChunk.as<const std::uint8_t*>();
-            });
-        uint8_t* buffOut = output->buffer();
+                _buffsIn[chan] = inputs[chan]->buffer().as<const void*>();
+            }
 
-        for(size_t chunkIndex = 0; chunkIndex < numChunks; ++chunkIndex)
+            _kernels.interleave(
+                _buffsIn.data(),
+                _numInputs,
+                buffOut,
+                numChunks,
+                _chunkSizeBytes);
+        }
+        else
         {
-            for(size_t inputIndex = 0; inputIndex < _numInputs; ++inputIndex)
+            // Convert only the elements that will be produced, one tile
+            // at a time, so the converted chunks are still in cache when
+            // they are interleaved.
+            for(size_t tileStart = 0; tileStart < numChunks; tileStart += _tileChunks)
             {
-                std::memcpy(
-                    buffOut,
-                    buffsIn[inputIndex],
+                const auto tileChunks = std::min<size_t>(_tileChunks, numChunks - tileStart);
+                const auto tileElems = tileChunks * _chunkSize;
+
+                for(size_t chan = 0; chan < _numInputs; ++chan)
+                {
+                    auto buffer = inputs[chan]->buffer();
+                    const auto elemSize = buffer.dtype.size();
+                    if(buffer.dtype == _outputDType)
+                    {
+                        _buffsIn[chan] = buffer.as<const std::uint8_t*>() + (tileStart * _chunkSize * elemSize);
+                    }
+                    else
+                    {
+                        buffer.address += tileStart * _chunkSize * elemSize;
+                        buffer.length = tileElems * elemSize;
+                        buffer.convert(_convertBuffs[chan], tileElems);
+                        _buffsIn[chan] = _convertBuffs[chan].as<const void*>();
+                    }
+                }
+
+                _kernels.interleave(
+                    _buffsIn.data(),
+                    _numInputs,
+                    buffOut + (tileStart * _numInputs * _chunkSizeBytes),
+                    tileChunks,
                     _chunkSizeBytes);
-
-                buffsIn[inputIndex] += _chunkSizeBytes;
-                buffOut += _chunkSizeBytes;
-
-                output->produce(_chunkSize);
             }
         }
 
-        // As the input port is of an unspecified type, consume the number
-        // of bytes.
-        for(auto* input: inputs) input->consume(elemsIn * input->buffer().dtype.elemSize());
+        output->produce(numChunks * _chunkSize * _numInputs);
+
+        // Consume only what was interleaved, in bytes.
+        for(auto* input: inputs)
+        {
+            input->consume(numChunks * _chunkSize * input->buffer().dtype.size());
+        }
     }
 
 private:
@@ -156,6 +176,12 @@ private:
     size_t _numInputs;
     size_t _chunkSize;
     size_t _chunkSizeBytes;
+    size_t _tileChunks;
+
+    const StreamCopyKernels& _kernels;
+
+    std::vector<const void*> _buffsIn;
+    std::vector<Pothos::BufferChunk> _convertBuffs;
 };
 
 static Pothos::BlockRegistry registerInterleaver(
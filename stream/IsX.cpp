@@ -4,28 +4,23 @@
 #include <Pothos/Exception.hpp>
 #include <Pothos/Framework.hpp>
 
-#include <cmath>
+#include "StreamKernels.hpp"
+
+#include <algorithm>
 #include <cstdint>
+#include <string>
 
 //
-// Wrappers that return the stream's output type
+// Each block runs one predicate's classification kernels over the whole
+// buffer, in one of three output modes:
+//  * FLAGS:  one int8 per element
+//  * PACKED: one bit per element, eight to an output byte
+//  * COUNT:  a message with the number of matches in each buffer
+//
+// The output port keeps its int8 type in every mode, so the mode can be
+// changed without reconfiguring the port. In PACKED mode, labels move to
+// the packed elements that hold their input elements; COUNT drops them.
 //
-
-template <typename T>
-using IsXFcn = std::int8_t(*)(T);
-
-#define ISX_WRAPPER(funcName, stdFuncName) \
-    template <typename T> \
-    static std::int8_t funcName(T input) \
-    { \
-        return std::stdFuncName(input) ? 1 : 0; \
-    }
-
-ISX_WRAPPER(IsFinite,   isfinite)
-ISX_WRAPPER(IsInf,      isinf)
-ISX_WRAPPER(IsNaN,      isnan)
-ISX_WRAPPER(IsNormal,   isnormal)
-ISX_WRAPPER(IsNegative, signbit)
 
 //
 // Block implementation
@@ -36,16 +31,75 @@ class IsX: public Pothos::Block
 {
 public:
     using Class = IsX<T>;
-    using Func = IsXFcn<T>;
+    using Kernels = StreamClassifyKernels<T>;
 
-    IsX(Func func, size_t dimension):
-        _func(func)
+    IsX(const Kernels& kernels, size_t dimension):
+        _kernels(kernels),
+        _mode("FLAGS"),
+        _packed(false),
+        _countOnly(false)
     {
         this->setupInput(0, Pothos::DType(typeid(T), dimension));
         this->setupOutput(0, Pothos::DType("int8", dimension));
+
+        this->registerCall(this, POTHOS_FCN_TUPLE(Class, mode));
+        this->registerCall(this, POTHOS_FCN_TUPLE(Class, setMode));
+        this->registerProbe("mode");
+    }
+
+    std::string mode() const
+    {
+        return _mode;
+    }
+
+    void setMode(const std::string& mode)
+    {
+        if((mode != "FLAGS") && (mode != "PACKED") && (mode != "COUNT"))
+        {
+            throw Pothos::InvalidArgumentException("Invalid mode", mode);
+        }
+
+        _mode = mode;
+        _packed = (mode == "PACKED");
+        _countOnly = (mode == "COUNT");
+
+        // Each group of 8 input elements packs into one output element
+        // of the same dimension.
+        this->input(0)->setReserve(_packed ? 8 : 0);
     }
 
     void work() override
+    {
+        if(_packed) this->workPacked();
+        else if(_countOnly) this->workCount();
+        else this->workFlags();
+    }
+
+    void propagateLabels(const Pothos::InputPort* port) override
+    {
+        // The count message has no stream position for labels.
+        if(_countOnly) return;
+        if(!_packed) return Pothos::Block::propagateLabels(port);
+
+        // Labels move to the packed element that holds their first
+        // input element, and cover every packed element they overlap.
+        auto* output = this->output(0);
+        for(const auto& label: port->labels())
+        {
+            auto packedLabel = label;
+            packedLabel.index = label.index / 8;
+            packedLabel.width = (label.index + std::max<size_t>(label.width, 1) + 7) / 8 - packedLabel.index;
+            output->postLabel(packedLabel);
+        }
+    }
+
+private:
+    const Kernels& _kernels;
+    std::string _mode;
+    bool _packed;
+    bool _countOnly;
+
+    void workFlags()
     {
         const auto elems = this->workInfo().minElements;
         if(0 == elems)
@@ -56,20 +110,55 @@ public:
         auto* input = this->input(0);
         auto* output = this->output(0);
 
-        const T* inBuff = input->buffer();
-        std::int8_t* outBuff = output->buffer();
+        _kernels.flags(
+            input->buffer(),
+            output->buffer(),
+            elems * input->dtype().dimension());
+
+        input->consume(elems);
+        output->produce(elems);
+    }
 
-        for(size_t elem = 0; elem < elems; ++elem)
+    // Only whole groups of 8 elements are packed, so a trailing partial
+    // group waits for more input.
+    void workPacked()
+    {
+        auto* input = this->input(0);
+        auto* output = this->output(0);
+
+        const auto outElems = std::min(input->elements() / 8, output->elements());
+        if(0 == outElems)
         {
-            outBuff[elem] = _func(inBuff[elem]);
+            return;
         }
 
+        const auto elems = outElems * 8;
+        _kernels.packed(
+            input->buffer(),
+            output->buffer(),
+            elems * input->dtype().dimension());
+
         input->consume(elems);
-        output->produce(elems);
+        output->produce(outElems);
     }
 
-private:
-    Func _func;
+    void workCount()
+    {
+        auto* input = this->input(0);
+
+        const auto elems = input->elements();
+        if(0 == elems)
+        {
+            return;
+        }
+
+        const size_t count = _kernels.count(
+                                 input->buffer(),
+                                 elems * input->dtype().dimension());
+
+        input->consume(elems);
+        this->output(0)->postMessage(count);
+    }
 };
 
 //
@@ -80,9 +169,9 @@ private:
     static Pothos::Block* make ## func (const Pothos::DType& dtype) \
     { \
         if(Pothos::DType::fromDType(dtype, 1) == Pothos::DType(typeid(float))) \
-            return new IsX<float>(&func<float>, dtype.dimension()); \
+            return new IsX<float>(getStreamFloatKernels<float>().func, dtype.dimension()); \
         if(Pothos::DType::fromDType(dtype, 1) == Pothos::DType(typeid(double))) \
-            return new IsX<double>(&func<double>, dtype.dimension()); \
+            return new IsX<double>(getStreamFloatKernels<double>().func, dtype.dimension()); \
  \
         throw Pothos::InvalidArgumentException( \
                   std::string(__FUNCTION__)+": invalid type", \
@@ -107,9 +196,24 @@ private:
  * |default "float64"
  * |preview disable
  *
+ * |param mode[Mode] The output format.
+ * <ul>
+ * <li><b>Flags:</b> one int8 per element</li>
+ * <li><b>Packed:</b> one bit per element, least significant bit first,
+ * packed eight elements to each output element</li>
+ * <li><b>Count:</b> a message with the number of matching elements
+ * in each input buffer, with no stream output and no labels</li>
+ * </ul>
+ * |option [Flags] "FLAGS"
+ * |option [Packed] "PACKED"
+ * |option [Count] "COUNT"
+ * |default "FLAGS"
+ * |preview enable
+ *
  * |factory /blocks/isfinite(dtype)
+ * |setter setMode(mode)
  **********************************************************************/
-registerBlock(isfinite, IsFinite)
+registerBlock(isfinite, isFinite)
 
 /***********************************************************************
  * |PothosDoc Is Infinite?
@@ -124,9 +228,24 @@ registerBlock(isfinite, IsFinite)
  * |default "float64"
  * |preview disable
  *
+ * |param mode[Mode] The output format.
+ * <ul>
+ * <li><b>Flags:</b> one int8 per element</li>
+ * <li><b>Packed:</b> one bit per element, least significant bit first,
+ * packed eight elements to each output element</li>
+ * <li><b>Count:</b> a message with the number of matching elements
+ * in each input buffer, with no stream output and no labels</li>
+ * </ul>
+ * |option [Flags] "FLAGS"
+ * |option [Packed] "PACKED"
+ * |option [Count] "COUNT"
+ * |default "FLAGS"
+ * |preview enable
+ *
  * |factory /blocks/isinf(dtype)
+ * |setter setMode(mode)
  **********************************************************************/
-registerBlock(isinf, IsInf)
+registerBlock(isinf, isInf)
 
 /***********************************************************************
  * |PothosDoc Is NaN?
@@ -141,9 +260,24 @@ registerBlock(isinf, IsInf)
  * |default "float64"
  * |preview disable
  *
+ * |param mode[Mode] The output format.
+ * <ul>
+ * <li><b>Flags:</b> one int8 per element</li>
+ * <li><b>Packed:</b> one bit per element, least significant bit first,
+ * packed eight elements to each output element</li>
+ * <li><b>Count:</b> a message with the number of matching elements
+ * in each input buffer, with no stream output and no labels</li>
+ * </ul>
+ * |option [Flags] "FLAGS"
+ * |option [Packed] "PACKED"
+ * |option [Count] "COUNT"
+ * |default "FLAGS"
+ * |preview enable
+ *
  * |factory /blocks/isnan(dtype)
+ * |setter setMode(mode)
  **********************************************************************/
-registerBlock(isnan, IsNaN)
+registerBlock(isnan, isNaN)
 
 /***********************************************************************
  * |PothosDoc Is Normal?
@@ -159,9 +293,24 @@ registerBlock(isnan, IsNaN)
  * |default "float64"
  * |preview disable
  *
+ * |param mode[Mode] The output format.
+ * <ul>
+ * <li><b>Flags:</b> one int8 per element</li>
+ * <li><b>Packed:</b> one bit per element, least significant bit first,
+ * packed eight elements to each output element</li>
+ * <li><b>Count:</b> a message with the number of matching elements
+ * in each input buffer, with no stream output and no labels</li>
+ * </ul>
+ * |option [Flags] "FLAGS"
+ * |option [Packed] "PACKED"
+ * |option [Count] "COUNT"
+ * |default "FLAGS"
+ * |preview enable
+ *
  * |factory /blocks/isnormal(dtype)
+ * |setter setMode(mode)
  **********************************************************************/
-registerBlock(isnormal, IsNormal)
+registerBlock(isnormal, isNormal)
 
 /***********************************************************************
  * |PothosDoc Is Negative?
@@ -176,6 +325,21 @@ registerBlock(isnormal, IsNormal)
  * |default "float64"
  * |preview disable
  *
+ * |param mode[Mode] The output format.
+ * <ul>
+ * <li><b>Flags:</b> one int8 per element</li>
+ * <li><b>Packed:</b> one bit per element, least significant bit first,
+ * packed eight elements to each output element</li>
+ * <li><b>Count:</b> a message with the number of matching elements
+ * in each input buffer, with no stream output and no labels</li>
+ * </ul>
+ * |option [Flags] "FLAGS"
+ * |option [Packed] "PACKED"
+ * |option [Count] "COUNT"
+ * |default "FLAGS"
+ * |preview enable
+ *
  * |factory /blocks/isnegative(dtype)
+ * |setter setMode(mode)
  **********************************************************************/
-registerBlock(isnegative, IsNegative)
+registerBlock(isnegative, isNegative)
@@ -5,8 +5,11 @@
 #include <Pothos/Exception.hpp>
 #include <Pothos/Framework.hpp>
 
+#include "StreamKernels.hpp"
+
 #include <algorithm>
-#include <limits>
+#include <cstdint>
+#include <cstring>
 
 /***********************************************************************
  * |PothosDoc MinMax
@@ -14,6 +17,13 @@
  * Compares all streams per-element, placing the minimum value in the
  * "min" output port and the maximum value in the "max" output port.
  *
+ * Optionally, the "argmin" and "argmax" output ports carry the index of
+ * the input that the minimum and maximum came from, as uint32 values.
+ * These ports are added when the block is created with output indices
+ * enabled.
+ * Ties go to the lowest index for the minimum and the highest index
+ * for the maximum.
+ *
  * |category /Stream
  * |keywords min max
  *
@@ -27,7 +37,13 @@
  * |default 2
  * |preview disable
  *
+ * |param outputIndices[Output Indices?] Whether or not to add the "argmin" and "argmax" output ports.
+ * |widget ToggleSwitch(on="True",off="False")
+ * |default false
+ * |preview disable
+ *
  * |factory /blocks/minmax(dtype,numInputs)
+ * |initializer enableIndices(outputIndices)
  **********************************************************************/
 
 template <typename T>
@@ -38,7 +54,9 @@ public:
 
     MinMax(size_t dimension, size_t numInputs):
         Pothos::Block(),
-        _numInputs(numInputs)
+        _numInputs(numInputs),
+        _outputIndices(false),
+        _kernels(getStreamKernels<T>())
     {
         const Pothos::DType dtype(typeid(T), dimension);
 
@@ -49,6 +67,22 @@ public:
 
         this->setupOutput("min", dtype);
         this->setupOutput("max", dtype);
+
+        this->registerCall(this, POTHOS_FCN_TUPLE(Class, enableIndices));
+    }
+
+    // Ports can only be added, so this is called once on construction.
+    void enableIndices(bool outputIndices)
+    {
+        if(!outputIndices || _outputIndices)
+        {
+            return;
+        }
+
+        const Pothos::DType indexDType("uint32", this->output("min")->dtype().dimension());
+        this->setupOutput("argmin", indexDType);
+        this->setupOutput("argmax", indexDType);
+        _outputIndices = true;
     }
 
     void work() override
@@ -66,31 +100,73 @@ public:
         T* outputMinBuf = outputMin->buffer();
         T* outputMaxBuf = outputMax->buffer();
 
-        for(size_t elem = 0; elem < elems; ++elem)
+        std::uint32_t* argMinBuf = nullptr;
+        std::uint32_t* argMaxBuf = nullptr;
+        if(_outputIndices)
         {
-            std::vector<T> indexElems;
-            std::transform(
-                inputs.begin(),
-                inputs.end(),
-                std::back_inserter(indexElems),
-                [&elem](Pothos::InputPort* inputPort)
-                {
-                    return inputPort->buffer().as<const T*>()[elem];
-                });
-            
-            auto minMaxIters = std::minmax_element(indexElems.begin(), indexElems.end());
+            argMinBuf = this->output("argmin")->buffer();
+            argMaxBuf = this->output("argmax")->buffer();
+        }
+
+        // Go through the buffers one tile at a time so the running min
+        // and max stay in cache while each input is folded in.
+        const auto num = elems * outputMin->dtype().dimension();
+        for(size_t tileStart = 0; tileStart < num; tileStart += TileSize)
+        {
+            const auto tile = ((num - tileStart) < TileSize) ? (num - tileStart) : TileSize;
+
+            T* tileMin = outputMinBuf + tileStart;
+            T* tileMax = outputMaxBuf + tileStart;
+
+            // Start from the first input, and fold in each other input.
+            const T* firstBuf = inputs[0]->buffer();
+            std::memcpy(tileMin, firstBuf + tileStart, tile * sizeof(T));
+            std::memcpy(tileMax, firstBuf + tileStart, tile * sizeof(T));
+
+            if(_outputIndices)
+            {
+                std::uint32_t* tileArgMin = argMinBuf + tileStart;
+                std::uint32_t* tileArgMax = argMaxBuf + tileStart;
+                std::fill(tileArgMin, tileArgMin + tile, 0);
+                std::fill(tileArgMax, tileArgMax + tile, 0);
 
-            outputMinBuf[elem] = *minMaxIters.first;
-            outputMaxBuf[elem] = *minMaxIters.second;
+                for(size_t chanIn = 1; chanIn < _numInputs; ++chanIn)
+                {
+                    const T* inputBuf = inputs[chanIn]->buffer();
+                    const auto index = static_cast<std::uint32_t>(chanIn);
+                    _kernels.argMin(inputBuf + tileStart, tileMin, tileArgMin, index, tile);
+                    _kernels.argMax(inputBuf + tileStart, tileMax, tileArgMax, index, tile);
+                }
+            }
+            else
+            {
+                for(size_t chanIn = 1; chanIn < _numInputs; ++chanIn)
+                {
+                    const T* inputBuf = inputs[chanIn]->buffer();
+                    _kernels.min(inputBuf + tileStart, tileMin, tile);
+                    _kernels.max(inputBuf + tileStart, tileMax, tile);
+                }
+            }
         }
 
         for(auto* input: inputs) input->consume(elems);
         outputMin->produce(elems);
         outputMax->produce(elems);
+        if(_outputIndices)
+        {
+            this->output("argmin")->produce(elems);
+            this->output("argmax")->produce(elems);
+        }
     }
 
 private:
+    // 4 KiB of each running output
+    static constexpr size_t TileSize = 4096 / sizeof(T);
+
     size_t _numInputs;
+    bool _outputIndices;
+
+    const StreamKernels<T>& _kernels;
 };
 
 static Pothos::Block* makeMinMax(const Pothos::DType& dtype, size_t numInputs)
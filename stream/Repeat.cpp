@@ -4,7 +4,9 @@
 #include <Pothos/Exception.hpp>
 #include <Pothos/Framework.hpp>
 
-#include <cstring>
+#include "StreamKernels.hpp"
+
+#include <algorithm>
 
 /***********************************************************************
  * |PothosDoc Repeat
@@ -39,7 +41,8 @@ public:
     Repeat(const Pothos::DType& dtype, size_t repeatCount):
         Pothos::Block(),
         _dtypeSize(dtype.size()),
-        _repeatCount(repeatCount)
+        _repeatCount(repeatCount),
+        _kernels(getStreamCopyKernels())
     {
         this->setupInput(0, dtype);
         this->setupOutput(0, dtype);
@@ -71,22 +74,15 @@ public:
         auto input = this->input(0);
         auto output = this->output(0);
 
-        const std::uint8_t* buffIn = input->buffer();
-        std::uint8_t* buffOut = output->buffer();
-
         const auto elemsToRepeat = std::min(input->elements(), output->elements() / _repeatCount);
         const auto elemsOut = elemsToRepeat * _repeatCount;
 
-        for(size_t elem = 0; elem < elemsToRepeat; ++elem)
-        {
-            for(size_t repeatNum = 0; repeatNum < _repeatCount; ++repeatNum)
-            {
-                std::memcpy(buffOut, buffIn, _dtypeSize);
-                buffOut += _dtypeSize;
-            }
-
-            buffIn += _dtypeSize;
-        }
+        _kernels.repeat(
+            input->buffer().as<const void*>(),
+            output->buffer().as<void*>(),
+            elemsToRepeat,
+            _dtypeSize,
+            _repeatCount);
 
         input->consume(elemsToRepeat);
         output->produce(elemsOut);
@@ -95,6 +91,8 @@ public:
 private:
     size_t _dtypeSize;
     size_t _repeatCount;
+
+    const StreamCopyKernels& _kernels;
 };
 
 static Pothos::BlockRegistry registerRepeat(
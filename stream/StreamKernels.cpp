@@ -0,0 +1,273 @@
+// Copyright (c) 2020 Nicholas Corgan
+// SPDX-License-Identifier: BSL-1.0
+
+#include "StreamKernels.hpp"
+
+#include <Pothos/Exception.hpp>
+
+#include <Poco/Logger.h>
+
+#include <cstdlib>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+//
+// Each compiled variant provides the same tables in its own namespace.
+// The variants other than the scalar fallback are defined by the build
+// only for x86 targets whose compiler accepts the instruction set flags.
+//
+
+#define STREAM_KERNELS_DECLARE(ns) \
+    namespace ns \
+    { \
+        template <typename T> const StreamKernels<T>& kernels(); \
+        template <typename T> const StreamFloatKernels<T>& floatKernels(); \
+        const StreamCopyKernels& copyKernels(); \
+    }
+
+STREAM_KERNELS_DECLARE(StreamKernelsScalar)
+#ifdef POTHOS_STREAM_KERNELS_SSE2
+STREAM_KERNELS_DECLARE(StreamKernelsSSE2)
+#endif
+#ifdef POTHOS_STREAM_KERNELS_AVX2
+STREAM_KERNELS_DECLARE(StreamKernelsAVX2)
+#endif
+#ifdef POTHOS_STREAM_KERNELS_AVX512
+STREAM_KERNELS_DECLARE(StreamKernelsAVX512)
+#endif
+
+//
+// CPU feature detection
+//
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+
+static bool cpuSupports(StreamISA isa)
+{
+    int regs[4];
+    __cpuid(regs, 0);
+    const int maxLeaf = regs[0];
+
+    __cpuid(regs, 1);
+    const bool sse2 = (regs[3] & (1 << 26)) != 0;
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+    const bool avx = (regs[2] & (1 << 28)) != 0;
+    if(StreamISA::SSE2 == isa) return sse2;
+    if(!osxsave || !avx || (maxLeaf < 7)) return false;
+
+    // The OS must save the YMM (and for AVX-512, the opmask and ZMM) state.
+    const auto xcr0 = _xgetbv(0);
+    __cpuidex(regs, 7, 0);
+    if(StreamISA::AVX2 == isa)
+    {
+        return ((xcr0 & 0x6) == 0x6) && ((regs[1] & (1 << 5)) != 0);
+    }
+    if(StreamISA::AVX512 == isa)
+    {
+        // AVX-512 F, DQ, BW, and VL
+        const int avx512Bits = (1 << 16) | (1 << 17) | (1 << 30) | (1 << 31);
+        return ((xcr0 & 0xE6) == 0xE6) && ((regs[1] & avx512Bits) == avx512Bits);
+    }
+    return false;
+}
+
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+static bool cpuSupports(StreamISA isa)
+{
+    __builtin_cpu_init();
+    switch(isa)
+    {
+    case StreamISA::SSE2:
+        return __builtin_cpu_supports("sse2");
+    case StreamISA::AVX2:
+        return __builtin_cpu_supports("avx2");
+    case StreamISA::AVX512:
+        return __builtin_cpu_supports("avx512f") &&
+               __builtin_cpu_supports("avx512dq") &&
+               __builtin_cpu_supports("avx512bw") &&
+               __builtin_cpu_supports("avx512vl");
+    default:
+        return false;
+    }
+}
+
+#else
+
+static bool cpuSupports(StreamISA)
+{
+    return false;
+}
+
+#endif
+
+//
+// ISA selection
+//
+
+std::string streamISAToString(StreamISA isa)
+{
+    switch(isa)
+    {
+    case StreamISA::Scalar: return "scalar";
+    case StreamISA::SSE2:   return "sse2";
+    case StreamISA::AVX2:   return "avx2";
+    case StreamISA::AVX512: return "avx512";
+    }
+
+    return "unknown";
+}
+
+StreamISA streamISAFromString(const std::string& name)
+{
+    for(auto isa: {StreamISA::Scalar, StreamISA::SSE2, StreamISA::AVX2, StreamISA::AVX512})
+    {
+        if(streamISAToString(isa) == name) return isa;
+    }
+
+    throw Pothos::InvalidArgumentException("Invalid stream kernel ISA", name);
+}
+
+bool isStreamISASupported(StreamISA isa)
+{
+    switch(isa)
+    {
+    case StreamISA::Scalar:
+        return true;
+#ifdef POTHOS_STREAM_KERNELS_SSE2
+    case StreamISA::SSE2:
+        return cpuSupports(isa);
+#endif
+#ifdef POTHOS_STREAM_KERNELS_AVX2
+    case StreamISA::AVX2:
+        return cpuSupports(isa);
+#endif
+#ifdef POTHOS_STREAM_KERNELS_AVX512
+    case StreamISA::AVX512:
+        return cpuSupports(isa);
+#endif
+    default:
+        return false;
+    }
+}
+
+std::vector<StreamISA> getSupportedStreamISAs()
+{
+    std::vector<StreamISA> isas;
+    for(auto isa: {StreamISA::Scalar, StreamISA::SSE2, StreamISA::AVX2, StreamISA::AVX512})
+    {
+        if(isStreamISASupported(isa)) isas.emplace_back(isa);
+    }
+
+    return isas;
+}
+
+static StreamISA selectStreamISA()
+{
+    const auto supportedISAs = getSupportedStreamISAs();
+    const auto bestISA = supportedISAs.back();
+
+    const char* forcedName = std::getenv("POTHOS_STREAM_ISA");
+    if((nullptr == forcedName) || ('\0' == forcedName[0])) return bestISA;
+
+    auto& logger = Poco::Logger::get("StreamKernels");
+    try
+    {
+        const auto forcedISA = streamISAFromString(forcedName);
+        if(isStreamISASupported(forcedISA))
+        {
+            poco_information_f1(logger, "Using %s kernels from POTHOS_STREAM_ISA", std::string(forcedName));
+            return forcedISA;
+        }
+
+        poco_warning_f2(
+            logger,
+            "POTHOS_STREAM_ISA=%s is not supported on this machine, using %s",
+            std::string(forcedName),
+            streamISAToString(bestISA));
+    }
+    catch(const Pothos::InvalidArgumentException&)
+    {
+        poco_warning_f2(
+            logger,
+            "POTHOS_STREAM_ISA=%s is not a valid ISA, using %s",
+            std::string(forcedName),
+            streamISAToString(bestISA));
+    }
+
+    return bestISA;
+}
+
+StreamISA getStreamISA()
+{
+    static const StreamISA isa = selectStreamISA();
+    return isa;
+}
+
+//
+// Table lookup
+//
+
+#define STREAM_KERNELS_SELECT(getter) \
+    switch(isa) \
+    { \
+    STREAM_KERNELS_CASE_SSE2(getter) \
+    STREAM_KERNELS_CASE_AVX2(getter) \
+    STREAM_KERNELS_CASE_AVX512(getter) \
+    default: \
+        return StreamKernelsScalar::getter; \
+    }
+
+#ifdef POTHOS_STREAM_KERNELS_SSE2
+#define STREAM_KERNELS_CASE_SSE2(getter) case StreamISA::SSE2: if(isStreamISASupported(isa)) return StreamKernelsSSE2::getter; break;
+#else
+#define STREAM_KERNELS_CASE_SSE2(getter)
+#endif
+
+#ifdef POTHOS_STREAM_KERNELS_AVX2
+#define STREAM_KERNELS_CASE_AVX2(getter) case StreamISA::AVX2: if(isStreamISASupported(isa)) return StreamKernelsAVX2::getter; break;
+#else
+#define STREAM_KERNELS_CASE_AVX2(getter)
+#endif
+
+#ifdef POTHOS_STREAM_KERNELS_AVX512
+#define STREAM_KERNELS_CASE_AVX512(getter) case StreamISA::AVX512: if(isStreamISASupported(isa)) return StreamKernelsAVX512::getter; break;
+#else
+#define STREAM_KERNELS_CASE_AVX512(getter)
+#endif
+
+template <typename T>
+const StreamKernels<T>& getStreamKernels(StreamISA isa)
+{
+    STREAM_KERNELS_SELECT(kernels<T>())
+    return StreamKernelsScalar::kernels<T>();
+}
+
+template <typename T>
+const StreamFloatKernels<T>& getStreamFloatKernels(StreamISA isa)
+{
+    STREAM_KERNELS_SELECT(floatKernels<T>())
+    return StreamKernelsScalar::floatKernels<T>();
+}
+
+const StreamCopyKernels& getStreamCopyKernels(StreamISA isa)
+{
+    STREAM_KERNELS_SELECT(copyKernels())
+    return StreamKernelsScalar::copyKernels();
+}
+
+template const StreamKernels<std::int8_t>& getStreamKernels<std::int8_t>(StreamISA);
+template const StreamKernels<std::int16_t>& getStreamKernels<std::int16_t>(StreamISA);
+template const StreamKernels<std::int32_t>& getStreamKernels<std::int32_t>(StreamISA);
+template const StreamKernels<std::int64_t>& getStreamKernels<std::int64_t>(StreamISA);
+template const StreamKernels<std::uint8_t>& getStreamKernels<std::uint8_t>(StreamISA);
+template const StreamKernels<std::uint16_t>& getStreamKernels<std::uint16_t>(StreamISA);
+template const StreamKernels<std::uint32_t>& getStreamKernels<std::uint32_t>(StreamISA);
+template const StreamKernels<std::uint64_t>& getStreamKernels<std::uint64_t>(StreamISA);
+template const StreamKernels<float>& getStreamKernels<float>(StreamISA);
+template const StreamKernels<double>& getStreamKernels<double>(StreamISA);
+
+template const StreamFloatKernels<float>& getStreamFloatKernels<float>(StreamISA);
+template const StreamFloatKernels<double>& getStreamFloatKernels<double>(StreamISA);
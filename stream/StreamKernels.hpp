@@ -0,0 +1,108 @@
+// Copyright (c) 2020 Nicholas Corgan
+// SPDX-License-Identifier: BSL-1.0
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//
+// Instruction sets with a compiled kernel variant
+//
+
+enum class StreamISA
+{
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+std::string streamISAToString(StreamISA isa);
+
+StreamISA streamISAFromString(const std::string& name);
+
+// Whether the variant was compiled in and the CPU can run it.
+bool isStreamISASupported(StreamISA isa);
+
+// All supported variants, starting with the scalar fallback.
+std::vector<StreamISA> getSupportedStreamISAs();
+
+// The variant used by the stream blocks, chosen once per process: the
+// best variant supported by the CPU, or the variant forced with the
+// POTHOS_STREAM_ISA environment variable ("scalar", "sse2", "avx2",
+// or "avx512").
+StreamISA getStreamISA();
+
+//
+// Kernel tables
+//
+// Blocks look up their table once at construction and then call through
+// it once per buffer, so the kernel loops are free to vectorize.
+//
+
+template <typename T>
+struct StreamKernels
+{
+    // out = in constrained to [lo, hi], or to one side of it
+    void (*clamp)(const T* in, T* out, size_t num, T lo, T hi);
+    void (*clampLow)(const T* in, T* out, size_t num, T lo);
+    void (*clampHigh)(const T* in, T* out, size_t num, T hi);
+
+    // clamp, adding the number of elements below lo and above hi to the counters
+    void (*clampCount)(const T* in, T* out, size_t num, T lo, T hi, size_t* numLow, size_t* numHigh);
+
+    // inOut = elementwise min/max of in and inOut
+    void (*min)(const T* in, T* inOut, size_t num);
+    void (*max)(const T* in, T* inOut, size_t num);
+
+    // min/max, also setting indexInOut = index wherever in wins
+    void (*argMin)(const T* in, T* inOut, std::uint32_t* indexInOut, std::uint32_t index, size_t num);
+    void (*argMax)(const T* in, T* inOut, std::uint32_t* indexInOut, std::uint32_t index, size_t num);
+};
+
+template <typename T>
+struct StreamClassifyKernels
+{
+    // out = 1 where the predicate holds, 0 elsewhere
+    void (*flags)(const T* in, std::int8_t* out, size_t num);
+
+    // Bit (elem % 8) of out[elem / 8] = 1 where the predicate holds,
+    // with the unused bits of a trailing partial byte cleared
+    void (*packed)(const T* in, std::uint8_t* out, size_t num);
+
+    // The number of elements where the predicate holds
+    size_t (*count)(const T* in, size_t num);
+};
+
+template <typename T>
+struct StreamFloatKernels
+{
+    StreamClassifyKernels<T> isFinite;
+    StreamClassifyKernels<T> isInf;
+    StreamClassifyKernels<T> isNaN;
+    StreamClassifyKernels<T> isNormal;
+    StreamClassifyKernels<T> isNegative;
+};
+
+struct StreamCopyKernels
+{
+    // Copy each element of elemSize bytes count times.
+    void (*repeat)(const void* in, void* out, size_t num, size_t elemSize, size_t count);
+
+    // Take one chunk of chunkBytes bytes from each input in turn.
+    void (*interleave)(const void* const* ins, size_t numIns, void* out, size_t numChunks, size_t chunkBytes);
+
+    // Deal out one chunk of chunkBytes bytes to each output in turn.
+    void (*deinterleave)(const void* in, void* const* outs, size_t numOuts, size_t numChunks, size_t chunkBytes);
+};
+
+template <typename T>
+const StreamKernels<T>& getStreamKernels(StreamISA isa = getStreamISA());
+
+template <typename T>
+const StreamFloatKernels<T>& getStreamFloatKernels(StreamISA isa = getStreamISA());
+
+const StreamCopyKernels& getStreamCopyKernels(StreamISA isa = getStreamISA());
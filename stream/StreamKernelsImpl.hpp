@@ -0,0 +1,512 @@
+// Copyright (c) 2020 Nicholas Corgan
+// SPDX-License-Identifier: BSL-1.0
+
+//
+// Kernel implementations, included once per instruction set by the
+// StreamKernels<ISA>.cpp files, which are each compiled with their own
+// target flags. Everything here lives in STREAM_KERNELS_NAMESPACE so
+// that the variants never merge at link time. The loops are written
+// for the compiler's vectorizer: no calls, no early exits, and
+// branches only in the form of selects.
+//
+
+#ifndef STREAM_KERNELS_NAMESPACE
+#error "STREAM_KERNELS_NAMESPACE must be defined before including StreamKernelsImpl.hpp"
+#endif
+
+#include "StreamKernels.hpp"
+
+#include <cstring>
+
+namespace STREAM_KERNELS_NAMESPACE
+{
+
+//
+// Arithmetic kernels
+//
+
+template <typename T>
+static void clamp(const T* in, T* out, size_t num, T lo, T hi)
+{
+    for(size_t elem = 0; elem < num; ++elem)
+    {
+        const T x = in[elem];
+        const T y = (x < lo) ? lo : x;
+        out[elem] = (hi < y) ? hi : y;
+    }
+}
+
+template <typename T>
+static void clampLow(const T* in, T* out, size_t num, T lo)
+{
+    for(size_t elem = 0; elem < num; ++elem)
+    {
+        out[elem] = (in[elem] < lo) ? lo : in[elem];
+    }
+}
+
+template <typename T>
+static void clampHigh(const T* in, T* out, size_t num, T hi)
+{
+    for(size_t elem = 0; elem < num; ++elem)
+    {
+        out[elem] = (hi < in[elem]) ? hi : in[elem];
+    }
+}
+
+// Counters as wide as the element, so that the counts vectorize
+// in the same lanes as the comparisons
+template <size_t Size> struct Counter;
+template <> struct Counter<1> {using UInt = std::uint8_t;};
+template <> struct Counter<2> {using UInt = std::uint16_t;};
+template <> struct Counter<4> {using UInt = std::uint32_t;};
+template <> struct Counter<8> {using UInt = std::uint64_t;};
+
+// The counts are reductions in the same pass, so clipping statistics
+// don't need a second trip through memory. Tiles are short enough that
+// the narrow counters never wrap.
+template <typename T>
+static void clampCount(const T* in, T* out, size_t num, T lo, T hi, size_t* numLow, size_t* numHigh)
+{
+    using UInt = typename Counter<sizeof(T)>::UInt;
+    const size_t maxTile = size_t(1) << 30;
+    const size_t tile = (size_t(UInt(~UInt(0))) < maxTile) ? size_t(UInt(~UInt(0))) : maxTile;
+
+    for(size_t start = 0; start < num; start += tile)
+    {
+        const size_t end = ((num - start) < tile) ? num : (start + tile);
+        UInt low = 0;
+        UInt high = 0;
+        for(size_t elem = start; elem < end; ++elem)
+        {
+            const T x = in[elem];
+            low += (x < lo) ? 1 : 0;
+            high += (hi < x) ? 1 : 0;
+            const T y = (x < lo) ? lo : x;
+            out[elem] = (hi < y) ? hi : y;
+        }
+
+        *numLow += low;
+        *numHigh += high;
+    }
+}
+
+// Ties keep the earliest input, like std::minmax_element.
+template <typename T>
+static void elementwiseMin(const T* in, T* inOut, size_t num)
+{
+    for(size_t elem = 0; elem < num; ++elem)
+    {
+        inOut[elem] = (in[elem] < inOut[elem]) ? in[elem] : inOut[elem];
+    }
+}
+
+// Ties keep the latest input, like std::minmax_element.
+template <typename T>
+static void elementwiseMax(const T* in, T* inOut, size_t num)
+{
+    for(size_t elem = 0; elem < num; ++elem)
+    {
+        inOut[elem] = (in[elem] < inOut[elem]) ? inOut[elem] : in[elem];
+    }
+}
+
+template <typename T>
+static void elementwiseArgMin(const T* in, T* inOut, std::uint32_t* indexInOut, std::uint32_t index, size_t num)
+{
+    for(size_t elem = 0; elem < num; ++elem)
+    {
+        const bool wins = in[elem] < inOut[elem];
+        inOut[elem] = wins ? in[elem] : inOut[elem];
+        indexInOut[elem] = wins ? index : indexInOut[elem];
+    }
+}
+
+template <typename T>
+static void elementwiseArgMax(const T* in, T* inOut, std::uint32_t* indexInOut, std::uint32_t index, size_t num)
+{
+    for(size_t elem = 0; elem < num; ++elem)
+    {
+        const bool wins = !(in[elem] < inOut[elem]);
+        inOut[elem] = wins ? in[elem] : inOut[elem];
+        indexInOut[elem] = wins ? index : indexInOut[elem];
+    }
+}
+
+template <typename T>
+const StreamKernels<T>& kernels()
+{
+    static const StreamKernels<T> table =
+    {
+        &clamp<T>,
+        &clampLow<T>,
+        &clampHigh<T>,
+        &clampCount<T>,
+        &elementwiseMin<T>,
+        &elementwiseMax<T>,
+        &elementwiseArgMin<T>,
+        &elementwiseArgMax<T>
+    };
+    return table;
+}
+
+template const StreamKernels<std::int8_t>& kernels<std::int8_t>();
+template const StreamKernels<std::int16_t>& kernels<std::int16_t>();
+template const StreamKernels<std::int32_t>& kernels<std::int32_t>();
+template const StreamKernels<std::int64_t>& kernels<std::int64_t>();
+template const StreamKernels<std::uint8_t>& kernels<std::uint8_t>();
+template const StreamKernels<std::uint16_t>& kernels<std::uint16_t>();
+template const StreamKernels<std::uint32_t>& kernels<std::uint32_t>();
+template const StreamKernels<std::uint64_t>& kernels<std::uint64_t>();
+template const StreamKernels<float>& kernels<float>();
+template const StreamKernels<double>& kernels<double>();
+
+//
+// Floating-point classification on the IEEE-754 bit patterns
+//
+
+template <typename T>
+struct FloatBits;
+
+template <>
+struct FloatBits<float>
+{
+    using UInt = std::uint32_t;
+    static UInt sign() {return 0x80000000U;}
+    static UInt exponent() {return 0x7F800000U;}
+};
+
+template <>
+struct FloatBits<double>
+{
+    using UInt = std::uint64_t;
+    static UInt sign() {return 0x8000000000000000ULL;}
+    static UInt exponent() {return 0x7FF0000000000000ULL;}
+};
+
+template <typename T>
+struct IsFinite
+{
+    static bool test(typename FloatBits<T>::UInt bits)
+    {
+        return (bits & FloatBits<T>::exponent()) != FloatBits<T>::exponent();
+    }
+};
+
+template <typename T>
+struct IsInf
+{
+    static bool test(typename FloatBits<T>::UInt bits)
+    {
+        return (bits & ~FloatBits<T>::sign()) == FloatBits<T>::exponent();
+    }
+};
+
+template <typename T>
+struct IsNaN
+{
+    static bool test(typename FloatBits<T>::UInt bits)
+    {
+        return (bits & ~FloatBits<T>::sign()) > FloatBits<T>::exponent();
+    }
+};
+
+template <typename T>
+struct IsNormal
+{
+    static bool test(typename FloatBits<T>::UInt bits)
+    {
+        const auto exponent = bits & FloatBits<T>::exponent();
+        return (exponent != 0) & (exponent != FloatBits<T>::exponent());
+    }
+};
+
+template <typename T>
+struct IsNegative
+{
+    static bool test(typename FloatBits<T>::UInt bits)
+    {
+        return (bits & FloatBits<T>::sign()) != 0;
+    }
+};
+
+template <typename T, typename Predicate>
+static void classify(const T* in, std::int8_t* out, size_t num)
+{
+    for(size_t elem = 0; elem < num; ++elem)
+    {
+        typename FloatBits<T>::UInt bits;
+        std::memcpy(&bits, in + elem, sizeof(bits));
+        out[elem] = Predicate::test(bits) ? 1 : 0;
+    }
+}
+
+// Classifies a cache-resident tile into bytes with the vectorized loop
+// above, then gathers each group of eight bytes into one.
+template <typename T, typename Predicate>
+static void classifyPacked(const T* in, std::uint8_t* out, size_t num)
+{
+    static const size_t TileSize = 512;
+    std::int8_t flags[TileSize];
+
+    for(size_t start = 0; start < num; start += TileSize)
+    {
+        const size_t tile = ((num - start) < TileSize) ? (num - start) : TileSize;
+        classify<T, Predicate>(in + start, flags, tile);
+
+        // Clear the unused bits of a trailing partial byte.
+        const size_t numBytes = (tile + 7) / 8;
+        std::memset(flags + tile, 0, (numBytes * 8) - tile);
+
+        std::uint8_t* tileOut = out + (start / 8);
+        for(size_t byte = 0; byte < numBytes; ++byte)
+        {
+            const std::int8_t* bits = flags + (byte * 8);
+            tileOut[byte] = std::uint8_t(
+                (bits[0] << 0) | (bits[1] << 1) | (bits[2] << 2) | (bits[3] << 3) |
+                (bits[4] << 4) | (bits[5] << 5) | (bits[6] << 6) | (bits[7] << 7));
+        }
+    }
+}
+
+// Counts in lanes as wide as the element over tiles short enough
+// that the lane counters never wrap.
+template <typename T, typename Predicate>
+static size_t classifyCount(const T* in, size_t num)
+{
+    using UInt = typename FloatBits<T>::UInt;
+    const size_t tile = size_t(1) << 30;
+
+    size_t count = 0;
+    for(size_t start = 0; start < num; start += tile)
+    {
+        const size_t end = ((num - start) < tile) ? num : (start + tile);
+        UInt tileCount = 0;
+        for(size_t elem = start; elem < end; ++elem)
+        {
+            UInt bits;
+            std::memcpy(&bits, in + elem, sizeof(bits));
+            tileCount += Predicate::test(bits) ? 1 : 0;
+        }
+
+        count += size_t(tileCount);
+    }
+
+    return count;
+}
+
+template <typename T, typename Predicate>
+static StreamClassifyKernels<T> classifyKernels()
+{
+    return
+    {
+        &classify<T, Predicate>,
+        &classifyPacked<T, Predicate>,
+        &classifyCount<T, Predicate>
+    };
+}
+
+template <typename T>
+const StreamFloatKernels<T>& floatKernels()
+{
+    static const StreamFloatKernels<T> table =
+    {
+        classifyKernels<T, IsFinite<T>>(),
+        classifyKernels<T, IsInf<T>>(),
+        classifyKernels<T, IsNaN<T>>(),
+        classifyKernels<T, IsNormal<T>>(),
+        classifyKernels<T, IsNegative<T>>()
+    };
+    return table;
+}
+
+template const StreamFloatKernels<float>& floatKernels<float>();
+template const StreamFloatKernels<double>& floatKernels<double>();
+
+//
+// Copy kernels, specialized on the element size so that each element
+// moves as one word, and on small counts so that the loops vectorize.
+// Buffers carry no alignment guarantee for the word type, so elements
+// are moved with fixed-size memcpy, which compiles to plain loads/stores.
+//
+
+struct Bytes16
+{
+    std::uint64_t words[2];
+};
+
+template <typename E>
+static inline E loadElem(const void* base, size_t index)
+{
+    E x;
+    std::memcpy(&x, static_cast<const std::uint8_t*>(base) + index*sizeof(E), sizeof(E));
+    return x;
+}
+
+template <typename E>
+static inline void storeElem(void* base, size_t index, const E& x)
+{
+    std::memcpy(static_cast<std::uint8_t*>(base) + index*sizeof(E), &x, sizeof(E));
+}
+
+template <typename E, size_t Count>
+static void repeatFixed(const void* in, void* out, size_t num)
+{
+    for(size_t elem = 0; elem < num; ++elem)
+    {
+        const E x = loadElem<E>(in, elem);
+        for(size_t repeatNum = 0; repeatNum < Count; ++repeatNum)
+        {
+            storeElem<E>(out, elem*Count + repeatNum, x);
+        }
+    }
+}
+
+template <typename E>
+static void repeatTyped(const void* in, void* out, size_t num, size_t count)
+{
+    if(2 == count) return repeatFixed<E, 2>(in, out, num);
+    if(4 == count) return repeatFixed<E, 4>(in, out, num);
+
+    size_t outIndex = 0;
+    for(size_t elem = 0; elem < num; ++elem)
+    {
+        const E x = loadElem<E>(in, elem);
+        for(size_t repeatNum = 0; repeatNum < count; ++repeatNum) storeElem<E>(out, outIndex++, x);
+    }
+}
+
+static void repeat(const void* in, void* out, size_t num, size_t elemSize, size_t count)
+{
+    switch(elemSize)
+    {
+    case 1: return repeatTyped<std::uint8_t>(in, out, num, count);
+    case 2: return repeatTyped<std::uint16_t>(in, out, num, count);
+    case 4: return repeatTyped<std::uint32_t>(in, out, num, count);
+    case 8: return repeatTyped<std::uint64_t>(in, out, num, count);
+    case 16: return repeatTyped<Bytes16>(in, out, num, count);
+    default: break;
+    }
+
+    const std::uint8_t* src = static_cast<const std::uint8_t*>(in);
+    std::uint8_t* dst = static_cast<std::uint8_t*>(out);
+    for(size_t elem = 0; elem < num; ++elem)
+    {
+        for(size_t repeatNum = 0; repeatNum < count; ++repeatNum)
+        {
+            std::memcpy(dst, src, elemSize);
+            dst += elemSize;
+        }
+        src += elemSize;
+    }
+}
+
+template <typename E, size_t NumIns>
+static void interleaveFixed(const void* const* ins, void* out, size_t numChunks)
+{
+    for(size_t chunk = 0; chunk < numChunks; ++chunk)
+    {
+        for(size_t chan = 0; chan < NumIns; ++chan)
+        {
+            storeElem<E>(out, chunk*NumIns + chan, loadElem<E>(ins[chan], chunk));
+        }
+    }
+}
+
+template <typename E>
+static void interleaveTyped(const void* const* ins, size_t numIns, void* out, size_t numChunks)
+{
+    if(2 == numIns) return interleaveFixed<E, 2>(ins, out, numChunks);
+    if(4 == numIns) return interleaveFixed<E, 4>(ins, out, numChunks);
+    if(8 == numIns) return interleaveFixed<E, 8>(ins, out, numChunks);
+
+    for(size_t chan = 0; chan < numIns; ++chan)
+    {
+        for(size_t chunk = 0; chunk < numChunks; ++chunk)
+        {
+            storeElem<E>(out, chunk*numIns + chan, loadElem<E>(ins[chan], chunk));
+        }
+    }
+}
+
+static void interleave(const void* const* ins, size_t numIns, void* out, size_t numChunks, size_t chunkBytes)
+{
+    switch(chunkBytes)
+    {
+    case 1: return interleaveTyped<std::uint8_t>(ins, numIns, out, numChunks);
+    case 2: return interleaveTyped<std::uint16_t>(ins, numIns, out, numChunks);
+    case 4: return interleaveTyped<std::uint32_t>(ins, numIns, out, numChunks);
+    case 8: return interleaveTyped<std::uint64_t>(ins, numIns, out, numChunks);
+    case 16: return interleaveTyped<Bytes16>(ins, numIns, out, numChunks);
+    default: break;
+    }
+
+    std::uint8_t* dst = static_cast<std::uint8_t*>(out);
+    for(size_t chunk = 0; chunk < numChunks; ++chunk)
+    {
+        for(size_t chan = 0; chan < numIns; ++chan)
+        {
+            std::memcpy(dst, static_cast<const std::uint8_t*>(ins[chan]) + chunk*chunkBytes, chunkBytes);
+            dst += chunkBytes;
+        }
+    }
+}
+
+template <typename E, size_t NumOuts>
+static void deinterleaveFixed(const void* in, void* const* outs, size_t numChunks)
+{
+    for(size_t chunk = 0; chunk < numChunks; ++chunk)
+    {
+        for(size_t chan = 0; chan < NumOuts; ++chan)
+        {
+            storeElem<E>(outs[chan], chunk, loadElem<E>(in, chunk*NumOuts + chan));
+        }
+    }
+}
+
+template <typename E>
+static void deinterleaveTyped(const void* in, void* const* outs, size_t numOuts, size_t numChunks)
+{
+    if(2 == numOuts) return deinterleaveFixed<E, 2>(in, outs, numChunks);
+    if(4 == numOuts) return deinterleaveFixed<E, 4>(in, outs, numChunks);
+    if(8 == numOuts) return deinterleaveFixed<E, 8>(in, outs, numChunks);
+
+    for(size_t chan = 0; chan < numOuts; ++chan)
+    {
+        for(size_t chunk = 0; chunk < numChunks; ++chunk)
+        {
+            storeElem<E>(outs[chan], chunk, loadElem<E>(in, chunk*numOuts + chan));
+        }
+    }
+}
+
+static void deinterleave(const void* in, void* const* outs, size_t numOuts, size_t numChunks, size_t chunkBytes)
+{
+    switch(chunkBytes)
+    {
+    case 1: return deinterleaveTyped<std::uint8_t>(in, outs, numOuts, numChunks);
+    case 2: return deinterleaveTyped<std::uint16_t>(in, outs, numOuts, numChunks);
+    case 4: return deinterleaveTyped<std::uint32_t>(in, outs, numOuts, numChunks);
+    case 8: return deinterleaveTyped<std::uint64_t>(in, outs, numOuts, numChunks);
+    case 16: return deinterleaveTyped<Bytes16>(in, outs, numOuts, numChunks);
+    default: break;
+    }
+
+    const std::uint8_t* src = static_cast<const std::uint8_t*>(in);
+    for(size_t chunk = 0; chunk < numChunks; ++chunk)
+    {
+        for(size_t chan = 0; chan < numOuts; ++chan)
+        {
+            std::memcpy(static_cast<std::uint8_t*>(outs[chan]) + chunk*chunkBytes, src, chunkBytes);
+            src += chunkBytes;
+        }
+    }
+}
+
+const StreamCopyKernels& copyKernels()
+{
+    static const StreamCopyKernels table = {&repeat, &interleave, &deinterleave};
+    return table;
+}
+
+}
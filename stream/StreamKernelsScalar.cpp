@@ -0,0 +1,5 @@
+// Copyright (c) 2020 Nicholas Corgan
+// SPDX-License-Identifier: BSL-1.0
+
+#define STREAM_KERNELS_NAMESPACE StreamKernelsScalar
+#include "StreamKernelsImpl.hpp"
@@ -107,6 +107,83 @@ static void testClamp(
         collectorSink.call("getBuffer"));
 }
 
+template <typename T>
+static void testClipCounts(
+    T min,
+    T max,
+    bool clampMin,
+    const std::vector<T>& inputs,
+    unsigned long long expectedLow,
+    unsigned long long expectedHigh)
+{
+    std::cout << " * clip counts, clampMin: " << clampMin << "..." << std::endl;
+
+    static const Pothos::DType dtype(typeid(T));
+    static constexpr size_t ClipLabelInterval = 4;
+
+    auto feederSource = Pothos::BlockRegistry::make(
+                            "/blocks/feeder_source",
+                            dtype);
+    feederSource.call(
+        "feedBuffer",
+        stdVectorToBufferChunk(inputs));
+
+    auto clamp = Pothos::BlockRegistry::make("/blocks/clamp", dtype);
+    clamp.call("setMinAndMax", min, max);
+    clamp.call("setClampMin", clampMin);
+    clamp.call("setCountClips", true);
+    clamp.call("setClipLabelInterval", ClipLabelInterval);
+
+    POTHOS_TEST_TRUE(clamp.call<bool>("countClips"));
+    POTHOS_TEST_EQUAL(ClipLabelInterval, clamp.call<size_t>("clipLabelInterval"));
+
+    auto collectorSink = Pothos::BlockRegistry::make(
+                             "/blocks/collector_sink",
+                             dtype);
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect(
+            feederSource, 0,
+            clamp, 0);
+        topology.connect(
+            clamp, 0,
+            collectorSink, 0);
+
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive());
+    }
+
+    POTHOS_TEST_EQUAL(expectedLow, clamp.call<unsigned long long>("clippedLow"));
+    POTHOS_TEST_EQUAL(expectedHigh, clamp.call<unsigned long long>("clippedHigh"));
+
+    // One label per interval, with the running totals.
+    const auto labels = collectorSink.call<std::vector<Pothos::Label>>("getLabels");
+    POTHOS_TEST_EQUAL(inputs.size() / ClipLabelInterval, labels.size());
+    for(size_t labelIndex = 0; labelIndex < labels.size(); ++labelIndex)
+    {
+        const auto& label = labels[labelIndex];
+        POTHOS_TEST_EQUAL("clips", label.id);
+        POTHOS_TEST_EQUAL(((labelIndex + 1) * ClipLabelInterval) - 1, label.index);
+
+        const auto clips = label.data.extract<Pothos::ObjectKwargs>();
+        const auto low = clips.at("low").convert<unsigned long long>();
+        const auto high = clips.at("high").convert<unsigned long long>();
+        POTHOS_TEST_TRUE(low <= expectedLow);
+        POTHOS_TEST_TRUE(high <= expectedHigh);
+        if(labelIndex == (labels.size() - 1))
+        {
+            POTHOS_TEST_EQUAL(expectedLow, low);
+            POTHOS_TEST_EQUAL(expectedHigh, high);
+        }
+    }
+
+    clamp.call("resetClipCounts");
+    POTHOS_TEST_EQUAL(0, clamp.call<unsigned long long>("clippedLow"));
+    POTHOS_TEST_EQUAL(0, clamp.call<unsigned long long>("clippedHigh"));
+}
+
 template <typename T>
 static void testClamp()
 {
@@ -165,6 +242,9 @@ static void testClamp()
     testClamp(min, max, true, false, inputs, expectedOutputMinClamped);
     testClamp(min, max, false, true, inputs, expectedOutputMaxClamped);
     testClamp(min, max, true, true, inputs, expectedOutputBothClamped);
+
+    testClipCounts(min, max, true, inputs, 3, 3);
+    testClipCounts(min, max, false, inputs, 0, 3);
 }
 
 POTHOS_TEST_BLOCK("/blocks/tests", test_clamp)
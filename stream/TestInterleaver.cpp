@@ -5,6 +5,7 @@
 #include <Pothos/Testing.hpp>
 
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
 #include <vector>
@@ -226,6 +227,78 @@ POTHOS_TEST_BLOCK("/blocks/tests", test_deinterleaver_to_interleaver)
         output.elements());
 }
 
+// Long enough inputs to span several conversion tiles, with chunk
+// size 1 and the channel counts that have their own kernels. Odd
+// channels are fed a different type unless allMatching is set.
+static void testInterleaverChunkSize1(size_t nchans, bool allMatching)
+{
+    std::cout << "Testing " << nchans << " channels, allMatching: " << allMatching << std::endl;
+
+    constexpr size_t numElems = 5000;
+
+    std::vector<Pothos::Proxy> feederSources;
+    for(size_t chan = 0; chan < nchans; ++chan)
+    {
+        std::vector<std::int16_t> input(numElems);
+        for(size_t elem = 0; elem < numElems; ++elem)
+        {
+            input[elem] = std::int16_t((chan * 1000) + elem);
+        }
+
+        if(allMatching || (0 == (chan % 2)))
+        {
+            feederSources.emplace_back(Pothos::BlockRegistry::make("/blocks/feeder_source", "int16"));
+            feederSources.back().call("feedBuffer", stdVectorToBufferChunk(input));
+        }
+        else
+        {
+            feederSources.emplace_back(Pothos::BlockRegistry::make("/blocks/feeder_source", "int32"));
+            feederSources.back().call(
+                "feedBuffer",
+                stdVectorToBufferChunk(std::vector<std::int32_t>(input.begin(), input.end())));
+        }
+    }
+
+    auto interleaver = Pothos::BlockRegistry::make("/blocks/interleaver", "int16", nchans);
+    auto collectorSink = Pothos::BlockRegistry::make("/blocks/collector_sink", "int16");
+
+    {
+        Pothos::Topology topology;
+
+        for(size_t chan = 0; chan < nchans; ++chan)
+        {
+            topology.connect(feederSources[chan], 0, interleaver, chan);
+        }
+        topology.connect(interleaver, 0, collectorSink, 0);
+
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive(0.05));
+    }
+
+    auto output = collectorSink.call<Pothos::BufferChunk>("getBuffer");
+    POTHOS_TEST_EQUAL(numElems * nchans, output.elements());
+
+    const auto* outputBuf = output.as<const std::int16_t*>();
+    for(size_t elem = 0; elem < numElems; ++elem)
+    {
+        for(size_t chan = 0; chan < nchans; ++chan)
+        {
+            POTHOS_TEST_EQUAL(
+                std::int16_t((chan * 1000) + elem),
+                outputBuf[(elem * nchans) + chan]);
+        }
+    }
+}
+
+POTHOS_TEST_BLOCK("/blocks/tests", test_interleaver_chunk_size_1)
+{
+    for(size_t nchans: {2, 4, 8})
+    {
+        testInterleaverChunkSize1(nchans, true);
+        testInterleaverChunkSize1(nchans, false);
+    }
+}
+
 POTHOS_TEST_BLOCK("/blocks/tests", test_interleaver_to_deinterleaver)
 {
     const std::string testTypeName = "float64";
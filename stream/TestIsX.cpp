@@ -4,6 +4,8 @@
 #include <Pothos/Framework.hpp>
 #include <Pothos/Testing.hpp>
 
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
 #include <limits>
@@ -100,6 +102,103 @@ static void testBlock(
         collectorSink.call("getBuffer"));
 }
 
+// Repeat the inputs so that whole bytes are packed, followed by a
+// partial group that the block holds back.
+template <typename T>
+static void testPackedAndCount(
+    const std::string& blockRegistryPath,
+    const Pothos::BufferChunk& inputs,
+    const Pothos::BufferChunk& expectedFlags)
+{
+    const Pothos::DType dtype(typeid(T));
+    std::cout << "Testing " << blockRegistryPath << "(" << dtype.name() << ") packed and count..." << std::endl;
+
+    static constexpr size_t NumRepeats = 3;
+    const size_t numInputs = inputs.elements() * NumRepeats;
+
+    Pothos::BufferChunk repeatedInputs(dtype, numInputs);
+    std::vector<std::int8_t> repeatedFlags;
+    for(size_t repeat = 0; repeat < NumRepeats; ++repeat)
+    {
+        std::memcpy(
+            reinterpret_cast<void*>(repeatedInputs.address + (repeat * inputs.length)),
+            inputs.as<const void*>(),
+            inputs.length);
+        repeatedFlags.insert(
+            repeatedFlags.end(),
+            expectedFlags.as<const std::int8_t*>(),
+            expectedFlags.as<const std::int8_t*>() + expectedFlags.elements());
+    }
+
+    std::vector<std::uint8_t> expectedPacked(numInputs / 8, 0);
+    for(size_t elem = 0; elem < (expectedPacked.size() * 8); ++elem)
+    {
+        expectedPacked[elem / 8] |= std::uint8_t(repeatedFlags[elem] << (elem % 8));
+    }
+    const auto expectedCount = size_t(std::count(repeatedFlags.begin(), repeatedFlags.end(), 1));
+
+    auto feederSource = Pothos::BlockRegistry::make("/blocks/feeder_source", dtype);
+    auto packedBlock = Pothos::BlockRegistry::make(blockRegistryPath, dtype);
+    packedBlock.call("setMode", "PACKED");
+    POTHOS_TEST_EQUAL("PACKED", packedBlock.call<std::string>("mode"));
+    auto countBlock = Pothos::BlockRegistry::make(blockRegistryPath, dtype);
+    countBlock.call("setMode", "COUNT");
+    auto packedCollectorSink = Pothos::BlockRegistry::make("/blocks/collector_sink", "int8");
+    auto countCollectorSink = Pothos::BlockRegistry::make("/blocks/collector_sink", "int8");
+
+    feederSource.call("feedBuffer", repeatedInputs);
+
+    // One label within a packed group, and one that spans two groups.
+    const size_t lastGroup = (numInputs / 8) - 1;
+    feederSource.call("feedLabel", Pothos::Label("inGroup", 0, 3));
+    feederSource.call("feedLabel", Pothos::Label("spanning", 0, (lastGroup * 8) - 3, 6));
+
+    {
+        Pothos::Topology topology;
+
+        topology.connect(
+            feederSource, 0,
+            packedBlock, 0);
+        topology.connect(
+            packedBlock, 0,
+            packedCollectorSink, 0);
+        topology.connect(
+            feederSource, 0,
+            countBlock, 0);
+        topology.connect(
+            countBlock, 0,
+            countCollectorSink, 0);
+
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive());
+    }
+
+    // The packed bits are output as int8 elements.
+    auto expectedPackedChunk = stdVectorToBufferChunk(expectedPacked);
+    expectedPackedChunk.dtype = Pothos::DType("int8");
+    compareBufferChunks<std::int8_t>(
+        expectedPackedChunk,
+        packedCollectorSink.call("getBuffer"));
+
+    // Labels move to the packed elements, and the count has none.
+    const auto packedLabels = packedCollectorSink.call<std::vector<Pothos::Label>>("getLabels");
+    POTHOS_TEST_EQUAL(2, packedLabels.size());
+    POTHOS_TEST_EQUAL("inGroup", packedLabels[0].id);
+    POTHOS_TEST_EQUAL(0, packedLabels[0].index);
+    POTHOS_TEST_EQUAL(1, packedLabels[0].width);
+    POTHOS_TEST_EQUAL("spanning", packedLabels[1].id);
+    POTHOS_TEST_EQUAL(lastGroup - 1, packedLabels[1].index);
+    POTHOS_TEST_EQUAL(2, packedLabels[1].width);
+    POTHOS_TEST_TRUE(countCollectorSink.call<std::vector<Pothos::Label>>("getLabels").empty());
+
+    const auto countMessages = countCollectorSink.call<std::vector<Pothos::Object>>("getMessages");
+    POTHOS_TEST_TRUE(!countMessages.empty());
+
+    size_t count = 0;
+    for(const auto& message: countMessages) count += message.convert<size_t>();
+    POTHOS_TEST_EQUAL(expectedCount, count);
+}
+
 template <typename T>
 static void testIsX()
 {
@@ -122,6 +221,12 @@ static void testIsX()
     testBlock<T>("/blocks/isnan", inputs, isNaNOutputs);
     testBlock<T>("/blocks/isnormal", inputs, isNormalOutputs);
     testBlock<T>("/blocks/isnegative", inputs, isNegativeOutputs);
+
+    testPackedAndCount<T>("/blocks/isfinite", inputs, isFiniteOutputs);
+    testPackedAndCount<T>("/blocks/isinf", inputs, isInfOutputs);
+    testPackedAndCount<T>("/blocks/isnan", inputs, isNaNOutputs);
+    testPackedAndCount<T>("/blocks/isnormal", inputs, isNormalOutputs);
+    testPackedAndCount<T>("/blocks/isnegative", inputs, isNegativeOutputs);
 }
 
 POTHOS_TEST_BLOCK("/blocks/tests", test_is_x)
@@ -5,6 +5,7 @@
 #include <Pothos/Testing.hpp>
 
 #include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
 #include <limits>
@@ -124,6 +125,84 @@ static void testMinMax()
         maxCollectorSink.call("getBuffer"));
 }
 
+// The index outputs follow std::minmax_element's tie-breaking.
+template <typename T>
+static void testMinMaxIndices()
+{
+    const Pothos::DType dtype(typeid(T));
+
+    std::cout << "Testing " << dtype.name() << " indices" << std::endl;
+
+    auto minmax = Pothos::BlockRegistry::make("/blocks/minmax", dtype, numInputs);
+    minmax.call("enableIndices", true);
+
+    std::vector<Pothos::Proxy> feederSources;
+    for(size_t i = 0; i < numInputs; ++i)
+    {
+        feederSources.emplace_back(Pothos::BlockRegistry::make("/blocks/feeder_source", dtype));
+    }
+
+    auto minCollectorSink = Pothos::BlockRegistry::make("/blocks/collector_sink", dtype);
+    auto maxCollectorSink = Pothos::BlockRegistry::make("/blocks/collector_sink", dtype);
+    auto argMinCollectorSink = Pothos::BlockRegistry::make("/blocks/collector_sink", "uint32");
+    auto argMaxCollectorSink = Pothos::BlockRegistry::make("/blocks/collector_sink", "uint32");
+
+    std::vector<Pothos::BufferChunk> inputs;
+    Pothos::BufferChunk expectedMinOutputs;
+    Pothos::BufferChunk expectedMaxOutputs;
+    getTestParams<T>(
+        &inputs,
+        &expectedMinOutputs,
+        &expectedMaxOutputs);
+    POTHOS_TEST_EQUAL(numInputs, inputs.size());
+
+    std::vector<std::uint32_t> argMinOutputVec(inputs[0].elements());
+    std::vector<std::uint32_t> argMaxOutputVec(inputs[0].elements());
+    for(size_t elem = 0; elem < argMinOutputVec.size(); ++elem)
+    {
+        std::vector<T> elems;
+        for(const auto& input: inputs) elems.emplace_back(input.as<const T*>()[elem]);
+        auto minmaxElems = std::minmax_element(elems.begin(), elems.end());
+
+        argMinOutputVec[elem] = std::uint32_t(minmaxElems.first - elems.begin());
+        argMaxOutputVec[elem] = std::uint32_t(minmaxElems.second - elems.begin());
+    }
+
+    {
+        Pothos::Topology topology;
+        for(size_t chanIn = 0; chanIn < numInputs; ++chanIn)
+        {
+            feederSources[chanIn].call("feedBuffer", inputs[chanIn]);
+            topology.connect(feederSources[chanIn], 0, minmax, chanIn);
+        }
+
+        topology.connect(minmax, "min", minCollectorSink, 0);
+        topology.connect(minmax, "max", maxCollectorSink, 0);
+        topology.connect(minmax, "argmin", argMinCollectorSink, 0);
+        topology.connect(minmax, "argmax", argMaxCollectorSink, 0);
+
+        topology.commit();
+        POTHOS_TEST_TRUE(topology.waitInactive(0.01));
+    }
+
+    std::cout << " * Checking min..." << std::endl;
+    compareBufferChunks<T>(
+        expectedMinOutputs,
+        minCollectorSink.call("getBuffer"));
+    std::cout << " * Checking max..." << std::endl;
+    compareBufferChunks<T>(
+        expectedMaxOutputs,
+        maxCollectorSink.call("getBuffer"));
+    std::cout << " * Checking argmin..." << std::endl;
+    compareBufferChunks<std::uint32_t>(
+        stdVectorToBufferChunk(argMinOutputVec),
+        argMinCollectorSink.call("getBuffer"));
+    std::cout << " * Checking argmax..." << std::endl;
+    compareBufferChunks<std::uint32_t>(
+        stdVectorToBufferChunk(argMaxOutputVec),
+        argMaxCollectorSink.call("getBuffer"));
+}
+
 POTHOS_TEST_BLOCK("/blocks/tests", test_minmax)
 {
     testMinMax<std::int8_t>();
@@ -137,3 +216,17 @@ POTHOS_TEST_BLOCK("/blocks/tests", test_minmax)
     testMinMax<float>();
     testMinMax<double>();
 }
+
+POTHOS_TEST_BLOCK("/blocks/tests", test_minmax_indices)
+{
+    testMinMaxIndices<std::int8_t>();
+    testMinMaxIndices<std::int16_t>();
+    testMinMaxIndices<std::int32_t>();
+    testMinMaxIndices<std::int64_t>();
+    testMinMaxIndices<std::uint8_t>();
+    testMinMaxIndices<std::uint16_t>();
+    testMinMaxIndices<std::uint32_t>();
+    testMinMaxIndices<std::uint64_t>();
+    testMinMaxIndices<float>();
+    testMinMaxIndices<double>();
+}
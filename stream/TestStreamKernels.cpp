@@ -0,0 +1,241 @@
+// Copyright (c) 2020 Nicholas Corgan
+// SPDX-License-Identifier: BSL-1.0
+
+#include "StreamKernels.hpp"
+
+#include <Pothos/Framework.hpp>
+#include <Pothos/Testing.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+// An odd length exercises each variant's remainder loop.
+static constexpr size_t NumElems = 1037;
+
+template <typename T>
+static std::vector<T> getRandomInputs()
+{
+    static std::mt19937 gen(0);
+    std::uniform_int_distribution<int> dist(0, 100);
+
+    std::vector<T> inputs(NumElems);
+    for(auto& input: inputs) input = static_cast<T>(dist(gen));
+
+    return inputs;
+}
+
+template <typename T>
+static void testKernels(StreamISA isa)
+{
+    const auto& scalarKernels = getStreamKernels<T>(StreamISA::Scalar);
+    const auto& kernels = getStreamKernels<T>(isa);
+
+    const auto inputs0 = getRandomInputs<T>();
+    const auto inputs1 = getRandomInputs<T>();
+
+    std::vector<T> expected(NumElems);
+    std::vector<T> actual(NumElems);
+
+    scalarKernels.clamp(inputs0.data(), expected.data(), NumElems, 25, 75);
+    kernels.clamp(inputs0.data(), actual.data(), NumElems, 25, 75);
+    POTHOS_TEST_EQUALV(expected, actual);
+
+    scalarKernels.clampLow(inputs0.data(), expected.data(), NumElems, 25);
+    kernels.clampLow(inputs0.data(), actual.data(), NumElems, 25);
+    POTHOS_TEST_EQUALV(expected, actual);
+
+    scalarKernels.clampHigh(inputs0.data(), expected.data(), NumElems, 75);
+    kernels.clampHigh(inputs0.data(), actual.data(), NumElems, 75);
+    POTHOS_TEST_EQUALV(expected, actual);
+
+    size_t expectedLow = 0, expectedHigh = 0;
+    size_t actualLow = 0, actualHigh = 0;
+    scalarKernels.clampCount(inputs0.data(), expected.data(), NumElems, 25, 75, &expectedLow, &expectedHigh);
+    kernels.clampCount(inputs0.data(), actual.data(), NumElems, 25, 75, &actualLow, &actualHigh);
+    POTHOS_TEST_EQUALV(expected, actual);
+    POTHOS_TEST_EQUAL(expectedLow, actualLow);
+    POTHOS_TEST_EQUAL(expectedHigh, actualHigh);
+    POTHOS_TEST_TRUE(expectedLow > 0);
+    POTHOS_TEST_TRUE(expectedHigh > 0);
+
+    expected = inputs1;
+    actual = inputs1;
+    scalarKernels.min(inputs0.data(), expected.data(), NumElems);
+    kernels.min(inputs0.data(), actual.data(), NumElems);
+    POTHOS_TEST_EQUALV(expected, actual);
+
+    expected = inputs1;
+    actual = inputs1;
+    scalarKernels.max(inputs0.data(), expected.data(), NumElems);
+    kernels.max(inputs0.data(), actual.data(), NumElems);
+    POTHOS_TEST_EQUALV(expected, actual);
+
+    // The random inputs have plenty of ties, which must resolve the same
+    // way as the plain min/max.
+    std::vector<std::uint32_t> expectedIndices(NumElems, 0);
+    std::vector<std::uint32_t> actualIndices(NumElems, 0);
+    expected = inputs1;
+    actual = inputs1;
+    scalarKernels.argMin(inputs0.data(), expected.data(), expectedIndices.data(), 1, NumElems);
+    kernels.argMin(inputs0.data(), actual.data(), actualIndices.data(), 1, NumElems);
+    POTHOS_TEST_EQUALV(expected, actual);
+    POTHOS_TEST_EQUALV(expectedIndices, actualIndices);
+    for(size_t elem = 0; elem < NumElems; ++elem)
+    {
+        POTHOS_TEST_EQUAL((inputs0[elem] < inputs1[elem]) ? 1U : 0U, actualIndices[elem]);
+    }
+
+    std::fill(expectedIndices.begin(), expectedIndices.end(), 0);
+    std::fill(actualIndices.begin(), actualIndices.end(), 0);
+    expected = inputs1;
+    actual = inputs1;
+    scalarKernels.argMax(inputs0.data(), expected.data(), expectedIndices.data(), 1, NumElems);
+    kernels.argMax(inputs0.data(), actual.data(), actualIndices.data(), 1, NumElems);
+    POTHOS_TEST_EQUALV(expected, actual);
+    POTHOS_TEST_EQUALV(expectedIndices, actualIndices);
+    for(size_t elem = 0; elem < NumElems; ++elem)
+    {
+        POTHOS_TEST_EQUAL((inputs1[elem] < inputs0[elem]) ? 0U : 1U, actualIndices[elem]);
+    }
+}
+
+template <typename T>
+static void testFloatKernels(StreamISA isa)
+{
+    const std::vector<T> specialValues =
+    {
+        T(0.0),
+        T(-0.0),
+        T(1.0),
+        T(-1.0),
+        std::numeric_limits<T>::min(),
+        std::numeric_limits<T>::denorm_min(),
+        -std::numeric_limits<T>::denorm_min(),
+        std::numeric_limits<T>::max(),
+        std::numeric_limits<T>::infinity(),
+        -std::numeric_limits<T>::infinity(),
+        std::numeric_limits<T>::quiet_NaN(),
+        -std::numeric_limits<T>::quiet_NaN()
+    };
+    std::vector<T> inputs;
+    while(inputs.size() < NumElems) inputs.insert(inputs.end(), specialValues.begin(), specialValues.end());
+
+    const auto& scalarKernels = getStreamFloatKernels<T>(StreamISA::Scalar);
+    const auto& kernels = getStreamFloatKernels<T>(isa);
+
+    std::vector<std::int8_t> expected(inputs.size());
+    std::vector<std::int8_t> actual(inputs.size());
+
+    const size_t numBytes = (inputs.size() + 7) / 8;
+    std::vector<std::uint8_t> expectedPacked(numBytes);
+    std::vector<std::uint8_t> actualPacked(numBytes);
+
+    #define testFloatKernel(kernel) \
+        scalarKernels.kernel.flags(inputs.data(), expected.data(), inputs.size()); \
+        kernels.kernel.flags(inputs.data(), actual.data(), inputs.size()); \
+        POTHOS_TEST_EQUALV(expected, actual); \
+        scalarKernels.kernel.packed(inputs.data(), expectedPacked.data(), inputs.size()); \
+        kernels.kernel.packed(inputs.data(), actualPacked.data(), inputs.size()); \
+        POTHOS_TEST_EQUALV(expectedPacked, actualPacked); \
+        for(size_t elem = 0; elem < inputs.size(); ++elem) \
+        { \
+            POTHOS_TEST_EQUAL(int(expected[elem]), (actualPacked[elem / 8] >> (elem % 8)) & 1); \
+        } \
+        POTHOS_TEST_EQUAL( \
+            size_t(std::count(expected.begin(), expected.end(), 1)), \
+            kernels.kernel.count(inputs.data(), inputs.size()));
+
+    testFloatKernel(isFinite)
+    testFloatKernel(isInf)
+    testFloatKernel(isNaN)
+    testFloatKernel(isNormal)
+    testFloatKernel(isNegative)
+}
+
+static void testCopyKernels(StreamISA isa)
+{
+    const auto& scalarKernels = getStreamCopyKernels(StreamISA::Scalar);
+    const auto& kernels = getStreamCopyKernels(isa);
+
+    for(size_t elemSize: {1, 2, 3, 4, 8, 16})
+    {
+        const auto inputs = getRandomInputs<std::uint8_t>();
+        const size_t numElems = inputs.size() / elemSize;
+
+        for(size_t count: {1, 2, 3, 4})
+        {
+            std::vector<std::uint8_t> expected(numElems * elemSize * count);
+            std::vector<std::uint8_t> actual(expected.size());
+
+            scalarKernels.repeat(inputs.data(), expected.data(), numElems, elemSize, count);
+            kernels.repeat(inputs.data(), actual.data(), numElems, elemSize, count);
+            POTHOS_TEST_EQUALV(expected, actual);
+
+            // Buffers are not guaranteed to be aligned to the element size.
+            std::vector<std::uint8_t> unaligned(expected.size() + 1);
+            kernels.repeat(inputs.data() + 1, unaligned.data() + 1, numElems - 1, elemSize, count);
+            scalarKernels.repeat(inputs.data() + 1, expected.data(), numElems - 1, elemSize, count);
+            POTHOS_TEST_EQUALA(expected.data(), unaligned.data() + 1, (numElems - 1) * elemSize * count);
+        }
+
+        for(size_t numChans: {2, 3, 4, 8})
+        {
+            const size_t numChunks = numElems / numChans;
+
+            std::vector<const void*> buffsIn;
+            for(size_t chan = 0; chan < numChans; ++chan)
+            {
+                buffsIn.emplace_back(inputs.data() + chan * numChunks * elemSize);
+            }
+
+            std::vector<std::uint8_t> expected(numChunks * numChans * elemSize);
+            std::vector<std::uint8_t> actual(expected.size());
+            scalarKernels.interleave(buffsIn.data(), numChans, expected.data(), numChunks, elemSize);
+            kernels.interleave(buffsIn.data(), numChans, actual.data(), numChunks, elemSize);
+            POTHOS_TEST_EQUALV(expected, actual);
+
+            // Deinterleaving recovers the original channels.
+            std::vector<std::uint8_t> deinterleaved(expected.size());
+            std::vector<void*> buffsOut;
+            for(size_t chan = 0; chan < numChans; ++chan)
+            {
+                buffsOut.emplace_back(deinterleaved.data() + chan * numChunks * elemSize);
+            }
+            kernels.deinterleave(actual.data(), buffsOut.data(), numChans, numChunks, elemSize);
+            POTHOS_TEST_EQUALA(inputs.data(), deinterleaved.data(), deinterleaved.size());
+        }
+    }
+}
+
+POTHOS_TEST_BLOCK("/blocks/tests", test_stream_kernels)
+{
+    std::cout << "Selected: " << streamISAToString(getStreamISA()) << std::endl;
+
+    for(auto isa: getSupportedStreamISAs())
+    {
+        std::cout << "Testing " << streamISAToString(isa) << std::endl;
+        POTHOS_TEST_EQUAL(
+            streamISAToString(isa),
+            streamISAToString(streamISAFromString(streamISAToString(isa))));
+
+        testKernels<std::int8_t>(isa);
+        testKernels<std::int16_t>(isa);
+        testKernels<std::int32_t>(isa);
+        testKernels<std::int64_t>(isa);
+        testKernels<std::uint8_t>(isa);
+        testKernels<std::uint16_t>(isa);
+        testKernels<std::uint32_t>(isa);
+        testKernels<std::uint64_t>(isa);
+        testKernels<float>(isa);
+        testKernels<double>(isa);
+
+        testFloatKernels<float>(isa);
+        testFloatKernels<double>(isa);
+
+        testCopyKernels(isa);
+    }
+}